@@ -24,6 +24,13 @@ class BinaryOperatorNode : public ExpressionNode {
     ExpressionNode *getRightOperand() const {
         return m_right_operand;
     }
+    /// @brief Replaces an operand (see ConstantFolder); the old one is not deleted.
+    void setLeftOperand(ExpressionNode *p_operand) {
+        m_left_operand = p_operand;
+    }
+    void setRightOperand(ExpressionNode *p_operand) {
+        m_right_operand = p_operand;
+    }
     OperatorType getOperator() const {
         return m_operator;
     }
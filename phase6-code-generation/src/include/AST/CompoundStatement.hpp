@@ -6,6 +6,9 @@
 #include "AST/decl.hpp"
 #include "visitor/AstNodeVisitor.hpp"
 
+#include <utility>
+#include <vector>
+
 class CompoundStatementNode : public AstNode {
    public:
     CompoundStatementNode(const uint32_t line, const uint32_t col,
@@ -25,6 +28,10 @@ class CompoundStatementNode : public AstNode {
     const std::vector<AstNode *> &getStatements() const {
         return m_statements;
     }
+    /// @brief Replaces the statements (see DeadCodeEliminator); the old ones are not deleted.
+    void setStatements(std::vector<AstNode *> p_statements) {
+        m_statements = std::move(p_statements);
+    }
 
    private:
     // hw3 work: declarations, statements
@@ -0,0 +1,58 @@
+#ifndef AST_CONSTANT_FOLDER_H
+#define AST_CONSTANT_FOLDER_H
+
+#include "visitor/AstNodeVisitor.hpp"
+
+class ExpressionNode;
+
+/**
+ * Folds constant subexpressions of a semantically checked AST in place.
+ *
+ * A constant subtree is evaluated the same way the generated code would:
+ *   - integers wrap around at 32 bits,
+ *   - reals are single-precision, and an integer operand is first converted by
+ *     `fcvt.s.w` (integer + real => real),
+ *   - a division/mod by integer zero is left to run time.
+ * Besides, the identities x * 1, 1 * x, x + 0, 0 + x, x - 0, x / 1 and x * 0 (integers only,
+ * and x * 0 only if x calls no function), `not not b` and `- -x` are applied.
+ *
+ * A reference to a constant (see VariableReferenceNode::getConstant) is replaced by its value
+ * first, so that it folds like a literal, and the constant itself is no longer needed at run
+ * time.
+ *
+ * A folded node is deleted and replaced by a new ConstantValueNode (or the surviving operand)
+ * in its parent.
+ */
+class ConstantFolder final : public AstNodeVisitor {
+  private:
+    /// the node that takes the place of the last visited expression, nullptr if it stays
+    ExpressionNode *m_replacement = nullptr;
+
+    /// @return the expression that takes the place of `p_expr` (`p_expr` itself if it stays)
+    ExpressionNode *fold(ExpressionNode *p_expr);
+
+  public:
+    ~ConstantFolder() = default;
+    ConstantFolder() = default;
+
+    void visit(ProgramNode &p_program) override;
+    void visit(DeclNode &p_decl) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+};
+
+/// @return whether evaluating the expression may call a function (and thus print/read)
+bool mayCallFunction(const ExpressionNode *expr);
+
+#endif
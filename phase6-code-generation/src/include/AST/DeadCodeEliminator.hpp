@@ -0,0 +1,72 @@
+#ifndef AST_DEAD_CODE_ELIMINATOR_H
+#define AST_DEAD_CODE_ELIMINATOR_H
+
+#include "sema/SemanticAnalyzer.hpp"
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+
+class AssignmentNode;
+class AstNode;
+class CompoundStatementNode;
+
+/**
+ * Removes the statements of a semantically checked (and constant-folded) AST that never run or
+ * whose effect is never seen:
+ *   - the statements after a `return` (or after an `if` whose both arms return) in the same
+ *     compound statement,
+ *   - an `if` with a constant condition, which is replaced by the arm that runs, and a `while`
+ *     whose condition is constantly false,
+ *   - an assignment to a local scalar that is never read in its function, unless the value
+ *     calls a function (which may print or read).
+ * The declarations are kept, as the semantic analyzer has laid out the frame already.
+ *
+ * The symbol tables are borrowed like IrBuilder does, to tell apart variables of the same name.
+ */
+class DeadCodeEliminator final : public AstNodeVisitor {
+  private:
+    using SymbolTableMap = std::unordered_map<SemanticAnalyzer::AstNodeAddr, SymbolManager::Table>;
+
+    SymbolManager m_symbol_manager;
+    SymbolTableMap &m_symbol_table_of_scoping_nodes;
+
+    /// the locals of the function being visited that it reads somewhere
+    std::unordered_set<const SymbolEntry *> m_read_locals;
+    /// whether statements are being removed, or the reads are being collected first
+    bool m_removing = false;
+
+    void pushScope(const AstNode *node);
+    void popScope(const AstNode *node);
+    /// @brief Collects the reads of the body of a function (or of the program), then removes.
+    void eliminateIn(CompoundStatementNode &p_body, bool upperIsFunction);
+    bool isDeadStore(AssignmentNode &p_assignment);
+    /**
+     * @return what takes the place of `stmt` in its compound statement (`stmt` itself, or an arm
+     *         of an `if`), nullptr if it is removed; a node left out is deleted
+     */
+    AstNode *simplify(AstNode *stmt);
+
+  public:
+    ~DeadCodeEliminator() = default;
+    explicit DeadCodeEliminator(SymbolTableMap &p_symbol_table_of_scoping_nodes)
+        : m_symbol_table_of_scoping_nodes(p_symbol_table_of_scoping_nodes) {}
+
+    void visit(ProgramNode &p_program) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+};
+
+#endif
@@ -24,6 +24,10 @@ class FunctionInvocationNode : public ExpressionNode {
     const std::vector<ExpressionNode *> &getArguments() const {
         return m_arguments;
     }
+    /// @brief Replaces an argument (see ConstantFolder); the old one is not deleted.
+    void setArgument(size_t index, ExpressionNode *p_expression) {
+        m_arguments[index] = p_expression;
+    }
 
    private:
     // hw3 work: function name, expressions
@@ -22,6 +22,10 @@ class UnaryOperatorNode : public ExpressionNode {
     ExpressionNode *getOperand() const {
         return m_expression;
     }
+    /// @brief Replaces the operand (see ConstantFolder); the old one is not deleted.
+    void setOperand(ExpressionNode *p_expression) {
+        m_expression = p_expression;
+    }
 
     void determineTypeOfResult() override;
 
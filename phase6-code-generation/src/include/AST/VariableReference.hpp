@@ -1,8 +1,10 @@
 #ifndef __AST_VARIABLE_REFERENCE_NODE_H
 #define __AST_VARIABLE_REFERENCE_NODE_H
 
+#include "AST/ConstantValue.hpp"
 #include "AST/expression.hpp"
 #include "visitor/AstNodeVisitor.hpp"
+#include <memory>
 #include <string>
 
 class VariableReferenceNode : public ExpressionNode {
@@ -28,6 +30,14 @@ class VariableReferenceNode : public ExpressionNode {
     }
     const std::vector<ExpressionNode *> &getIndices() const;
     void addInnerIndex(ExpressionNode *p_index);
+    /// @brief Replaces an index (see ConstantFolder); the old one is not deleted.
+    void setIndex(size_t index, ExpressionNode *p_index);
+    /// @brief Records the value of the constant referred to (see SemanticAnalyzer).
+    void setConstant(const ConstVal &p_constant);
+    /// @return the value of the constant referred to, nullptr if it is not a constant
+    const ConstVal *getConstant() const {
+        return m_constant.get();
+    }
 
    private:
     // hw3 work: variable name, expressions
@@ -39,6 +49,7 @@ class VariableReferenceNode : public ExpressionNode {
      *    m_indices = {Expr<1>, Expr<5>};
      */
     std::vector<ExpressionNode *> m_indices;
+    std::unique_ptr<ConstVal> m_constant;
 };
 
 #endif
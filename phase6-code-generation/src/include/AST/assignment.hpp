@@ -18,12 +18,16 @@ class AssignmentNode : public AstNode {
     }
     void visitChildNodes(AstNodeVisitor &p_visitor) override;
 
-    const VariableReferenceNode *getVarRef() {
+    VariableReferenceNode *getVarRef() {
         return m_left_val;
     }
     ExpressionNode *getExpression() {
         return m_expression;
     }
+    /// @brief Replaces the expression (see ConstantFolder); the old one is not deleted.
+    void setExpression(ExpressionNode *p_expression) {
+        m_expression = p_expression;
+    }
 
    private:
     // hw3 work: variable reference, expression
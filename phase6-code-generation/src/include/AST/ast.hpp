@@ -70,6 +70,15 @@ struct Type {
      */
     bool isSameType(const Type &t2) const;
     std::string typeToString() const;
+    /**
+     * Every scalar takes 4 bytes, and an array is laid out in row-major order: a[i][j] is
+     * right after a[i][j - 1], and a[i] is a contiguous sub-array.
+     *
+     * @return the bytes an object of this type takes
+     */
+    int getSizeInBytes() const;
+    /// @return the bytes between consecutive elements of dimension `dim` (0: the outermost)
+    int getStrideOf(size_t dim) const;
 };
 enum class OperatorType {
     /* Binary op */
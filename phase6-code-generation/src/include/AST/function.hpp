@@ -31,6 +31,10 @@ class FunctionNode : public AstNode {
         return m_returnType;
     }
     void setCompoundStatement(CompoundStatementNode *p_compoundStatementNode);
+    /// @return nullptr if the function is only declared (e.g. defined in C)
+    CompoundStatementNode *getBody() const {
+        return m_compound_statement;
+    }
 
    private:
     // hw3 work: name, declarations, return type, compound statement
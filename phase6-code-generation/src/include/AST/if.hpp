@@ -21,12 +21,21 @@ class IfNode : public AstNode {
     ExpressionNode *getCondition() const {
         return m_condition;
     }
+    /// @brief Replaces the condition (see ConstantFolder); the old one is not deleted.
+    void setCondition(ExpressionNode *p_condition) {
+        m_condition = p_condition;
+    }
     CompoundStatementNode *getBody() const {
         return m_body;
     }
     CompoundStatementNode *getElseBody() const {
         return m_body_of_else;
     }
+    /// @brief Replaces the bodies (see DeadCodeEliminator); the old ones are not deleted.
+    void setBodies(CompoundStatementNode *p_body, CompoundStatementNode *p_bodyOfElse) {
+        m_body = p_body;
+        m_body_of_else = p_bodyOfElse;
+    }
 
    private:
     // hw3 work: expression, compound statement, compound statement
@@ -18,6 +18,8 @@ class PrintNode : public AstNode {
     void visitChildNodes(AstNodeVisitor &p_visitor) override;
 
     const ExpressionNode *getExpression() const;
+    /// @brief Replaces the expression (see ConstantFolder); the old one is not deleted.
+    void setExpression(ExpressionNode *p_expression);
 
    private:
     // hw3 work: expression
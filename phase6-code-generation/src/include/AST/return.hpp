@@ -20,6 +20,10 @@ class ReturnNode : public AstNode {
     const ExpressionNode *getReturnVal() {
         return m_return_val;
     }
+    /// @brief Replaces the expression (see ConstantFolder); the old one is not deleted.
+    void setReturnVal(ExpressionNode *p_returnVal) {
+        m_return_val = p_returnVal;
+    }
 
    private:
     // hw3 work: expression
@@ -21,6 +21,10 @@ class WhileNode : public AstNode {
     ExpressionNode *getCondition() const {
         return m_condition;
     }
+    /// @brief Replaces the condition (see ConstantFolder); the old one is not deleted.
+    void setCondition(ExpressionNode *p_condition) {
+        m_condition = p_condition;
+    }
     CompoundStatementNode *getBody() const {
         return m_body;
     }
@@ -1,14 +1,25 @@
 #ifndef CODEGEN_CODE_GENERATOR_H
 #define CODEGEN_CODE_GENERATOR_H
 
+#include "codegen/ConstantPool.hpp"
 #include "sema/SemanticAnalyzer.hpp"
 #include "sema/SymbolTable.hpp"
+#include "util/CompilerOptions.hpp"
 #include "visitor/AstNodeVisitor.hpp"
 
 #include <cstdio>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+/// @return "<save_path>/<name of the source file>.S"
+std::string getAssemblyFilePath(const std::string &source_file_name, const std::string &save_path);
+/// @brief Opens "<save_path>/<name of the source file>.S" for writing.
+FILE *openAssemblyFile(const std::string &source_file_name, const std::string &save_path);
+
+/// @brief The operand of the directive (.word/.float/.string) that holds the constant.
+std::string getImmediateInString(const ConstVal &constVal);
 
 class CodeGenerator final : public AstNodeVisitor {
    private:
@@ -16,8 +27,11 @@ class CodeGenerator final : public AstNodeVisitor {
     std::string m_source_file_path;
     std::unordered_map<SemanticAnalyzer::AstNodeAddr, SymbolManager::Table>
         m_symbol_table_of_scoping_nodes;
+    const CompilerOptions &m_options;
     /// NOTE: `FILE` cannot be simply deleted by `delete`, so we need a custom deleter.
     std::unique_ptr<FILE, decltype(&fclose)> m_output_file{nullptr, &fclose};
+    /// the real and string literals, emitted after main
+    ConstantPool m_constant_pool;
 
     /**
      * the next usable Label for if, while, for
@@ -26,11 +40,112 @@ class CodeGenerator final : public AstNodeVisitor {
      */
     int nextL;
 
+    /// the size of the frame of the function being generated (see SymbolTable::sizeOfLocals)
+    int m_frame_size = 0;
+    /// the label of the epilogue of the function being generated, shared by its returns
+    int m_epilogue_label = 0;
+    /// whether the function being generated skips saving ra (see --omit-frame-pointer)
+    bool m_skips_ra = false;
+    /// the function being generated, nullptr for the main program
+    const FunctionNode *m_function = nullptr;
+    /// the symbols of its parameters, in order
+    std::vector<const SymbolEntry *> m_params;
+    /// the label right after its parameters are saved, 0 if it never calls itself
+    int m_body_label = 0;
+
+    /// the number of registers s1, s2, ... the function being generated saves for loop counters
+    int m_num_counter_regs = 0;
+    /// the number of for loops around the current node whose counter is in a register
+    int m_counter_depth = 0;
+    /// whether the body of each for loop of the function reads its loop variable
+    std::unordered_map<const ForNode *, bool> m_loop_reads_counter;
+    /// the loop variables in s<n> right now
+    std::unordered_map<const SymbolEntry *, int> m_counter_reg_of_loop_var;
+    /// the parameters kept in a<n> (or fa<n> for a real), as no call comes before their last use
+    std::unordered_map<const SymbolEntry *, int> m_arg_reg_of_param;
+
+    /**
+     * Sizes the frame for `sizeOfLocals` bytes of locals and the registers saved for the loop
+     * counters of `p_body`.
+     */
+    void planFrame(CompoundStatementNode &p_body, int sizeOfLocals);
+    /**
+     * Allocates the frame, and saves ra, s0 and the counter registers. A frame too large for the
+     * offsets from sp to fit in 12 bits has them saved from its top instead.
+     */
+    void allocateFrame();
+    /// @brief Restores what allocateFrame() saved and frees the frame, up to the jump back.
+    void freeFrame();
+    void saveCounterRegs();
+    void restoreCounterRegs();
+    /**
+     * Pushes the address of what `p_variable_ref` refers to: the variable, or the element (or
+     * sub-array, for fewer indices than dimensions) its indices select, in row-major order,
+     * from the start of the array (or the address an array parameter holds).
+     * Literal indices are folded into the offset; any other is scaled by the stride of its
+     * dimension, with a shift if it is a power of 2.
+     */
+    void pushAddressOf(VariableReferenceNode &p_variable_ref, const SymbolEntry *entry);
+    /**
+     * Generates a for loop with its counter in s<depth>, tested at the bottom. The body reads
+     * the loop variable from there; if it never does, the register counts the iterations down
+     * to 0 instead, and the loop ends with a `bnez`.
+     */
+    void generateCountedLoop(ForNode &p_for, const SymbolEntry *loopVarEntry);
+
+    /// @brief Pops the operands (the right one on top) into ft1 and ft0, converting integers.
+    void popFloatOperands(bool leftOperandIsReal, bool rightOperandIsReal);
+    /**
+     * Evaluates a boolean expression as control flow: jumps to `.L<p_label>` if its value is
+     * `p_jumps_if_true`, and falls through otherwise.
+     *   - a comparison branches on its operands (`blt`, `bge`, ..., or `flt.s` etc. and a
+     *     branch on the result for reals) instead of pushing 0/1 first,
+     *   - `and`/`or` skip the right operand once the left one decides,
+     *   - `not` flips `p_jumps_if_true`.
+     */
+    void generateBranch(ExpressionNode *p_condition, int p_label, bool p_jumps_if_true);
+    /**
+     * Generates an integer `*`, `/` or `mod` by a constant as a reduced sequence on t0 (see
+     * reduceByConstant), visiting only the other operand.
+     * @return false if it is not one or no sequence is cheaper, with nothing generated
+     */
+    bool generateByConstant(BinaryOperatorNode &p_bin_op);
+    /**
+     * Generates an integer (or boolean) binary operator by the cheapest rule of
+     * codegen/TreePatterns.hpp, e.g. `addi t0, t1, 5` for `x + 5`: a constant operand is neither
+     * pushed nor popped.
+     */
+    void generateByPattern(BinaryOperatorNode &p_bin_op);
+    /// @return whether `p_arg` is loaded straight into where it is passed (see loadArgument)
+    bool isDirectArgument(ExpressionNode *p_arg);
+    /**
+     * Loads a direct argument (a literal or a local scalar) into `p_reg`, converted to a real
+     * if `p_to_real` and it is an integer.
+     */
+    void loadArgument(ExpressionNode *p_arg, bool p_to_real, const char *p_reg);
+    /**
+     * Evaluates the arguments for calling a function taking `typesOfParam` and sets their
+     * registers, leaving the stack arguments on top of the stack.
+     * The arguments are pushed in order, but for the direct ones, which are loaded last: they
+     * have no side effect, and no call can change them.
+     * An integer argument `args[i]` of a real parameter is converted.
+     * @return the bytes to pop after the call: the stack arguments and the pushed ones
+     */
+    int passArguments(const std::vector<Type> &typesOfParam,
+                      const std::vector<ExpressionNode *> &args);
+    /**
+     * Generates `return f(...)` as a jump to f, reusing the frame: a call to the function
+     * itself assigns the parameters and jumps back to its body.
+     * @return false if the return is not a tail call, with nothing generated
+     */
+    bool generateTailCall(ReturnNode &p_return);
+
    public:
     ~CodeGenerator() = default;
     CodeGenerator(const std::string &source_file_name, const std::string &save_path,
                   std::unordered_map<SemanticAnalyzer::AstNodeAddr, SymbolManager::Table>
-                      &&p_symbol_table_of_scoping_nodes);
+                      &&p_symbol_table_of_scoping_nodes,
+                  const CompilerOptions &p_options);
 
     int getNextL() const {
         return nextL;
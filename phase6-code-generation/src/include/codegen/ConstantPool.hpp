@@ -0,0 +1,43 @@
+#ifndef CODEGEN_CONSTANT_POOL_H
+#define CODEGEN_CONSTANT_POOL_H
+
+#include "AST/ConstantValue.hpp"
+#include "ir/IR.hpp"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The real and string literals of a module, shared by both code generators.
+ *
+ * Each literal is given a label .LC<n> the first time it is used, and identical literals share
+ * it. The pool is emitted once, at the end of the file, so no jump over inline data is needed:
+ *   - reals to .rodata,
+ *   - strings to the mergeable .rodata.str1.1, where the linker may merge them with identical
+ *     strings of other files as well.
+ */
+class ConstantPool {
+   public:
+    /// @return the label of the real or string `literal`
+    const std::string &getLabelOf(const ConstVal &literal);
+    /// @return the label of the FLOAT or STRING `literal` of the IR
+    const std::string &getLabelOf(const IrValue &literal);
+
+    void dump(FILE *p_out_file) const;
+
+   private:
+    struct Literal {
+        std::string label;
+        /// the operand of .float/.string
+        std::string data;
+    };
+    std::vector<Literal> m_reals;
+    std::vector<Literal> m_strings;
+    /// index into m_reals/m_strings by data
+    std::unordered_map<std::string, size_t> m_index_of_real;
+    std::unordered_map<std::string, size_t> m_index_of_string;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef CODEGEN_INSTRUCTION_SELECTOR_H
+#define CODEGEN_INSTRUCTION_SELECTOR_H
+
+#include "codegen/ConstantPool.hpp"
+#include "codegen/MachineCode.hpp"
+#include "ir/IR.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Translates an IrFunction into machine code over virtual registers:
+ *   - each IR temporary gets a virtual register of its own,
+ *   - each IR block becomes a machine block, labeled only if it is a branch target,
+ *   - all `ret`s jump to a single epilogue block at the end, left out if only tail calls return,
+ *   - a comparison used only by the conditional branch right after it becomes a compare-and-branch,
+ *   - integer multiplication, division and remainder by a constant are strength-reduced,
+ *   - a call right before a `ret` of its result becomes a tail call (see MachineInstr::makeTailCall)
+ *     if all arguments go in registers.
+ */
+class InstructionSelector {
+   public:
+    /// @param p_next_label the next usable number of .L labels of the module
+    /// @param p_constant_pool where the real/string literals used by the function go
+    /// @param p_tail_calls whether to select tail calls (see CompilerOptions::tailCalls)
+    /// @param p_strength_reduction whether to reduce `*`, `/` and `mod` by constants
+    ///        (see CompilerOptions::strengthReduction)
+    InstructionSelector(const IrFunction &p_function, int &p_next_label,
+                        ConstantPool &p_constant_pool, bool p_tail_calls,
+                        bool p_strength_reduction)
+        : m_ir(p_function),
+          m_next_label(p_next_label),
+          m_constant_pool(p_constant_pool),
+          m_tail_calls(p_tail_calls),
+          m_strength_reduction(p_strength_reduction) {}
+
+    std::unique_ptr<MachineFunction> run();
+
+   private:
+    const IrFunction &m_ir;
+    int &m_next_label;
+    ConstantPool &m_constant_pool;
+    bool m_tail_calls;
+    bool m_strength_reduction;
+
+    std::unique_ptr<MachineFunction> m_function;
+    MachineBasicBlock *m_block = nullptr;
+    std::vector<Reg> m_reg_of_temp;
+    std::vector<int> m_use_count_of_temp;
+    std::unordered_map<const IrBasicBlock *, std::string> m_label_of_block;
+    std::unordered_map<int, int> m_frame_slot_of_slot;
+    std::string m_exit_label;
+    /// whether a `ret` has jumped to m_exit_label
+    bool m_jumps_to_exit = false;
+    /// whether the last instruction emitted may go on to the one after it
+    bool m_falls_through = true;
+    /// the IR block laid out after the one being selected
+    const IrBasicBlock *m_next_block = nullptr;
+
+    std::string newLabel();
+    void emit(MachineInstr instr);
+    /// @brief Jumps to `target` unless it is laid out right after the current block.
+    void jumpTo(const IrBasicBlock *target);
+    /// @brief Puts the value into the register `dst`.
+    void materialize(const IrValue &value, Reg dst);
+    /// @return a register holding the value
+    Reg use(const IrValue &value);
+    Reg def(const IrValue &value) const;
+    int getFrameSlotOf(int slot);
+
+    void selectParams();
+    void selectInstr(const IrInstr &instr);
+    void selectBinary(const IrInstr &instr);
+    /// @brief Selects an integer `*`, `/` or `%` by a constant as cheaper instructions, if any.
+    /// @return whether it did (see reduceByConstant)
+    bool selectByConstant(const IrInstr &instr);
+    /// @brief Selects an integer binary operator by the cheapest rule of codegen/TreePatterns.hpp.
+    void selectByPattern(const IrInstr &instr);
+    void selectMemory(const IrInstr &instr);
+    /// @brief Selects `%c = compare a, b; cbr %c, ..` as a single `b<cond>` (two instructions
+    ///        for reals), if %c is used by nothing else.
+    /// @return whether it did
+    bool selectCompareBranch(const IrInstr &compare, const IrInstr &branch);
+    /// @param isTail whether the call replaces the `ret` of its result
+    void selectCall(const IrInstr &instr, bool isTail);
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef CODEGEN_LINEAR_SCAN_ALLOCATOR_H
+#define CODEGEN_LINEAR_SCAN_ALLOCATOR_H
+
+#include "codegen/MachineCode.hpp"
+
+#include <vector>
+
+/**
+ * Linear-scan register allocation (Poletto & Sarkar) over a MachineFunction.
+ *
+ * - Each virtual register gets one live interval covering all of its definitions and uses,
+ *   computed from block-level liveness so that values live around loops stay alive.
+ * - Intervals that cross a call may only take callee-saved registers (s1 ~ s11, fs0 ~ fs11);
+ *   the others prefer the caller-saved ones (t0 ~ t4, ft0 ~ ft9). s0 is handed out last, and
+ *   only if the function omits the frame pointer.
+ * - When no register is free, the interval ending last is spilled to a frame slot.
+ *   Spilled registers are loaded into/stored from the scratch registers t5, t6, ft10, ft11
+ *   around each instruction, so these four are never handed out.
+ */
+class LinearScanAllocator {
+   public:
+    explicit LinearScanAllocator(MachineFunction &p_function) : m_function(p_function) {}
+
+    /// @brief Replaces every virtual register of the function with a physical register,
+    /// inserting spill code where needed.
+    void run();
+
+   private:
+    struct LiveInterval {
+        Reg vreg;
+        int start;
+        int end;
+        bool crossesCall = false;
+        Reg physReg = kNoReg;
+        int spillSlot = -1;
+    };
+
+    MachineFunction &m_function;
+    /// indexed by `vreg - kFirstVirtualReg`
+    std::vector<LiveInterval> m_intervals;
+
+    void computeLiveIntervals();
+    void allocateRegisters();
+    void rewriteFunction();
+};
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef CODEGEN_MACHINE_CODE_H
+#define CODEGEN_MACHINE_CODE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Register numbering shared by the machine code and the register allocator:
+ *   0  ~ 31:   integer registers x0 ~ x31
+ *   32 ~ 63:   floating-point registers f0 ~ f31
+ *   64 ~  :    virtual registers (the class is recorded in MachineFunction)
+ */
+using Reg = int;
+
+constexpr Reg kNoReg = -1;
+constexpr Reg kFirstFloatReg = 32;
+constexpr Reg kFirstVirtualReg = 64;
+
+constexpr Reg kRegZero = 0;
+constexpr Reg kRegRa = 1;
+constexpr Reg kRegSp = 2;
+constexpr Reg kRegS0 = 8;
+constexpr Reg kRegA0 = 10;
+constexpr Reg kRegFa0 = kFirstFloatReg + 10;
+
+enum class RegClass { INT, FLOAT };
+
+inline bool isVirtualReg(const Reg r) {
+    return r >= kFirstVirtualReg;
+}
+
+/// @brief ABI name of a physical register, e.g. "t0", "fs1".
+const char *getPhysRegName(Reg r);
+/// @brief a0 ~ a7 for integers and fa0 ~ fa7 for floats.
+Reg getArgReg(RegClass cls, int index);
+bool isCalleeSavedReg(Reg r);
+
+/**
+ * How the operands of a MachineInstr are laid out, which decides
+ * both the printed text and the registers read/written by the instruction.
+ */
+enum class MachineFormat {
+    R,       // op rd, rs1, rs2
+    I,       // op rd, rs1, imm     /  addi rd, <address of a frame slot>
+    UNARY,   // op rd, rs1          (mv, fmv.s, fcvt.s.w, ...)
+    LI,      // li rd, imm
+    LA,      // la rd, symbol
+    LUI,     // lui rd, %hi(symbol)
+    LOAD,    // op rd, imm(rs1)  /  op rd, %lo(symbol)(rs1)  /  op rd, <frame slot/stack arg>
+    STORE,   // op rs2, imm(rs1) /  op rs2, %lo(symbol)(rs1) /  op rs2, <frame slot>
+    BRANCH,  // op rs1, rs2, label
+    JUMP,    // j label
+    CALL,    // jal ra, symbol
+    RET      // function epilogue, then `jr ra` (or `j symbol` for a tail call)
+};
+
+struct MachineInstr {
+    std::string opcode;
+    MachineFormat format;
+    Reg rd = kNoReg;
+    Reg rs1 = kNoReg;
+    Reg rs2 = kNoReg;
+    int32_t imm = 0;
+    /// label of BRANCH/JUMP, callee of CALL/tail call, symbol of LA/LUI, %lo(symbol) of LOAD/STORE
+    std::string symbol;
+    /// LOAD/STORE through a frame slot of the function instead of rs1, or the slot whose address
+    /// an I-format `addi` takes
+    int frameSlot = -1;
+    /// LOAD of the i-th argument the caller passed on its stack, instead of rs1
+    int incomingStackArg = -1;
+    /// argument/return-value registers read by CALL/RET
+    std::vector<Reg> implicitUses;
+    std::string comment;
+
+    /// @brief Registers written by the instruction.
+    std::vector<Reg> getDefs() const;
+    /// @brief Registers read by the instruction (including implicit uses).
+    std::vector<Reg> getUses() const;
+    /// @brief Visits every explicit register operand, e.g. for rewriting
+    /// virtual registers into physical ones.
+    template <typename Fn>
+    void forEachRegOperand(Fn fn) {
+        for (Reg *r : {&rd, &rs1, &rs2}) {
+            if (*r != kNoReg) {
+                fn(*r);
+            }
+        }
+    }
+    /// @return whether the address is in the frame (see MachineFunction) rather than in rs1
+    bool accessesFrame() const {
+        return frameSlot >= 0 || incomingStackArg >= 0;
+    }
+    bool isCall() const {
+        return format == MachineFormat::CALL;
+    }
+    bool endsBlock() const {
+        return format == MachineFormat::BRANCH || format == MachineFormat::JUMP ||
+               format == MachineFormat::RET;
+    }
+
+    static MachineInstr makeR(const char *op, Reg rd, Reg rs1, Reg rs2);
+    static MachineInstr makeI(const char *op, Reg rd, Reg rs1, int32_t imm);
+    static MachineInstr makeUnary(const char *op, Reg rd, Reg rs1);
+    static MachineInstr makeLi(Reg rd, int32_t imm);
+    static MachineInstr makeLa(Reg rd, const std::string &symbol);
+    static MachineInstr makeLui(Reg rd, const std::string &symbol);
+    static MachineInstr makeLoad(const char *op, Reg rd, Reg base, int32_t offset,
+                                 const std::string &symbol = "");
+    static MachineInstr makeStore(const char *op, Reg value, Reg base, int32_t offset,
+                                  const std::string &symbol = "");
+    static MachineInstr makeLoadSlot(const char *op, Reg rd, int slot);
+    static MachineInstr makeStoreSlot(const char *op, Reg value, int slot);
+    static MachineInstr makeAddrSlot(Reg rd, int slot);
+    static MachineInstr makeLoadIncomingStackArg(const char *op, Reg rd, int index);
+    static MachineInstr makeBranch(const char *op, Reg rs1, Reg rs2, const std::string &label);
+    static MachineInstr makeJump(const std::string &label);
+    static MachineInstr makeCall(const std::string &callee, std::vector<Reg> argRegs);
+    static MachineInstr makeRet(std::vector<Reg> retRegs);
+    /// @brief Tears down the frame like RET, then jumps to `callee`, which returns to our caller.
+    static MachineInstr makeTailCall(const std::string &callee, std::vector<Reg> argRegs);
+};
+
+struct MachineBasicBlock {
+    /// empty if the block is only reached by falling through
+    std::string label;
+    std::vector<MachineInstr> instrs;
+};
+
+class MachineFunction {
+   public:
+    explicit MachineFunction(const std::string &p_name) : m_name(p_name) {}
+
+    const std::string &getName() const {
+        return m_name;
+    }
+
+    Reg newVirtualReg(RegClass cls);
+    RegClass getRegClass(Reg r) const;
+    int getNumVirtualRegs() const {
+        return m_vreg_classes.size();
+    }
+
+    /// @return the index of a new frame slot of `size` bytes
+    int newFrameSlot(int size);
+
+    MachineBasicBlock *appendBlock(const std::string &label);
+    std::vector<std::unique_ptr<MachineBasicBlock>> &getBlocks() {
+        return m_blocks;
+    }
+
+    void noteOutgoingStackArgs(int count);
+    void setUsedCalleeSavedRegs(std::vector<Reg> regs) {
+        m_used_callee_saved_regs = std::move(regs);
+    }
+
+    /// @brief Switches to the frame layout without ra and frame pointer if the function
+    /// calls nothing and its frame surely stays addressable from sp.
+    /// @note Must be called before register allocation, which may then hand out s0.
+    void omitFramePointerIfLeaf();
+    bool omitsFramePointer() const {
+        return m_omits_frame_pointer;
+    }
+
+    /// @brief Prints the function with its prologue and epilogue.
+    /// @note Must be called after register allocation.
+    void dump(FILE *p_out_file) const;
+
+   private:
+    std::string m_name;
+    std::vector<std::unique_ptr<MachineBasicBlock>> m_blocks;
+    std::vector<RegClass> m_vreg_classes;
+    std::vector<int> m_frame_slot_sizes;
+    /// the number of words at the bottom of the frame for stack arguments of callees
+    int m_max_outgoing_stack_args = 0;
+    std::vector<Reg> m_used_callee_saved_regs;
+    bool m_omits_frame_pointer = false;
+
+    /**
+     * Frame layout (relative to 's0', the top of the frame):
+     *   s0 - 4:       ra
+     *   s0 - 8:       s0 of the caller
+     *   ...:          callee-saved registers used by the function
+     *   ...:          frame slots of 4 bytes (locals living in memory, spilled virtual
+     *                 registers), then the larger ones (arrays), so that the former stay
+     *                 within a 12-bit offset
+     *   sp + 4 * i:   the i-th stack argument of a callee
+     * A leaf function omitting the frame pointer saves neither ra nor s0 (unless s0 is
+     * allocated, then it is one of the callee-saved registers), and everything is addressed
+     * from sp, i.e. the top of the frame is sp + frame size.
+     */
+    int getFrameSize() const;
+    /// @return the bytes at the top of the frame for ra and s0
+    int getSizeOfLinkArea() const {
+        return m_omits_frame_pointer ? 0 : 8;
+    }
+    int getFrameSlotOffset(int slot) const;
+    /// @return the operand addressing `offset` bytes from the top of the frame
+    std::string getFrameAddress(int offset) const;
+    void dumpInstr(FILE *p_out_file, const MachineInstr &instr) const;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef CODEGEN_PEEPHOLE_OPTIMIZER_H
+#define CODEGEN_PEEPHOLE_OPTIMIZER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * A separate pass over an emitted assembly file (--peephole).
+ *
+ * The instructions of the .text section are buffered per basic block (split at labels,
+ * directives, branches and jumps) and rewritten with a table of rules until none applies:
+ *   - push-pop cancel:  `addi sp, sp, -4; sw X, 0(sp); ..; lw X, 0(sp); addi sp, sp, 4` => `..`
+ *   - push-pop move:    the same with different registers                          => `mv Y, X; ..`
+ *   - self move:        `mv X, X` => nothing
+ *   - move folding:     `op R, ..; mv X, R` => `op X, ..` if R is dead afterwards
+ * Afterwards, a `j` to a label that directly follows it (possibly with data of another
+ * section in between) is dropped.
+ *
+ * The rules only assume the conventions of the generated code: the stack slot of a push is
+ * only accessed through `sp`, and a call may clobber every caller-saved register.
+ */
+class PeepholeOptimizer {
+   public:
+    PeepholeOptimizer();
+
+    /// @brief Rewrites the assembly file in place.
+    void run(const std::string &asm_file_path);
+    /// @brief Prints how many times each rule was applied.
+    void dumpCounters(FILE *p_out_file) const;
+
+   private:
+    struct AsmLine {
+        enum class Kind { INSTR, LABEL, DIRECTIVE, SECTION, OTHER };
+
+        std::string text;
+        Kind kind = Kind::OTHER;
+        bool inText = false;
+        bool deleted = false;
+        // INSTR only
+        std::string opcode;
+        std::vector<std::string> operands;
+        // LABEL only
+        std::string label;
+
+        /// @brief Replaces the instruction by `opcode operands...`.
+        void setInstr(const std::string &new_opcode, std::vector<std::string> new_operands);
+    };
+    using Block = std::vector<AsmLine *>;
+
+    struct Rule {
+        const char *name;
+        /// tries to rewrite the instructions starting at index `i` of the block
+        bool (*apply)(Block &block, size_t i);
+        /// the number of times the rule was applied
+        int count;
+    };
+    std::vector<Rule> m_rules;
+    int m_jumps_to_next_label = 0;
+
+    // - Rules
+
+    static bool cancelPushPop(Block &block, size_t i);
+    static bool turnPushPopIntoMove(Block &block, size_t i);
+    static bool removeSelfMove(Block &block, size_t i);
+    static bool foldMoveIntoProducer(Block &block, size_t i);
+    /// @return the index of the pop matching the push at block[i], or 0 if there is none
+    /// that can be removed together with the push
+    static size_t findMatchingPop(const Block &block, size_t i);
+    /// @return whether `reg` is not read before being overwritten after block[i]
+    static bool isDeadAfter(const Block &block, size_t i, const std::string &reg);
+
+    static AsmLine parseLine(const std::string &text);
+    void optimizeBlock(Block &block);
+    void removeJumpsToNextLabel(std::vector<AsmLine> &lines);
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef CODEGEN_REGISTER_CODE_GENERATOR_H
+#define CODEGEN_REGISTER_CODE_GENERATOR_H
+
+#include "codegen/ConstantPool.hpp"
+#include "codegen/InstructionSelector.hpp"
+#include "ir/IR.hpp"
+#include "util/CompilerOptions.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Code generator of -O1.
+ *
+ * Instead of pushing every intermediate value onto the stack (see CodeGenerator), the
+ * program is taken in as IR (see IrBuilder) and each function is
+ *   1. translated into machine code over virtual registers by InstructionSelector,
+ *   2. mapped onto physical registers by LinearScanAllocator, which spills to the frame
+ *      only when it runs out of registers.
+ */
+class RegisterCodeGenerator {
+   private:
+    const IrModule &m_module;
+    const CompilerOptions &m_options;
+    std::string m_source_file_path;
+    std::unique_ptr<FILE, decltype(&fclose)> m_output_file{nullptr, &fclose};
+
+    /// the next usable number of .L labels
+    int m_next_label = 1;
+    /// the real and string literals, emitted after the last function
+    ConstantPool m_constant_pool;
+
+    void generateGlobal(const IrGlobal &global);
+    void generateFunction(const IrFunction &function);
+
+   public:
+    ~RegisterCodeGenerator() = default;
+    RegisterCodeGenerator(const std::string &source_file_name, const std::string &save_path,
+                          const IrModule &p_module, const CompilerOptions &p_options);
+
+    void generate();
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef CODEGEN_STRENGTH_REDUCTION_H
+#define CODEGEN_STRENGTH_REDUCTION_H
+
+#include "codegen/MachineCode.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Strength reduction of integer multiplication, division and modulo by a constant, shared by
+ * both code generators.
+ *
+ * - x * c:  a sum of shifted x, one term per digit of c in non-adjacent form
+ *           (e.g. x * 7 = (x << 3) - x),
+ * - x / 2^k, x % 2^k:  shifts and a mask, with the bias that rounds a negative x toward zero,
+ * - x / c, x % c:  the high word of x * M for a magic number M (Hacker's Delight, 10-1), then
+ *           x - (x / c) * c for the remainder.
+ *
+ * A sequence is only chosen if it costs less than the instruction itself (with `li c`),
+ * counting the rough latencies below of an in-order RV32IM core, e.g. the GD32V.
+ */
+
+enum class ArithOp { MUL, DIV, REM };
+
+constexpr int kCostOfAluOp = 1;
+constexpr int kCostOfMul = 4;   // mul, mulh
+constexpr int kCostOfDiv = 34;  // div, rem
+
+/// registers of a reduced sequence besides its scratch registers 1, 2, ...
+constexpr int kSeqOperand = 0;  // x
+constexpr int kSeqZero = -1;    // the zero register
+
+/// @brief An instruction of a reduced sequence.
+struct ArithStep {
+    MachineFormat format;  // R, I or LI
+    const char *opcode;
+    int rd;
+    int rs1 = kSeqZero;
+    int rs2 = kSeqZero;
+    int32_t imm = 0;
+};
+
+struct ReducedSequence {
+    /// empty if `op` itself is as cheap; the last step computes the result
+    std::vector<ArithStep> steps;
+    int numScratchRegs = 0;
+    int cost = 0;
+};
+
+/// @return the cheapest sequence computing `x op c` (division rounds toward zero, as `div` does)
+ReducedSequence reduceByConstant(ArithOp op, int32_t c);
+
+#endif
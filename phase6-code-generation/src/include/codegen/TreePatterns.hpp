@@ -0,0 +1,79 @@
+#ifndef CODEGEN_TREE_PATTERNS_H
+#define CODEGEN_TREE_PATTERNS_H
+
+#include "codegen/MachineCode.hpp"
+#include "codegen/StrengthReduction.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * The rules selecting instructions for an integer binary operator, shared by both code
+ * generators, in the manner of a bottom-up rewrite system (BURS).
+ *
+ * Each rule matches an operator whose operands are matched as
+ *   - REG:  a value in a register; a constant takes a `li` (or is the zero register),
+ *   - IMM:  a constant that fits the 12-bit immediate of an I-format instruction, once
+ *           adjusted by the rule (e.g. `x <= c` is `slti x, c + 1`),
+ *   - ZERO: the constant 0,
+ * and carries the cost of its instructions (see StrengthReduction.hpp). Only constants match
+ * anything but REG, and they are leaves, so the cheapest rule at each operator is the cheapest
+ * cover of the whole expression tree.
+ */
+
+enum class PatternOp { ADD, SUB, MUL, DIV, REM, LT, LE, NE, GE, GT, EQ, AND, OR };
+
+enum class OperandKind { REG, IMM, ZERO };
+
+/// the constant of an IMM operand as the immediate of the rule
+enum class ImmOf { C, C_PLUS_1, MINUS_C };
+
+/// registers of a rule besides the zero register (kSeqZero)
+constexpr int kPatResult = 0;  // what the previous step computed
+constexpr int kPatLeft = 1;
+constexpr int kPatRight = 2;
+
+/// the immediate of a step that is the constant of the IMM operand
+constexpr int32_t kPatConstant = INT32_MIN;
+
+/// @brief An instruction of a rule; each step computes the result of the rule so far.
+struct PatternStep {
+    MachineFormat format;  // R or I
+    const char *opcode;
+    int rs1;
+    int rs2 = kSeqZero;
+    int32_t imm = 0;
+};
+
+struct PatternRule {
+    PatternOp op;
+    OperandKind left;
+    OperandKind right;
+    ImmOf immOf;
+    int cost;
+    std::vector<PatternStep> steps;
+};
+
+/// @brief An operand as the rules see it: a constant or a value computed at run time.
+struct PatternOperand {
+    bool isConstant = false;
+    int32_t value = 0;
+};
+
+struct PatternCover {
+    const PatternRule *rule = nullptr;
+    /// the immediate of kPatConstant
+    int32_t imm = 0;
+    /// the cost of the rule, and of the `li` of a constant REG operand
+    int cost = 0;
+};
+
+/// @return the cheapest rule for `left op right`
+PatternCover coverBinary(PatternOp op, const PatternOperand &left, const PatternOperand &right);
+
+/// @return whether the constant `operand` matched as REG is the zero register instead of a `li`
+inline bool isInZeroReg(const PatternOperand &operand) {
+    return operand.isConstant && operand.value == 0;
+}
+
+#endif
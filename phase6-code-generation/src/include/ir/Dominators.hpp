@@ -0,0 +1,51 @@
+#ifndef IR_DOMINATORS_H
+#define IR_DOMINATORS_H
+
+#include "ir/IR.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The dominator tree of an IrFunction, computed with the iterative algorithm of Cooper, Harvey
+ * and Kennedy ("A Simple, Fast Dominance Algorithm") over the reverse postorder of the CFG.
+ *
+ * The CFG must be up to date (see IrFunction::rebuildCfg()); blocks unreachable from the entry
+ * block are not in the tree.
+ */
+class DominatorTree {
+   public:
+    explicit DominatorTree(const IrFunction &function);
+
+    /// @return the immediate dominator of `block`, nullptr for the entry block
+    IrBasicBlock *getIdom(const IrBasicBlock *block) const;
+    /// @return whether every path from the entry block to `b` goes through `a` (a dominates a)
+    bool dominates(const IrBasicBlock *a, const IrBasicBlock *b) const;
+    /// @return the reachable blocks in reverse postorder, the entry block first
+    const std::vector<IrBasicBlock *> &getReversePostorder() const {
+        return m_rpo;
+    }
+    /// @return the blocks whose immediate dominator is `block`, in reverse postorder
+    const std::vector<IrBasicBlock *> &getChildrenOf(const IrBasicBlock *block) const {
+        return m_children[m_rpo_index.at(block)];
+    }
+    /**
+     * @return the dominance frontier of `block`: the blocks it does not strictly dominate but
+     *         dominates a predecessor of, where its assignments meet others (Cytron et al.,
+     *         computed as by Cooper, Harvey and Kennedy)
+     */
+    const std::vector<IrBasicBlock *> &getFrontierOf(const IrBasicBlock *block) const {
+        return m_frontiers[m_rpo_index.at(block)];
+    }
+
+   private:
+    std::vector<IrBasicBlock *> m_rpo;
+    std::unordered_map<const IrBasicBlock *, int> m_rpo_index;
+    /// the immediate dominator of each block, by index in m_rpo (the entry block is its own)
+    std::vector<int> m_idom;
+    /// by index in m_rpo
+    std::vector<std::vector<IrBasicBlock *>> m_children;
+    std::vector<std::vector<IrBasicBlock *>> m_frontiers;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef IR_IR_H
+#define IR_IR_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * A typed three-address IR.
+ *
+ * - Values are temporaries (%n), which may be assigned more than once, or constants.
+ * - Memory is either a frame slot ($name) of the function or a global (@name), or is accessed
+ *   through a pointer temporary (`addr` takes the address of a slot/global).
+ * - Each function is a list of basic blocks; the first one is the entry block and
+ *   every block ends with exactly one terminator (br, cbr or ret).
+ */
+
+enum class IrType {
+    VOID,
+    I32,  // integer, boolean
+    F32,  // real
+    PTR   // address, e.g. of a string literal
+};
+
+const char *getIrTypeName(IrType type);
+
+struct IrValue {
+    enum class Kind { NONE, TEMP, INT, FLOAT, STRING };
+
+    Kind kind = Kind::NONE;
+    IrType type = IrType::VOID;
+    int temp = -1;
+    int32_t intVal = 0;
+    double floatVal = 0.0;
+    std::string strVal;
+
+    static IrValue makeTemp(int temp, IrType type);
+    static IrValue makeInt(int32_t value);
+    static IrValue makeFloat(double value);
+    static IrValue makeString(const std::string &value);
+
+    bool isNone() const {
+        return kind == Kind::NONE;
+    }
+    bool isTemp() const {
+        return kind == Kind::TEMP;
+    }
+    bool isConst() const {
+        return kind == Kind::INT || kind == Kind::FLOAT || kind == Kind::STRING;
+    }
+    bool isSameAs(const IrValue &other) const;
+};
+
+/// @brief A memory location: a frame slot, a global variable, or the one a pointer points to.
+struct IrAddress {
+    /// POINTER: the pointer is the last operand of the load/store
+    enum class Kind { NONE, SLOT, GLOBAL, POINTER };
+
+    Kind kind = Kind::NONE;
+    int slot = -1;
+    std::string global;
+
+    static IrAddress makeSlot(int slot);
+    static IrAddress makeGlobal(const std::string &name);
+    static IrAddress makePointer();
+};
+
+enum class IrOp {
+    // %d = op a
+    COPY,
+    NEG,
+    NOT,
+    ITOF,  // int -> real
+    // %d = op a, b
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    REM,
+    AND,
+    OR,
+    LT,
+    LE,
+    NE,
+    GE,
+    GT,
+    EQ,
+    // memory
+    ADDR,   // %p = addr <address>
+    LOAD,   // %d = load <address>
+    STORE,  // store <address>, a
+    // %d = call f(a, b, ...)
+    CALL,
+    // terminators
+    BR,   // br target
+    CBR,  // cbr a, target (a != 0), target2 (a == 0)
+    RET   // ret [a]
+};
+
+const char *getIrOpName(IrOp op);
+
+struct IrBasicBlock;
+
+struct IrInstr {
+    IrOp op;
+    IrValue dst;
+    std::vector<IrValue> operands;
+    IrAddress address;
+    std::string callee;
+    IrBasicBlock *target = nullptr;
+    IrBasicBlock *target2 = nullptr;
+
+    bool isTerminator() const {
+        return op == IrOp::BR || op == IrOp::CBR || op == IrOp::RET;
+    }
+    /// @brief Whether the instruction does nothing but compute `dst`.
+    bool isPure() const {
+        return op != IrOp::STORE && op != IrOp::CALL && !isTerminator();
+    }
+    bool isBinary() const {
+        return IrOp::ADD <= op && op <= IrOp::EQ;
+    }
+    bool isComparison() const {
+        return IrOp::LT <= op && op <= IrOp::EQ;
+    }
+
+    static IrInstr makeUnary(IrOp op, const IrValue &dst, const IrValue &a);
+    static IrInstr makeBinary(IrOp op, const IrValue &dst, const IrValue &a, const IrValue &b);
+    static IrInstr makeLoad(const IrValue &dst, const IrAddress &address);
+    static IrInstr makeStore(const IrAddress &address, const IrValue &value);
+    static IrInstr makeAddr(const IrValue &dst, const IrAddress &address);
+    /// @brief Makes the load/store access its location through `pointer` (see makeAddr).
+    void setPointer(const IrValue &pointer);
+    static IrInstr makeCall(const IrValue &dst, const std::string &callee,
+                            std::vector<IrValue> args);
+    static IrInstr makeBr(IrBasicBlock *target);
+    static IrInstr makeCbr(const IrValue &cond, IrBasicBlock *ifTrue, IrBasicBlock *ifFalse);
+    static IrInstr makeRet(const IrValue &value);
+};
+
+/**
+ * @return the constant `instr` (neg, not or a binary operator) computes from integer constants,
+ *         as the generated code would (wrapping around at 32 bits), or none if an operand is not
+ *         one or it divides by zero
+ */
+IrValue foldConstant(const IrInstr &instr);
+
+struct IrBasicBlock {
+    int id;
+    std::vector<IrInstr> instrs;
+    /// filled by IrFunction::rebuildCfg()
+    std::vector<IrBasicBlock *> preds;
+    std::vector<IrBasicBlock *> succs;
+
+    bool hasTerminator() const {
+        return !instrs.empty() && instrs.back().isTerminator();
+    }
+};
+
+struct IrSlot {
+    std::string name;
+    /// the type of the element, for an array
+    IrType type;
+    int size;
+};
+
+struct IrTempInfo {
+    IrType type;
+    /// name of the source variable, if any (for dumps)
+    std::string name;
+};
+
+class IrFunction {
+   public:
+    IrFunction(const std::string &p_name, IrType p_return_type)
+        : m_name(p_name), m_return_type(p_return_type) {}
+
+    const std::string &getName() const {
+        return m_name;
+    }
+    IrType getReturnType() const {
+        return m_return_type;
+    }
+
+    IrValue newTemp(IrType type, const std::string &name = "");
+    const IrTempInfo &getTempInfo(int temp) const {
+        return m_temps.at(temp);
+    }
+    int getNumTemps() const {
+        return m_temps.size();
+    }
+
+    int newSlot(const std::string &name, IrType type, int size);
+    const IrSlot &getSlot(int slot) const {
+        return m_slots.at(slot);
+    }
+    int getNumSlots() const {
+        return m_slots.size();
+    }
+    /// @brief Removes the slots marked in `erased`; they must no longer be accessed.
+    void eraseSlots(const std::vector<bool> &erased);
+    /**
+     * @return whether the address of a slot (a local array) is taken: it may then be passed to
+     *         a callee, and the frame must outlive the call
+     */
+    bool takesAddressOfSlot() const;
+
+    /// temporaries holding the arguments on entry, in the order of the parameters
+    std::vector<IrValue> &getParams() {
+        return m_params;
+    }
+    const std::vector<IrValue> &getParams() const {
+        return m_params;
+    }
+
+    IrBasicBlock *newBlock();
+    std::vector<std::unique_ptr<IrBasicBlock>> &getBlocks() {
+        return m_blocks;
+    }
+    const std::vector<std::unique_ptr<IrBasicBlock>> &getBlocks() const {
+        return m_blocks;
+    }
+
+    /// @brief Recomputes the predecessors and successors of every block.
+    void rebuildCfg();
+    /// @brief Removes the blocks that cannot be reached from the entry block.
+    /// @return whether any block was removed
+    bool removeUnreachableBlocks();
+
+    void dump(FILE *p_out_file) const;
+
+   private:
+    std::string m_name;
+    IrType m_return_type;
+    std::vector<IrTempInfo> m_temps;
+    std::vector<IrSlot> m_slots;
+    std::vector<IrValue> m_params;
+    std::vector<std::unique_ptr<IrBasicBlock>> m_blocks;
+    int m_next_block_id = 0;
+
+    std::string getValueInString(const IrValue &value) const;
+    std::string getAddressInString(const IrAddress &address) const;
+};
+
+struct IrGlobal {
+    std::string name;
+    /// the type of the element, for an array
+    IrType type;
+    /// the value of a global constant; none for a variable
+    IrValue init;
+    int size = 4;
+};
+
+struct IrModule {
+    std::string name;
+    std::vector<IrGlobal> globals;
+    std::vector<std::unique_ptr<IrFunction>> functions;
+
+    void dump(FILE *p_out_file) const;
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef IR_IR_BUILDER_H
+#define IR_IR_BUILDER_H
+
+#include "ir/IR.hpp"
+#include "sema/SemanticAnalyzer.hpp"
+#include "sema/SymbolTable.hpp"
+#include "util/CompilerOptions.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Lowers the AST into the IR (see ir/IR.hpp).
+ *
+ * The lowering is deliberately naive, like CodeGenerator:
+ *   - every local variable/constant/parameter/loop variable gets a frame slot and is
+ *     accessed by load/store; an element of an array, through a pointer to it,
+ *   - every expression node yields a new temporary,
+ *   - `and`/`or`/`not` are short-circuited into branches (see branchOn).
+ * The passes in ir/IrPasses.hpp then clean it up.
+ *
+ * With -O1, the operand of a binary operator needing more registers is lowered first (see
+ * getRegisterNeedOf), so that fewer values are held at once.
+ *
+ * With -O1, a `for` loop may be unrolled while it is lowered (see CompilerOptions::unrollFactor):
+ * its body is lowered once per iteration it stands for, with the loop variable renamed to the
+ * value it has in that iteration.
+ *
+ * The symbol tables are borrowed: each one is put back into the map once its scope is
+ * left, so the map can still be handed to another visitor afterwards.
+ */
+class IrBuilder final : public AstNodeVisitor {
+   private:
+    using SymbolTableMap = std::unordered_map<SemanticAnalyzer::AstNodeAddr, SymbolManager::Table>;
+
+    SymbolManager m_symbol_manager;
+    SymbolTableMap &m_symbol_table_of_scoping_nodes;
+    std::unique_ptr<IrModule> m_module;
+    const CompilerOptions &m_options;
+
+    struct UnrolledLoop {
+        std::string function;
+        uint32_t line;
+        int64_t tripCount;
+        /// copies of the body per iteration of the loop left, 0 if not unrolled
+        int copies;
+        /// copies after the loop, for the iterations left over
+        int64_t leftOver;
+    };
+    /// the for loops considered for unrolling, for dumpUnrollReport()
+    std::vector<UnrolledLoop> m_unrolled_loops;
+
+    struct StatementNeed {
+        std::string function;
+        uint32_t line;
+        const char *statement;
+        /// registers needed by its expression, in the order it is lowered
+        int registers;
+        /// registers needed if it were lowered left to right
+        int registersLeftToRight;
+    };
+    /// the statements with an expression, for dumpRegisterReport()
+    std::vector<StatementNeed> m_statement_needs;
+    /// (the body of an unrolled loop is lowered more than once, but reported once)
+    std::unordered_set<const AstNode *> m_measured_statements;
+
+    // - States of the function being lowered
+
+    IrFunction *m_function = nullptr;
+    IrBasicBlock *m_block = nullptr;
+    IrType m_return_type = IrType::VOID;
+    std::unordered_map<const SymbolEntry *, int> m_slot_of_local;
+    /// the value of the last visited expression
+    IrValue m_result;
+    /// the value of each loop variable in the copy of an unrolled body being lowered
+    std::unordered_map<const SymbolEntry *, IrValue> m_value_of_loop_var;
+
+    void emit(IrInstr instr);
+    /// @brief Continues lowering at the start of `block`.
+    void placeBlock(IrBasicBlock *block);
+    /// @return the value of the expression, converted to `target` if needed
+    IrValue evaluate(ExpressionNode *expr, IrType target = IrType::VOID);
+    /// @return whether the right operand is lowered first (see getRegisterNeedOf)
+    bool evaluatesRightFirst(const BinaryOperatorNode &p_bin_op) const;
+    /// @brief Records the registers `expr` of the statement `p_statement` needs, if reported.
+    void noteRegisterNeed(const AstNode &p_statement, const char *statement,
+                          const ExpressionNode *expr);
+    /**
+     * Lowers a boolean expression into branches to `trueBlock`/`falseBlock`: `and`/`or` only
+     * evaluate the right operand if the left one does not decide, and `not` swaps the targets.
+     */
+    void branchOn(ExpressionNode *condition, IrBasicBlock *trueBlock, IrBasicBlock *falseBlock);
+    IrAddress getAddressOf(const SymbolEntry *entry) const;
+    /**
+     * @return a pointer to what `p_variable_ref` refers to: the array itself, or the element (or
+     *         sub-array) its indices select, in row-major order; constant indices are folded
+     *         into one offset added to the start of the array (for an array parameter, the
+     *         address its slot holds)
+     */
+    IrValue evaluateAddressOf(VariableReferenceNode &p_variable_ref, const SymbolEntry *entry);
+    /// @brief Lowers one copy of the body of `p_for`, where the loop variable is `value`.
+    void lowerBodyCopy(ForNode &p_for, const SymbolEntry *loopVarEntry, const IrValue &value);
+    /**
+     * Lowers the body once per iteration, with the loop variable as a constant in each copy.
+     */
+    void fullyUnroll(ForNode &p_for, const SymbolEntry *loopVarEntry);
+    /**
+     * Lowers a loop whose body is `factor` copies, each reading the loop variable plus its
+     * index, followed by one copy per iteration left over.
+     */
+    void partiallyUnroll(ForNode &p_for, const SymbolEntry *loopVarEntry, int factor);
+    void pushScope(const AstNode *node);
+    void popScope(const AstNode *node);
+
+    void beginFunction(const char *name, IrType returnType);
+    void endFunction();
+
+   public:
+    ~IrBuilder() = default;
+    IrBuilder(const std::string &module_name, SymbolTableMap &p_symbol_table_of_scoping_nodes,
+              const CompilerOptions &p_options);
+
+    std::unique_ptr<IrModule> takeModule() {
+        return std::move(m_module);
+    }
+
+    /// @brief Prints each for loop of the program, and how it was unrolled.
+    void dumpUnrollReport(FILE *p_out_file) const;
+    /// @brief Prints each statement with an expression, and the registers it needs.
+    void dumpRegisterReport(FILE *p_out_file) const;
+
+    void visit(ProgramNode &p_program) override;
+    void visit(DeclNode &p_decl) override;
+    void visit(VariableNode &p_variable) override;
+    void visit(ConstantValueNode &p_constant_value) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+};
+
+IrType getIrTypeOf(const Type &type);
+
+/**
+ * @return the registers needed to evaluate `expr` without spilling (its Ershov number), if
+ *         each leaf takes one register:
+ *           - an operator whose operands need l and r registers needs max(l, r), or l + 1 if
+ *             l = r, when the operand needing more is evaluated first (`reorders`, and neither
+ *             operand calls a function, whose side effects must keep their order),
+ *           - max(l, r + 1) when the left one is evaluated first regardless,
+ *           - the arguments of a call and the indices of an element are evaluated in order,
+ *             each held while the next ones are.
+ */
+int getRegisterNeedOf(const ExpressionNode *expr, bool reorders);
+
+#endif
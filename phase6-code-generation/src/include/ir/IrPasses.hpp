@@ -0,0 +1,102 @@
+#ifndef IR_IR_PASSES_H
+#define IR_IR_PASSES_H
+
+#include "ir/IR.hpp"
+#include "util/CompilerOptions.hpp"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Passes over the IR. Each pass works on one function and keeps the CFG of it up to date.
+ */
+
+/**
+ * @brief Turns each `%r = call f(..); ret %r` in f itself into assignments to the parameters and
+ * a branch back to the start of f, which a new entry block falls into. Nothing is done if f
+ * takes the address of a local array, which it might pass on.
+ */
+void eliminateTailRecursion(IrFunction &function);
+
+/**
+ * @brief Replaces each scalar frame slot whose address is never taken by temporaries.
+ *
+ * With `buildSsa`, each store assigns a new temporary, and where stores meet, a phi (see
+ * Dominators.hpp for the dominance frontiers) becomes a temporary assigned on each edge into the
+ * block; unrelated values of one variable then live in registers of their own. Otherwise, one
+ * temporary per slot is assigned by every store.
+ */
+void promoteLocalSlots(IrFunction &function, bool buildSsa);
+
+/**
+ * @brief Removes the copies introduced by the lowering, within each block:
+ *   - `%t = add ..; %x = copy %t` => `%x = add ..` if %t is not used anywhere else,
+ *   - uses of the destination of a copy are replaced by its source,
+ *   - an operator on integer constants is replaced by a copy of its value (see foldConstant).
+ */
+void propagateCopies(IrFunction &function);
+
+/**
+ * @brief Value numbering over the dominator tree: an instruction computing what an earlier one
+ * already has becomes a copy of its result, if that still holds it. Operators are matched with
+ * their operands in either order where that does not matter (and `a > b` with `b < a`).
+ *   - An expression over temporaries assigned once, by an assignment dominating it, is available
+ *     in every block it dominates; one over a temporary assigned more than once, only until that
+ *     is assigned again in its block.
+ *   - A load is available within its block until a store that may write its location, or a call
+ *     to a function not in `pure` (`read` included); a load right after a store to the same place
+ *     takes the value stored.
+ */
+void numberValues(IrFunction &function, const std::unordered_set<std::string> &pure);
+
+/// @brief Removes pure instructions whose result is never used.
+void removeDeadInstructions(IrFunction &function);
+
+/**
+ * @brief Substitutes the body of each small, non-recursive function of the module for the calls
+ * to it (see CompilerOptions::inlineBudget).
+ *
+ * Works on the whole module, callees first, so a function is measured after its own calls have
+ * been inlined; the functions themselves are kept, since they are exported.
+ */
+void inlineCalls(IrModule &module, const CompilerOptions &options);
+
+/**
+ * @return the functions of the module that write no memory but their own frame (reading globals
+ *         is fine) and call only such functions; calls to them may be moved and dropped
+ */
+std::unordered_set<std::string> findPureFunctions(const IrModule &module);
+
+/**
+ * @brief Loop-invariant code motion: moves the instructions of each loop (inner loops first)
+ * whose operands are not assigned in the loop into a preheader, a block that every entry into
+ * the loop goes through, so they run once instead of once per iteration:
+ *   - pure instructions, whose destination is assigned nowhere else and only used after it,
+ *   - loads of a slot/global the loop does not store to (if it calls no impure function),
+ *   - calls to `pure` functions, if they run on every way out of the loop anyway.
+ * The globals the loop still accesses get their address taken once in the preheader.
+ */
+void hoistLoopInvariants(IrFunction &function, const std::unordered_set<std::string> &pure);
+
+/**
+ * @brief Strength reduction of induction variables, in each loop (inner loops first):
+ *   - a basic induction variable %i is only assigned `%i = add/sub %i, <constant>` in the loop,
+ *   - a derived one is `mul` of one by a constant, or `add` of one and an invariant, e.g. the
+ *     address `add (addr $a), (mul %i, 4)` of a[i]; a derived operand must be computed earlier in
+ *     the same block, with no step of its %i in between.
+ * A derived value used by anything but another derived value (and not merely %i plus some
+ * invariants) gets a temporary of its own, computed in the preheader and stepped right after
+ * each step of %i; its definition becomes a copy of that, and the `mul`s die.
+ */
+void reduceInductionVariables(IrFunction &function);
+
+/// @brief Runs the passes enabled by `options` on each function of `module`.
+void runIrPasses(IrModule &module, const CompilerOptions &options);
+
+/// @return the number of uses of each temporary of the function
+std::vector<int> countUsesOfTemps(const IrFunction &function);
+/// @return the number of instructions defining each temporary (parameters not included)
+std::vector<int> countDefsOfTemps(const IrFunction &function);
+
+#endif
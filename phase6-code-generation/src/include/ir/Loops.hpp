@@ -0,0 +1,31 @@
+#ifndef IR_LOOPS_H
+#define IR_LOOPS_H
+
+#include "ir/Dominators.hpp"
+#include "ir/IR.hpp"
+
+#include <unordered_set>
+#include <vector>
+
+/**
+ * The natural loops of an IrFunction, for the loop passes (see ir/IrPasses.hpp): a loop is
+ * headed by a block that dominates some of its predecessors, and is made of the blocks that
+ * reach those back edges without going through the header.
+ */
+
+using BlockSet = std::unordered_set<IrBasicBlock *>;
+
+/// @return the blocks of the natural loop of the back edges into `header`
+BlockSet getLoopOf(IrBasicBlock *header, const DominatorTree &dom);
+
+/// @return the headers of the loops of the function, inner loops first
+std::vector<IrBasicBlock *> getLoopHeaders(const IrFunction &function);
+
+/**
+ * @return the block every entry into the loop goes through right before `header`: the only
+ *         predecessor from outside if it leads nowhere else, otherwise a new block between them,
+ *         laid out right before `header`
+ */
+IrBasicBlock *getPreheaderOf(IrFunction &function, IrBasicBlock *header, const BlockSet &body);
+
+#endif
@@ -6,7 +6,10 @@
 
 #include "sema/SymbolTable.hpp"
 
+#include <cstdio>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 class SemanticAnalyzer final : public AstNodeVisitor {
    public:
@@ -30,6 +33,17 @@ class SemanticAnalyzer final : public AstNodeVisitor {
     /// reconstructed while generating code.
     std::unordered_map<AstNodeAddr, SymbolManager::Table> m_symbol_table_of_scoping_nodes;
 
+    struct FrameOfFunction {
+        std::string name;
+        int sizeOfLocals;
+        int sizeOfLocalsWithoutReuse;
+    };
+    /// functions (and main) in the order they are declared, for dumpFrameReport()
+    std::vector<FrameOfFunction> m_frames;
+
+    /// @brief Fills in SymbolTable::sizeOfLocals of the table of a function that is left.
+    void recordFrame(const char *name, SymbolTable &table);
+
    public:
     /**
      * hw5 mod:
@@ -50,6 +64,9 @@ class SemanticAnalyzer final : public AstNodeVisitor {
         return m_error_printer.hasSemanticErr();
     }
 
+    /// @brief Prints the bytes of locals of each function, and how much slot reuse saved.
+    void dumpFrameReport(FILE *p_out_file) const;
+
     void visit(ProgramNode &p_program) override;
     void visit(DeclNode &p_decl) override;
     void visit(VariableNode &p_variable) override;
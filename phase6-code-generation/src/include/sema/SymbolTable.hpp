@@ -5,6 +5,7 @@
 #include "AST/ConstantValue.hpp"  // struct ConstVal
 #include <memory>
 #include <stack>
+#include <utility>
 #include <vector>
 
 #define MAX_SYMBOL_NAME_LEN 32
@@ -44,6 +45,13 @@ struct SymbolEntry {
      *      we store "-16"
      */
     int addrOfLocal;
+
+    /**
+     * An array parameter: arrays are passed by reference, so the slot at `addrOfLocal` holds
+     * the address of the caller's array, not the elements, and the elements are accessed
+     * through it.
+     */
+    bool isAlias = false;
 };
 
 struct SymbolTable {
@@ -60,6 +68,15 @@ struct SymbolTable {
     For simplicity, I choose Linear list.
     */
     std::vector<SymbolEntry> entries;
+
+    /**
+     * Only set on the table of a function (or of the body of the program):
+     * the number of bytes below 's0' used by the saved ra/s0 and the deepest local slot
+     * handed out by SymbolManager::pushEntry, for sizing the frame in codegen.
+     */
+    int sizeOfLocals = 0;
+    /// what `sizeOfLocals` would be if no slot was shared by disjoint scopes
+    int sizeOfLocalsWithoutReuse = 0;
 };
 
 struct SymbolManager {
@@ -134,8 +151,36 @@ struct SymbolManager {
      * push/pop when entering a new function
      * *NOTE: main() does not have a function node, but it is a function.
      * add      when a new entry appears
+     * 
+     * Slots are reused across disjoint scopes: a nested scope (compound statement, for loop)
+     * takes `addrOfNext` back when it is left, so its siblings get the same offsets.
+     *
+     * Arrays are laid out the same way, but in an area of their own below the other locals,
+     * whose top is only known once the function is done (see SemanticAnalyzer::recordFrame), so
+     * that the scalars stay within a 12-bit offset from s0 however large the arrays are.
      */
-    std::vector<int> listOfAddrOfNextLocal;
+    struct LocalSlots {
+        /// an array entry waiting for its address
+        struct Array {
+            SymbolTable *table;
+            size_t index;
+            /// the bytes of the array area from its top down to (and including) the array
+            int depth;
+        };
+
+        /// the address of the next local variable
+        int addrOfNext = -12;  // s0 - 12 is the addr of first var
+        /// the lowest `addrOfNext` ever reached, which decides the size of the frame
+        int lowestAddrOfNext = -12;
+        /// the bytes of the array area in use by the arrays in scope
+        int depthOfArrays = 0;
+        /// the largest `depthOfArrays` ever reached
+        int deepestArrays = 0;
+        /// the bytes of all slots and arrays handed out, as if none were reused
+        int sizeOfAllSlots = 0;
+        std::vector<Array> arrays;
+    };
+    std::vector<LocalSlots> listOfLocalSlots;
 };
 
 #endif
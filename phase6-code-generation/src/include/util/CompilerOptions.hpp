@@ -0,0 +1,112 @@
+#ifndef UTIL_COMPILER_OPTIONS_HPP
+#define UTIL_COMPILER_OPTIONS_HPP
+
+/**
+ * command line options that affect code generation
+ * (parsed in main() of parser.y)
+ */
+struct CompilerOptions {
+    /**
+     * -O0: stack machine (CodeGenerator)
+     * -O1: IR (IrBuilder, ir/IrPasses.hpp), registers assigned by linear scan
+     *      (RegisterCodeGenerator)
+     */
+    int optimizationLevel = 0;
+
+    /**
+     * fold constant subexpressions of the AST, with references to constants replaced by their
+     * values, which then are not emitted (see ConstantFolder); off by --no-fold
+     */
+    bool foldConstants = true;
+
+    /**
+     * remove statements that never run (after a return, in an arm of an `if` on a constant) and
+     * assignments to locals never read (see DeadCodeEliminator); off by --no-dce
+     */
+    bool eliminateDeadCode = true;
+
+    /**
+     * --omit-frame-pointer: leaf functions (calling nothing, printing/reading nothing) neither
+     * save ra nor set up s0; -O1 then addresses their frame from sp and allocates s0
+     */
+    bool omitFramePointer = false;
+
+    /**
+     * --inline-budget=N: -O1 inlines the calls to a non-recursive function of at most N IR
+     * instructions; 0 turns inlining off
+     */
+    int inlineBudget = 16;
+
+    /**
+     * `return f(...)` jumps to f instead of calling it, and a call to the function itself
+     * becomes a loop; off by --no-tail-calls
+     */
+    bool tailCalls = true;
+
+    /**
+     * integer `*`, `/` and `mod` by a constant become shifts, adds and multiplications by a
+     * magic number where cheaper (see codegen/StrengthReduction.hpp), and with -O1 a multiple of
+     * a loop counter (e.g. the address of a[i]) is stepped along with it instead (see
+     * reduceInductionVariables); off by --no-strength-reduction
+     */
+    bool strengthReduction = true;
+
+    /**
+     * -O0 keeps the counter of a for loop in a callee-saved register instead of its slot, and
+     * counts down to 0 when the body never reads it; off by --no-loop-registers
+     */
+    bool loopCounterRegisters = true;
+
+    /**
+     * -O0 loads an argument that is a literal or a local scalar straight into its argument
+     * register instead of pushing it first, and keeps a parameter in a0-a7/fa0-fa7 instead of
+     * its slot if no call comes before its last reference; off by --no-register-args
+     */
+    bool registerArguments = true;
+
+    /**
+     * -O1 gives each assignment to a local scalar a temporary of its own, joined by copies
+     * where assignments meet (SSA, see promoteLocalSlots), instead of one temporary per
+     * variable; off by --no-ssa
+     */
+    bool buildSsa = true;
+
+    /**
+     * -O1 reuses the value of an expression already computed in the block or a dominating one
+     * instead of computing it again (see numberValues); off by --no-cse
+     */
+    bool numberValues = true;
+
+    /// -O1 moves loop-invariant computations out of loops (see hoistLoopInvariants); off by --no-licm
+    bool hoistLoopInvariants = true;
+
+    /**
+     * --unroll=N: -O1 unrolls a for loop completely if that takes at most N times the code of a
+     * 16-node body, or else into N copies of a body of at most 16 nodes and the iterations left
+     * over; 1 turns unrolling off
+     */
+    int unrollFactor = 4;
+
+    /**
+     * -O1 evaluates the operand of a binary operator needing more registers first (Sethi-Ullman,
+     * see getRegisterNeedOf), unless either calls a function; off by --no-reorder
+     */
+    bool reorderOperands = true;
+
+    /// --unroll-report: print each for loop and how it was unrolled (see IrBuilder)
+    bool unrollReport = false;
+
+    /// --register-report: print the registers each statement needs (see IrBuilder)
+    bool registerReport = false;
+
+    /// --frame-report: print the bytes of locals of each function (see SemanticAnalyzer)
+    bool frameReport = false;
+
+    /// --emit-ir: dump the IR (after the passes of the optimization level) to stdout
+    bool emitIr = false;
+
+    /// --peephole: rewrite the emitted assembly with PeepholeOptimizer
+    bool peephole = false;
+};
+
+#endif  // UTIL_COMPILER_OPTIONS_HPP
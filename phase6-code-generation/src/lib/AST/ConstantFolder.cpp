@@ -0,0 +1,327 @@
+#include "AST/ConstantFolder.hpp"
+#include "AST/BinaryOperator.hpp"
+#include "AST/CompoundStatement.hpp"
+#include "AST/ConstantValue.hpp"
+#include "AST/FunctionInvocation.hpp"
+#include "AST/UnaryOperator.hpp"
+#include "AST/VariableReference.hpp"
+#include "AST/assignment.hpp"
+#include "AST/decl.hpp"
+#include "AST/for.hpp"
+#include "AST/function.hpp"
+#include "AST/if.hpp"
+#include "AST/print.hpp"
+#include "AST/program.hpp"
+#include "AST/read.hpp"
+#include "AST/return.hpp"
+#include "AST/while.hpp"
+
+#include <cstdint>
+#include <limits>
+
+/* ------------------------------------------------------------------------------------------------- */
+// - Evaluation (with the semantics of the generated code)
+
+static const ConstantValueNode *asConstant(const ExpressionNode *expr) {
+    return dynamic_cast<const ConstantValueNode *>(expr);
+}
+
+static bool isIntConstant(const ExpressionNode *expr, const int32_t value) {
+    const ConstantValueNode *constant = asConstant(expr);
+    return constant != nullptr && constant->getConstVal().scalarType == ScalarType::INTEGER &&
+           constant->getConstVal().valContainer.integer == value;
+}
+
+/// @brief `fcvt.s.w` for an integer; reals are held in double but computed in float
+static float toFloat(const ConstVal &val) {
+    if (val.scalarType == ScalarType::INTEGER) {
+        return static_cast<float>(val.valContainer.integer);
+    }
+    return static_cast<float>(val.valContainer.real);
+}
+
+static ConstantValueNode *makeConstant(const Location &location, const int32_t value) {
+    return new ConstantValueNode(location.line, location.col, value);
+}
+static ConstantValueNode *makeConstant(const Location &location, const float value) {
+    return new ConstantValueNode(location.line, location.col, static_cast<double>(value));
+}
+static ConstantValueNode *makeConstant(const Location &location, const bool value) {
+    return new ConstantValueNode(location.line, location.col, value);
+}
+
+static ConstantValueNode *makeConstant(const Location &location, const ConstVal &value) {
+    switch (value.scalarType) {
+        case ScalarType::INTEGER:
+            return makeConstant(location, value.valContainer.integer);
+        case ScalarType::REAL:
+            return new ConstantValueNode(location.line, location.col, value.valContainer.real);
+        case ScalarType::BOOLEAN:
+            return makeConstant(location, value.valContainer.boolean);
+        default:
+            return new ConstantValueNode(location.line, location.col, value.valContainer.string);
+    }
+}
+
+/// @return the constant node of `lhs op rhs`, or nullptr if it is left to run time
+static ConstantValueNode *evaluate(const Location &location, const OperatorType op,
+                                   const ConstVal &lhs, const ConstVal &rhs) {
+    const ScalarType ltype = lhs.scalarType;
+    const ScalarType rtype = rhs.scalarType;
+
+    if (op == OperatorType::AND || op == OperatorType::OR) {
+        if (ltype != ScalarType::BOOLEAN || rtype != ScalarType::BOOLEAN) {
+            return nullptr;
+        }
+        const bool l = lhs.valContainer.boolean;
+        const bool r = rhs.valContainer.boolean;
+        return makeConstant(location, (op == OperatorType::AND) ? (l && r) : (l || r));
+    }
+    if (ltype > ScalarType::REAL || rtype > ScalarType::REAL) {
+        // string concatenation is left to run time
+        return nullptr;
+    }
+
+    if (ltype == ScalarType::INTEGER && rtype == ScalarType::INTEGER) {
+        const int32_t l = lhs.valContainer.integer;
+        const int32_t r = rhs.valContainer.integer;
+        // wrap around like add/sub/mul do
+        const uint32_t ul = static_cast<uint32_t>(l);
+        const uint32_t ur = static_cast<uint32_t>(r);
+        // div/rem: INT_MIN / -1 overflows to INT_MIN with remainder 0
+        const bool overflows = l == std::numeric_limits<int32_t>::min() && r == -1;
+        switch (op) {
+            case OperatorType::PLUS:
+                return makeConstant(location, static_cast<int32_t>(ul + ur));
+            case OperatorType::SUBTRACTION:
+                return makeConstant(location, static_cast<int32_t>(ul - ur));
+            case OperatorType::MULTIPLICATION:
+                return makeConstant(location, static_cast<int32_t>(ul * ur));
+            case OperatorType::DIVISION:
+                if (r == 0) {
+                    return nullptr;
+                }
+                return makeConstant(location, overflows ? l : l / r);
+            case OperatorType::MOD:
+                if (r == 0) {
+                    return nullptr;
+                }
+                return makeConstant(location, overflows ? 0 : l % r);
+            case OperatorType::LESS_THAN:
+                return makeConstant(location, l < r);
+            case OperatorType::LESS_THAN_OR_EQUAL:
+                return makeConstant(location, l <= r);
+            case OperatorType::NOT_EQUAL:
+                return makeConstant(location, l != r);
+            case OperatorType::GREATER_THAN_OR_EQUAL:
+                return makeConstant(location, l >= r);
+            case OperatorType::GREATER_THAN:
+                return makeConstant(location, l > r);
+            case OperatorType::EQUAL:
+                return makeConstant(location, l == r);
+            default:
+                return nullptr;
+        }
+    }
+
+    // At least one real: the integer one is converted first.
+    const float l = toFloat(lhs);
+    const float r = toFloat(rhs);
+    switch (op) {
+        case OperatorType::PLUS:
+            return makeConstant(location, l + r);
+        case OperatorType::SUBTRACTION:
+            return makeConstant(location, l - r);
+        case OperatorType::MULTIPLICATION:
+            return makeConstant(location, l * r);
+        case OperatorType::DIVISION:
+            return makeConstant(location, l / r);
+        case OperatorType::LESS_THAN:
+            return makeConstant(location, l < r);
+        case OperatorType::LESS_THAN_OR_EQUAL:
+            return makeConstant(location, l <= r);
+        case OperatorType::NOT_EQUAL:
+            return makeConstant(location, l != r);
+        case OperatorType::GREATER_THAN_OR_EQUAL:
+            return makeConstant(location, l >= r);
+        case OperatorType::GREATER_THAN:
+            return makeConstant(location, l > r);
+        case OperatorType::EQUAL:
+            return makeConstant(location, l == r);
+        default:
+            return nullptr;
+    }
+}
+
+bool mayCallFunction(const ExpressionNode *expr) {
+    if (dynamic_cast<const FunctionInvocationNode *>(expr) != nullptr) {
+        return true;
+    }
+    if (const auto *binOp = dynamic_cast<const BinaryOperatorNode *>(expr)) {
+        return mayCallFunction(binOp->getLeftOperand()) ||
+               mayCallFunction(binOp->getRightOperand());
+    }
+    if (const auto *unOp = dynamic_cast<const UnaryOperatorNode *>(expr)) {
+        return mayCallFunction(unOp->getOperand());
+    }
+    if (const auto *varRef = dynamic_cast<const VariableReferenceNode *>(expr)) {
+        for (const ExpressionNode *index : varRef->getIndices()) {
+            if (mayCallFunction(index)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+ExpressionNode *ConstantFolder::fold(ExpressionNode *p_expr) {
+    m_replacement = nullptr;
+    p_expr->accept(*this);
+    if (m_replacement == nullptr) {
+        return p_expr;
+    }
+
+    ExpressionNode *replacement = m_replacement;
+    m_replacement = nullptr;
+    delete p_expr;
+    return replacement;
+}
+
+void ConstantFolder::visit(ProgramNode &p_program) {
+    p_program.visitChildNodes(*this);
+}
+
+void ConstantFolder::visit(DeclNode &p_decl) {
+    // constants are declared by literals
+}
+
+void ConstantFolder::visit(FunctionNode &p_function) {
+    p_function.visitChildNodes(*this);
+}
+
+void ConstantFolder::visit(CompoundStatementNode &p_compound_statement) {
+    p_compound_statement.visitChildNodes(*this);
+}
+
+void ConstantFolder::visit(PrintNode &p_print) {
+    p_print.setExpression(fold(const_cast<ExpressionNode *>(p_print.getExpression())));
+}
+
+void ConstantFolder::visit(BinaryOperatorNode &p_bin_op) {
+    p_bin_op.setLeftOperand(fold(p_bin_op.getLeftOperand()));
+    p_bin_op.setRightOperand(fold(p_bin_op.getRightOperand()));
+    ExpressionNode *left = p_bin_op.getLeftOperand();
+    ExpressionNode *right = p_bin_op.getRightOperand();
+    const OperatorType op = p_bin_op.getOperator();
+
+    const ConstantValueNode *leftConstant = asConstant(left);
+    const ConstantValueNode *rightConstant = asConstant(right);
+    if (leftConstant != nullptr && rightConstant != nullptr) {
+        m_replacement = evaluate(p_bin_op.getLocation(), op, leftConstant->getConstVal(),
+                                 rightConstant->getConstVal());
+        return;
+    }
+
+    // - Identities of integers
+    // (x + 0.0 is real, and x * 1.0 may not round-trip an integer through float.)
+
+    if (left->getTypeOfResult().scalarType != ScalarType::INTEGER ||
+        right->getTypeOfResult().scalarType != ScalarType::INTEGER) {
+        return;
+    }
+    const bool keepsLeft = (op == OperatorType::PLUS && isIntConstant(right, 0)) ||
+                           (op == OperatorType::SUBTRACTION && isIntConstant(right, 0)) ||
+                           (op == OperatorType::MULTIPLICATION && isIntConstant(right, 1)) ||
+                           (op == OperatorType::DIVISION && isIntConstant(right, 1));
+    const bool keepsRight = (op == OperatorType::PLUS && isIntConstant(left, 0)) ||
+                            (op == OperatorType::MULTIPLICATION && isIntConstant(left, 1));
+    if (keepsLeft) {
+        p_bin_op.setLeftOperand(nullptr);
+        m_replacement = left;
+    } else if (keepsRight) {
+        p_bin_op.setRightOperand(nullptr);
+        m_replacement = right;
+    } else if (op == OperatorType::MULTIPLICATION &&
+               ((isIntConstant(left, 0) && !mayCallFunction(right)) ||
+                (isIntConstant(right, 0) && !mayCallFunction(left)))) {
+        m_replacement = makeConstant(p_bin_op.getLocation(), 0);
+    }
+}
+
+void ConstantFolder::visit(UnaryOperatorNode &p_un_op) {
+    p_un_op.setOperand(fold(p_un_op.getOperand()));
+    ExpressionNode *operand = p_un_op.getOperand();
+    const OperatorType op = p_un_op.getOperator();
+
+    if (const ConstantValueNode *constant = asConstant(operand)) {
+        const ConstVal val = constant->getConstVal();
+        if (op == OperatorType::NOT && val.scalarType == ScalarType::BOOLEAN) {
+            m_replacement = makeConstant(p_un_op.getLocation(), !val.valContainer.boolean);
+        } else if (op == OperatorType::NEGATION && val.scalarType == ScalarType::INTEGER) {
+            const uint32_t value = static_cast<uint32_t>(val.valContainer.integer);
+            m_replacement = makeConstant(p_un_op.getLocation(), static_cast<int32_t>(0u - value));
+        } else if (op == OperatorType::NEGATION && val.scalarType == ScalarType::REAL) {
+            m_replacement = makeConstant(p_un_op.getLocation(), -toFloat(val));
+        }
+        return;
+    }
+
+    // `not not b` => b, `- -x` => x
+    auto *inner = dynamic_cast<UnaryOperatorNode *>(operand);
+    if (inner != nullptr && inner->getOperator() == op) {
+        m_replacement = inner->getOperand();
+        inner->setOperand(nullptr);
+    }
+}
+
+void ConstantFolder::visit(FunctionInvocationNode &p_func_invocation) {
+    const std::vector<ExpressionNode *> &arguments = p_func_invocation.getArguments();
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        p_func_invocation.setArgument(i, fold(arguments[i]));
+    }
+}
+
+void ConstantFolder::visit(VariableReferenceNode &p_variable_ref) {
+    // (A constant is never assigned or read into, so this is always a use of its value.)
+    if (const ConstVal *constant = p_variable_ref.getConstant()) {
+        m_replacement = makeConstant(p_variable_ref.getLocation(), *constant);
+        return;
+    }
+    const std::vector<ExpressionNode *> &indices = p_variable_ref.getIndices();
+    for (size_t i = 0; i < indices.size(); ++i) {
+        p_variable_ref.setIndex(i, fold(indices[i]));
+    }
+}
+
+void ConstantFolder::visit(AssignmentNode &p_assignment) {
+    p_assignment.getVarRef()->accept(*this);
+    p_assignment.setExpression(fold(p_assignment.getExpression()));
+}
+
+void ConstantFolder::visit(ReadNode &p_read) {
+    p_read.visitChildNodes(*this);
+}
+
+void ConstantFolder::visit(IfNode &p_if) {
+    p_if.setCondition(fold(p_if.getCondition()));
+    p_if.getBody()->accept(*this);
+    if (p_if.getElseBody()) {
+        p_if.getElseBody()->accept(*this);
+    }
+}
+
+void ConstantFolder::visit(WhileNode &p_while) {
+    p_while.setCondition(fold(p_while.getCondition()));
+    p_while.getBody()->accept(*this);
+}
+
+void ConstantFolder::visit(ForNode &p_for) {
+    // the initial value and the bound are literals
+    p_for.getBody()->accept(*this);
+}
+
+void ConstantFolder::visit(ReturnNode &p_return) {
+    p_return.setReturnVal(fold(const_cast<ExpressionNode *>(p_return.getReturnVal())));
+}
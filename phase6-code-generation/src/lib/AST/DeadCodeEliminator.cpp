@@ -0,0 +1,230 @@
+#include "AST/DeadCodeEliminator.hpp"
+#include "AST/BinaryOperator.hpp"
+#include "AST/CompoundStatement.hpp"
+#include "AST/ConstantFolder.hpp"
+#include "AST/ConstantValue.hpp"
+#include "AST/FunctionInvocation.hpp"
+#include "AST/UnaryOperator.hpp"
+#include "AST/VariableReference.hpp"
+#include "AST/assignment.hpp"
+#include "AST/for.hpp"
+#include "AST/function.hpp"
+#include "AST/if.hpp"
+#include "AST/print.hpp"
+#include "AST/program.hpp"
+#include "AST/read.hpp"
+#include "AST/return.hpp"
+#include "AST/while.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/// @return whether control never gets past `stmt`
+static bool alwaysReturns(const AstNode *stmt) {
+    if (dynamic_cast<const ReturnNode *>(stmt) != nullptr) {
+        return true;
+    }
+    if (const auto *compound = dynamic_cast<const CompoundStatementNode *>(stmt)) {
+        const std::vector<AstNode *> &statements = compound->getStatements();
+        return std::any_of(statements.begin(), statements.end(), alwaysReturns);
+    }
+    if (const auto *ifNode = dynamic_cast<const IfNode *>(stmt)) {
+        return ifNode->getElseBody() != nullptr && alwaysReturns(ifNode->getBody()) &&
+               alwaysReturns(ifNode->getElseBody());
+    }
+    return false;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+void DeadCodeEliminator::pushScope(const AstNode *node) {
+    m_symbol_manager.pushScope(std::move(m_symbol_table_of_scoping_nodes.at(node)));
+}
+
+void DeadCodeEliminator::popScope(const AstNode *node) {
+    m_symbol_table_of_scoping_nodes.at(node) = m_symbol_manager.popScope();
+}
+
+void DeadCodeEliminator::eliminateIn(CompoundStatementNode &p_body, const bool upperIsFunction) {
+    m_read_locals.clear();
+    for (const bool removing : {false, true}) {
+        m_removing = removing;
+        m_symbol_manager.upperIsFunction = upperIsFunction;
+        p_body.accept(*this);
+    }
+    m_symbol_manager.upperIsFunction = false;
+}
+
+bool DeadCodeEliminator::isDeadStore(AssignmentNode &p_assignment) {
+    const SymbolEntry *entry =
+        m_symbol_manager.findSymbol(p_assignment.getVarRef()->getNameCString());
+    if (entry == nullptr || entry->level == 0 || !entry->type.arrRefs.empty()) {
+        return false;
+    }
+    if (entry->kind != KindOfSymbol::VARIABLE && entry->kind != KindOfSymbol::PARAMETER) {
+        return false;
+    }
+    return !m_read_locals.count(entry) && !mayCallFunction(p_assignment.getExpression());
+}
+
+AstNode *DeadCodeEliminator::simplify(AstNode *stmt) {
+    if (auto *ifNode = dynamic_cast<IfNode *>(stmt)) {
+        const auto *condition = dynamic_cast<const ConstantValueNode *>(ifNode->getCondition());
+        if (condition == nullptr) {
+            return stmt;
+        }
+        // The arm that runs takes the place of the `if` (with its scope, as a compound statement).
+        const bool holds = condition->getConstVal().valContainer.boolean;
+        CompoundStatementNode *body = ifNode->getBody();
+        CompoundStatementNode *elseBody = ifNode->getElseBody();
+        ifNode->setBodies(holds ? nullptr : body, holds ? elseBody : nullptr);
+        delete ifNode;
+        return holds ? body : elseBody;
+    }
+    if (auto *whileNode = dynamic_cast<WhileNode *>(stmt)) {
+        const auto *condition = dynamic_cast<const ConstantValueNode *>(whileNode->getCondition());
+        if (condition != nullptr && !condition->getConstVal().valContainer.boolean) {
+            delete whileNode;
+            return nullptr;
+        }
+        return stmt;
+    }
+    if (auto *assignment = dynamic_cast<AssignmentNode *>(stmt)) {
+        if (isDeadStore(*assignment)) {
+            delete assignment;
+            return nullptr;
+        }
+    }
+    return stmt;
+}
+
+void DeadCodeEliminator::visit(ProgramNode &p_program) {
+    pushScope(&p_program);
+    for (FunctionNode *function : *p_program.getFunctions()) {
+        function->accept(*this);
+    }
+    eliminateIn(*const_cast<CompoundStatementNode *>(p_program.getBody()), false);
+    popScope(&p_program);
+}
+
+void DeadCodeEliminator::visit(FunctionNode &p_function) {
+    // only declared (e.g. defined in C)
+    if (p_function.getBody() == nullptr) {
+        return;
+    }
+    pushScope(&p_function);
+    eliminateIn(*p_function.getBody(), true);
+    popScope(&p_function);
+}
+
+void DeadCodeEliminator::visit(CompoundStatementNode &p_compound_statement) {
+    const bool upperIsFunction = m_symbol_manager.upperIsFunction;
+    if (upperIsFunction) {
+        m_symbol_manager.upperIsFunction = false;
+    } else {
+        pushScope(&p_compound_statement);
+    }
+
+    if (!m_removing) {
+        p_compound_statement.visitChildNodes(*this);
+    } else {
+        const std::vector<AstNode *> &statements = p_compound_statement.getStatements();
+        std::vector<AstNode *> kept;
+        for (size_t i = 0; i < statements.size(); ++i) {
+            AstNode *stmt = simplify(statements[i]);
+            if (stmt == nullptr) {
+                continue;
+            }
+            stmt->accept(*this);
+            kept.push_back(stmt);
+            if (alwaysReturns(stmt)) {
+                for (size_t j = i + 1; j < statements.size(); ++j) {
+                    delete statements[j];
+                }
+                break;
+            }
+        }
+        p_compound_statement.setStatements(std::move(kept));
+    }
+
+    if (upperIsFunction) {
+        m_symbol_manager.upperIsFunction = true;
+    } else {
+        popScope(&p_compound_statement);
+    }
+}
+
+// - Expressions are only visited to collect the reads
+
+void DeadCodeEliminator::visit(PrintNode &p_print) {
+    if (!m_removing) {
+        p_print.visitChildNodes(*this);
+    }
+}
+
+void DeadCodeEliminator::visit(BinaryOperatorNode &p_bin_op) {
+    p_bin_op.visitChildNodes(*this);
+}
+
+void DeadCodeEliminator::visit(UnaryOperatorNode &p_un_op) {
+    p_un_op.visitChildNodes(*this);
+}
+
+void DeadCodeEliminator::visit(FunctionInvocationNode &p_func_invocation) {
+    if (!m_removing) {
+        p_func_invocation.visitChildNodes(*this);
+    }
+}
+
+void DeadCodeEliminator::visit(VariableReferenceNode &p_variable_ref) {
+    const SymbolEntry *entry = m_symbol_manager.findSymbol(p_variable_ref.getNameCString());
+    if (entry != nullptr) {
+        m_read_locals.insert(entry);
+    }
+    p_variable_ref.visitChildNodes(*this);
+}
+
+void DeadCodeEliminator::visit(AssignmentNode &p_assignment) {
+    // The variable assigned to is not read, but its indices are.
+    if (!m_removing) {
+        p_assignment.getVarRef()->visitChildNodes(*this);
+        p_assignment.getExpression()->accept(*this);
+    }
+}
+
+void DeadCodeEliminator::visit(ReadNode &p_read) {
+    if (!m_removing) {
+        const_cast<VariableReferenceNode *>(p_read.getVarRef())->visitChildNodes(*this);
+    }
+}
+
+void DeadCodeEliminator::visit(IfNode &p_if) {
+    if (!m_removing) {
+        p_if.getCondition()->accept(*this);
+    }
+    p_if.getBody()->accept(*this);
+    if (p_if.getElseBody()) {
+        p_if.getElseBody()->accept(*this);
+    }
+}
+
+void DeadCodeEliminator::visit(WhileNode &p_while) {
+    if (!m_removing) {
+        p_while.getCondition()->accept(*this);
+    }
+    p_while.getBody()->accept(*this);
+}
+
+void DeadCodeEliminator::visit(ForNode &p_for) {
+    pushScope(&p_for);
+    // the initial value and the bound are literals
+    p_for.getBody()->accept(*this);
+    popScope(&p_for);
+}
+
+void DeadCodeEliminator::visit(ReturnNode &p_return) {
+    if (!m_removing) {
+        p_return.visitChildNodes(*this);
+    }
+}
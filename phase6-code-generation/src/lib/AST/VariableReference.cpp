@@ -19,6 +19,13 @@ void VariableReferenceNode::addInnerIndex(ExpressionNode *p_index) {
 const std::vector<ExpressionNode *> &VariableReferenceNode::getIndices() const {
     return m_indices;
 }
+void VariableReferenceNode::setIndex(size_t index, ExpressionNode *p_index) {
+    m_indices[index] = p_index;
+}
+
+void VariableReferenceNode::setConstant(const ConstVal &p_constant) {
+    m_constant.reset(new ConstVal(p_constant));
+}
 
 void VariableReferenceNode::visitChildNodes(AstNodeVisitor &p_visitor) {
     // hw3 work
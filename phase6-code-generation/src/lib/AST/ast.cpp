@@ -36,6 +36,17 @@ std::string Type::typeToString() const {
     return typeSs.str();
 }
 
+int Type::getSizeInBytes() const {
+    return arrRefs.empty() ? 4 : arrRefs.front() * getStrideOf(0);
+}
+int Type::getStrideOf(const size_t dim) const {
+    int stride = 4;
+    for (size_t i = dim + 1; i < arrRefs.size(); i++) {
+        stride *= arrRefs[i];
+    }
+    return stride;
+}
+
 // prevent the linker from complaining
 AstNode::~AstNode() {}
 
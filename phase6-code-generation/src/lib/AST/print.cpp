@@ -12,6 +12,9 @@ void PrintNode::visitChildNodes(AstNodeVisitor &p_visitor) {
 const ExpressionNode *PrintNode::getExpression() const {
     return m_expression;
 }
+void PrintNode::setExpression(ExpressionNode *p_expression) {
+    m_expression = p_expression;
+}
 
 PrintNode::~PrintNode() {
     delete m_expression;
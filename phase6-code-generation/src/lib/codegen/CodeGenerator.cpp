@@ -3,6 +3,8 @@
 #include "AST/function.hpp"
 #include "AST/program.hpp"
 #include "codegen/CodeGenerator.hpp"
+#include "codegen/StrengthReduction.hpp"
+#include "codegen/TreePatterns.hpp"
 #include "sema/SemanticAnalyzer.hpp"
 #include "sema/SymbolTable.hpp"
 #include "visitor/AstNodeInclude.hpp"
@@ -11,17 +13,26 @@
 #include <cassert>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 CodeGenerator::CodeGenerator(const std::string &source_file_name, const std::string &save_path,
                              std::unordered_map<SemanticAnalyzer::AstNodeAddr, SymbolManager::Table>
-                                 &&p_symbol_table_of_scoping_nodes)
+                                 &&p_symbol_table_of_scoping_nodes,
+                             const CompilerOptions &p_options)
     : m_source_file_path(source_file_name),
       m_symbol_table_of_scoping_nodes(std::move(p_symbol_table_of_scoping_nodes)),
+      m_options(p_options),
       nextL(1) {
+    m_output_file.reset(openAssemblyFile(source_file_name, save_path));
+}
+
+std::string getAssemblyFilePath(const std::string &source_file_name, const std::string &save_path) {
     // FIXME: assume that the source file is always xxxx.p
     const auto &real_path = save_path.empty() ? std::string{"."} : save_path;
     auto slash_pos = source_file_name.rfind('/');
@@ -32,10 +43,14 @@ CodeGenerator::CodeGenerator(const std::string &source_file_name, const std::str
     } else {
         slash_pos = 0;
     }
-    auto output_file_path{real_path + "/" +
-                          source_file_name.substr(slash_pos, dot_pos - slash_pos) + ".S"};
-    m_output_file.reset(fopen(output_file_path.c_str(), "w"));
-    assert(m_output_file.get() && "Failed to open output file");
+    return real_path + "/" + source_file_name.substr(slash_pos, dot_pos - slash_pos) + ".S";
+}
+
+FILE *openAssemblyFile(const std::string &source_file_name, const std::string &save_path) {
+    const auto output_file_path = getAssemblyFilePath(source_file_name, save_path);
+    FILE *output_file = fopen(output_file_path.c_str(), "w");
+    assert(output_file && "Failed to open output file");
+    return output_file;
 }
 
 static void dumpInstructions(FILE *p_out_file, const char *format, ...) {
@@ -47,11 +62,18 @@ static void dumpInstructions(FILE *p_out_file, const char *format, ...) {
 
 std::string getImmediateInString(const ConstVal &constVal) {
     switch (constVal.scalarType) {
-        case ScalarType::INTEGER:
-        case ScalarType::REAL: {
+        case ScalarType::INTEGER: {
             return constVal.getConstValInString();
             break;
         }
+        case ScalarType::REAL: {
+            // enough digits to read back the same single-precision value
+            // (a folded constant may need more than the 6 decimals of std::to_string)
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%.9g", static_cast<float>(constVal.valContainer.real));
+            return buf;
+            break;
+        }
         case ScalarType::STRING: {
             std::string s = constVal.getConstValInString();
             std::string out;
@@ -84,6 +106,290 @@ std::string getImmediateInString(const VariableNode *variableNode) {
     return getImmediateInString(variableNode->getConstValueNode());
 }
 
+/**
+ * Finds out whether a function body calls anything, and whether it calls the function itself.
+ * print and read call the runtime (printInt, readInt, ...), so they count as calls.
+ */
+class CallFinder final : public AstNodeVisitor {
+   public:
+    explicit CallFinder(const std::string &p_self_name) : m_self_name(p_self_name) {}
+
+    bool foundCall = false;
+    bool foundSelfCall = false;
+
+    void visit(CompoundStatementNode &p_compound_statement) override {
+        p_compound_statement.visitChildNodes(*this);
+    }
+    void visit(PrintNode &p_print) override {
+        foundCall = true;
+    }
+    void visit(BinaryOperatorNode &p_bin_op) override {
+        p_bin_op.visitChildNodes(*this);
+    }
+    void visit(UnaryOperatorNode &p_un_op) override {
+        p_un_op.visitChildNodes(*this);
+    }
+    void visit(FunctionInvocationNode &p_func_invocation) override {
+        foundCall = true;
+        if (m_self_name == p_func_invocation.getNameCString()) {
+            foundSelfCall = true;
+        }
+        p_func_invocation.visitChildNodes(*this);
+    }
+    void visit(VariableReferenceNode &p_variable_ref) override {
+        p_variable_ref.visitChildNodes(*this);
+    }
+    void visit(AssignmentNode &p_assignment) override {
+        p_assignment.visitChildNodes(*this);
+    }
+    void visit(ReadNode &p_read) override {
+        foundCall = true;
+    }
+    void visit(IfNode &p_if) override {
+        p_if.visitChildNodes(*this);
+    }
+    void visit(WhileNode &p_while) override {
+        p_while.visitChildNodes(*this);
+    }
+    void visit(ForNode &p_for) override {
+        p_for.visitChildNodes(*this);
+    }
+    void visit(ReturnNode &p_return) override {
+        p_return.visitChildNodes(*this);
+    }
+
+   private:
+    std::string m_self_name;
+};
+
+/// Collects the names of the variables a subtree references (reads, assigns or reads into).
+class ReferenceFinder final : public AstNodeVisitor {
+   public:
+    std::unordered_set<std::string> names;
+
+    void visit(CompoundStatementNode &p_compound_statement) override {
+        p_compound_statement.visitChildNodes(*this);
+    }
+    void visit(PrintNode &p_print) override {
+        p_print.visitChildNodes(*this);
+    }
+    void visit(BinaryOperatorNode &p_bin_op) override {
+        p_bin_op.visitChildNodes(*this);
+    }
+    void visit(UnaryOperatorNode &p_un_op) override {
+        p_un_op.visitChildNodes(*this);
+    }
+    void visit(FunctionInvocationNode &p_func_invocation) override {
+        p_func_invocation.visitChildNodes(*this);
+    }
+    void visit(VariableReferenceNode &p_variable_ref) override {
+        names.insert(p_variable_ref.getNameCString());
+        p_variable_ref.visitChildNodes(*this);
+    }
+    void visit(AssignmentNode &p_assignment) override {
+        p_assignment.visitChildNodes(*this);
+    }
+    void visit(ReadNode &p_read) override {
+        p_read.visitChildNodes(*this);
+    }
+    void visit(IfNode &p_if) override {
+        p_if.visitChildNodes(*this);
+    }
+    void visit(WhileNode &p_while) override {
+        p_while.visitChildNodes(*this);
+    }
+    void visit(ForNode &p_for) override {
+        p_for.visitChildNodes(*this);
+    }
+    void visit(ReturnNode &p_return) override {
+        p_return.visitChildNodes(*this);
+    }
+};
+
+/**
+ * Finds out how deeply the for loops of a function body nest, and which loops read their loop
+ * variable. A loop variable cannot be redeclared inside its loop, so a reference by the same
+ * name always refers to it.
+ */
+class ForLoopFinder final : public AstNodeVisitor {
+   public:
+    int maxDepth = 0;
+    std::unordered_map<const ForNode *, bool> readsLoopVar;
+
+    void visit(CompoundStatementNode &p_compound_statement) override {
+        p_compound_statement.visitChildNodes(*this);
+    }
+    void visit(PrintNode &p_print) override {
+        p_print.visitChildNodes(*this);
+    }
+    void visit(BinaryOperatorNode &p_bin_op) override {
+        p_bin_op.visitChildNodes(*this);
+    }
+    void visit(UnaryOperatorNode &p_un_op) override {
+        p_un_op.visitChildNodes(*this);
+    }
+    void visit(FunctionInvocationNode &p_func_invocation) override {
+        p_func_invocation.visitChildNodes(*this);
+    }
+    void visit(VariableReferenceNode &p_variable_ref) override {
+        for (const ForNode *loop : m_loops) {
+            if (strcmp(loop->getLoopVar()->getNameCString(), p_variable_ref.getNameCString()) == 0) {
+                readsLoopVar[loop] = true;
+            }
+        }
+        p_variable_ref.visitChildNodes(*this);
+    }
+    void visit(AssignmentNode &p_assignment) override {
+        p_assignment.visitChildNodes(*this);
+    }
+    void visit(IfNode &p_if) override {
+        p_if.visitChildNodes(*this);
+    }
+    void visit(WhileNode &p_while) override {
+        p_while.visitChildNodes(*this);
+    }
+    void visit(ForNode &p_for) override {
+        readsLoopVar[&p_for] = false;
+        m_loops.push_back(&p_for);
+        maxDepth = std::max(maxDepth, static_cast<int>(m_loops.size()));
+        p_for.getBody()->accept(*this);
+        m_loops.pop_back();
+    }
+    void visit(ReturnNode &p_return) override {
+        p_return.visitChildNodes(*this);
+    }
+
+   private:
+    /// the loops around the node being visited
+    std::vector<const ForNode *> m_loops;
+};
+
+/// @return the frame size for `sizeOfLocals` bytes below s0, kept 16-byte aligned as the ABI requires
+static int getFrameSize(const int sizeOfLocals) {
+    return (sizeOfLocals + 15) / 16 * 16;
+}
+
+/// at most s1 ~ s11 hold the counters of nested for loops
+static const int kMaxCounterRegs = 11;
+
+void CodeGenerator::planFrame(CompoundStatementNode &p_body, const int sizeOfLocals) {
+    ForLoopFinder forLoopFinder;
+    p_body.accept(forLoopFinder);
+    m_loop_reads_counter = std::move(forLoopFinder.readsLoopVar);
+    m_num_counter_regs =
+        m_options.loopCounterRegisters ? std::min(forLoopFinder.maxDepth, kMaxCounterRegs) : 0;
+    m_counter_depth = 0;
+    // The saved s1, s2, ... go at the bottom of the frame, within reach of sp however large the
+    // frame is.
+    m_frame_size = getFrameSize(sizeOfLocals + 4 * m_num_counter_regs);
+}
+
+/// the largest immediate of an I-type instruction (addi, lw, sw, ...)
+static const int kMaxImmediate = 2047;
+
+static bool fitsInImmediate(const int value) {
+    return value >= -kMaxImmediate - 1 && value <= kMaxImmediate;
+}
+
+/// @brief Dumps `rd = rs + imm`, with t1 holding `imm` if it does not fit in an addi.
+static void dumpAddImmediate(FILE *p_out_file, const char *rd, const char *rs, const int imm) {
+    if (fitsInImmediate(imm)) {
+        dumpInstructions(p_out_file, "    addi %s, %s, %d\n", rd, rs, imm);
+    } else {
+        dumpInstructions(p_out_file, "    li t1, %d\n    add %s, %s, t1\n", imm, rd, rs);
+    }
+}
+
+void CodeGenerator::allocateFrame() {
+    if (m_frame_size <= kMaxImmediate) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_allocate_frame =
+            "    addi sp, sp, -%d    # move stack pointer to lower address to allocate a new stack\n";
+        constexpr const char *const riscv_assembly_save_ra =
+            "    sw ra, %d(sp)       # save return address of the caller function in the current stack\n";
+        constexpr const char *const riscv_assembly_frame_pointer =
+            "    sw s0, %d(sp)       # save frame pointer of the last stack in the current stack\n"
+            "    addi s0, sp, %d     # move frame pointer to the bottom of the current stack\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_allocate_frame, m_frame_size);
+        if (!m_skips_ra) {
+            dumpInstructions(m_output_file.get(), riscv_assembly_save_ra, m_frame_size - 4);
+        }
+        dumpInstructions(m_output_file.get(), riscv_assembly_frame_pointer, m_frame_size - 8,
+                         m_frame_size);
+    } else {
+        // clang-format off
+        constexpr const char *const riscv_assembly_allocate_frame =
+            "    mv t0, sp\n"
+            "    li t1, %d\n"
+            "    sub sp, sp, t1      # move stack pointer to lower address to allocate a new stack\n";
+        constexpr const char *const riscv_assembly_save_ra =
+            "    sw ra, -4(t0)       # save return address of the caller function in the current stack\n";
+        constexpr const char *const riscv_assembly_frame_pointer =
+            "    sw s0, -8(t0)       # save frame pointer of the last stack in the current stack\n"
+            "    mv s0, t0           # move frame pointer to the bottom of the current stack\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_allocate_frame, m_frame_size);
+        if (!m_skips_ra) {
+            dumpInstructions(m_output_file.get(), riscv_assembly_save_ra);
+        }
+        dumpInstructions(m_output_file.get(), riscv_assembly_frame_pointer);
+    }
+    saveCounterRegs();
+}
+
+void CodeGenerator::freeFrame() {
+    restoreCounterRegs();
+    if (m_frame_size <= kMaxImmediate) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_restore_ra =
+            "    lw ra, %d(sp)       # load return address saved in the current stack\n";
+        constexpr const char *const riscv_assembly_free_frame =
+            "    lw s0, %d(sp)       # move frame pointer back to the bottom of the last stack\n"
+            "    addi sp, sp, %d     # move stack pointer back to the top of the last stack\n";
+        // clang-format on
+        if (!m_skips_ra) {
+            dumpInstructions(m_output_file.get(), riscv_assembly_restore_ra, m_frame_size - 4);
+        }
+        dumpInstructions(m_output_file.get(), riscv_assembly_free_frame, m_frame_size - 8,
+                         m_frame_size);
+    } else {
+        // clang-format off
+        constexpr const char *const riscv_assembly_restore_ra =
+            "    lw ra, -4(s0)       # load return address saved in the current stack\n";
+        constexpr const char *const riscv_assembly_free_frame =
+            "    mv sp, s0           # move stack pointer back to the top of the last stack\n"
+            "    lw s0, -8(sp)       # move frame pointer back to the bottom of the last stack\n";
+        // clang-format on
+        if (!m_skips_ra) {
+            dumpInstructions(m_output_file.get(), riscv_assembly_restore_ra);
+        }
+        dumpInstructions(m_output_file.get(), riscv_assembly_free_frame);
+    }
+}
+
+void CodeGenerator::saveCounterRegs() {
+    for (int reg = 1; reg <= m_num_counter_regs; ++reg) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_save_counter_reg =
+            "    sw s%d, %d(sp)       # save s%d, which holds a loop counter here\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_save_counter_reg, reg, 4 * (reg - 1),
+                         reg);
+    }
+}
+
+void CodeGenerator::restoreCounterRegs() {
+    for (int reg = 1; reg <= m_num_counter_regs; ++reg) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_restore_counter_reg =
+            "    lw s%d, %d(sp)       # restore s%d of the caller\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_restore_counter_reg, reg,
+                         4 * (reg - 1), reg);
+    }
+}
+
 /* ------------------------------------------------------------------------------------------------- */
 
 void CodeGenerator::visit(ProgramNode &p_program) {
@@ -112,9 +418,13 @@ void CodeGenerator::visit(ProgramNode &p_program) {
 
     // main function
     /**
-     * We allocate 128 bytes for convenience.
-     * In hw5, allocate 128 bytes of local memories is sufficient for the parameters and the local variables.
+     * The frame holds ra, s0 and the deepest local slot the body uses (counted by the semantic
+     * analyzer), rounded up to 16 bytes.
      */
+    planFrame(*const_cast<CompoundStatementNode *>(p_program.getBody()),
+              m_symbol_table_of_scoping_nodes.at(p_program.getBody())->sizeOfLocals);
+    m_function = nullptr;
+    m_skips_ra = false;
     // clang-format off
     constexpr const char *const riscv_assembly_main_func =
         "    .section    .text\n"
@@ -122,27 +432,24 @@ void CodeGenerator::visit(ProgramNode &p_program) {
         "    .globl main          # emit symbol 'main' to the global symbol table\n"
         "    .type main, @function\n"
         "main:\n"
-        "    # in the function prologue\n"
-        "    addi sp, sp, -128    # move stack pointer to lower address to allocate a new stack\n"
-        "    sw ra, 124(sp)       # save return address of the caller function in the current stack\n"
-        "    sw s0, 120(sp)       # save frame pointer of the last stack in the current stack\n"
-        "    addi s0, sp, 128     # move frame pointer to the bottom of the current stack\n";
+        "    # in the function prologue\n";
     // clang-format on
     dumpInstructions(m_output_file.get(), riscv_assembly_main_func);
+    allocateFrame();
 
     const_cast<CompoundStatementNode *>(p_program.getBody())->accept(*this);
 
     // clang-format off
     constexpr const char *const riscv_assembly_main_func_epilogue = 
-        "    # in the function epilogue\n"
-        "    lw ra, 124(sp)       # load return address saved in the current stack\n"
-        "    lw s0, 120(sp)       # move frame pointer back to the bottom of the last stack\n"
-        "    addi sp, sp, 128     # move stack pointer back to the top of the last stack\n"
         "    jr ra                # jump back to the caller function\n"
         "    .size main, .-main\n";
     // clang-format on
+    dumpInstructions(m_output_file.get(), "    # in the function epilogue\n");
+    freeFrame();
     dumpInstructions(m_output_file.get(), riscv_assembly_main_func_epilogue);
 
+    m_constant_pool.dump(m_output_file.get());
+
     /* Step 4: Pop scope                                        */
 
     m_symbol_manager.popScope();
@@ -174,15 +481,22 @@ void CodeGenerator::visit(VariableNode &p_variable) {
 
     // No child needs visiting for codegen; const value is handled explicitly below.
 
+    // Every reference to a constant has been replaced by its value (see ConstantFolder), so
+    // nothing needs to hold it at run time.
+    if (m_options.foldConstants && p_variable.getConstValueNode() != nullptr) {
+        return;
+    }
+
     if (m_symbol_manager.currlvl == 0) {
         // global var
         if (p_variable.getConstValueNode() == nullptr) {
             // clang-format off
             constexpr const char *const riscv_assembly_global_var =
-                "    .comm %s, 4, 4            # emit object '%s' to .bss section with size = 4, align = 4\n";
+                "    .comm %s, %d, 4            # emit object '%s' to .bss section with size = %d, align = 4\n";
             // clang-format on
+            const int size = p_variable.getType().getSizeInBytes();
             dumpInstructions(m_output_file.get(), riscv_assembly_global_var,
-                             p_variable.getNameCString(), p_variable.getNameCString());
+                             p_variable.getNameCString(), size, p_variable.getNameCString(), size);
         }
         // global const
         else {
@@ -191,19 +505,6 @@ void CodeGenerator::visit(VariableNode &p_variable) {
 
             bool isReal = constVal.scalarType == ScalarType::REAL;
             bool isString = constVal.scalarType == ScalarType::STRING;
-            if (isReal || isString) {
-                // clang-format off
-                constexpr const char *const riscv_assembly_global_const_string =
-                    "    .section    .rodata       # emit rodata section\n"
-                    "    .align 2\n"
-                    ".LC%d:\n"
-                    "    .%s %s\n";
-                // clang-format on
-                const char *directive = isReal ? "float" : "string";
-                dumpInstructions(m_output_file.get(), riscv_assembly_global_const_string,
-                                 getNextL(), directive, immediate.c_str());
-                nextL_add(1);
-            }
 
             // clang-format off
             constexpr const char *const riscv_assembly_global_const =
@@ -212,12 +513,14 @@ void CodeGenerator::visit(VariableNode &p_variable) {
                 "    .globl %s              # emit symbol '%s' to the global symbol table\n"
                 "    .type %s, @object\n"
                 "%s:\n"
-                "    .word %s\n";
+                "    .%s %s\n";
             // clang-format on
-            std::string content = isString ? ".LC" + std::to_string(getNextL() - 1) : immediate;
+            // A string constant holds the address of the string, in the constant pool.
+            const char *directive = isReal ? "float" : "word";
+            std::string content = isString ? m_constant_pool.getLabelOf(constVal) : immediate;
             dumpInstructions(m_output_file.get(), riscv_assembly_global_const,
                              p_variable.getNameCString(), p_variable.getNameCString(),
-                             p_variable.getNameCString(), p_variable.getNameCString(),
+                             p_variable.getNameCString(), p_variable.getNameCString(), directive,
                              content.c_str());
         }
     }
@@ -274,25 +577,10 @@ void CodeGenerator::visit(ConstantValueNode &p_constant_value) {
     ScalarType scalarType = p_constant_value.getConstVal().scalarType;
     std::string immediate = getImmediateInString(&p_constant_value);
 
+    // A real or string lives in the constant pool, emitted at the end of the file.
+    const char *label = nullptr;
     if (scalarType == ScalarType::REAL || scalarType == ScalarType::STRING) {
-        // clang-format off
-        constexpr const char *const riscv_assembly_constVal_load_str =
-        // value
-            "    j .L%d\n"
-            "    .section    .rodata\n"
-            "    .align 2\n"
-            ".LC%d:\n"
-            "    .%s %s\n"
-            
-        // get address 
-            "    .section    .text\n"
-            ".L%d:\n";
-        // clang-format on
-        int labelNo = getNextL();
-        nextL_add(1);
-        const char *directive = (scalarType == ScalarType::REAL) ? "float" : "string";
-        dumpInstructions(m_output_file.get(), riscv_assembly_constVal_load_str, labelNo, labelNo,
-                         directive, immediate.c_str(), labelNo);
+        label = m_constant_pool.getLabelOf(p_constant_value.getConstVal()).c_str();
     }
 
     // Load value(address for string) to register
@@ -310,19 +598,18 @@ void CodeGenerator::visit(ConstantValueNode &p_constant_value) {
         case ScalarType::REAL: {
             // clang-format off
             constexpr const char *const riscv_assembly_constVal_load_real =
-                "    lui t0, %%hi(.LC%d)       # load the upper 20 bits of address of the label\n"
-                "    flw ft0, %%lo(.LC%d)(t0)\n";
+                "    lui t0, %%hi(%s)       # load the upper 20 bits of address of the label\n"
+                "    flw ft0, %%lo(%s)(t0)\n";
             // clang-format on
-            dumpInstructions(m_output_file.get(), riscv_assembly_constVal_load_real, getNextL() - 1,
-                             getNextL() - 1);
+            dumpInstructions(m_output_file.get(), riscv_assembly_constVal_load_real, label, label);
             break;
         }
         case ScalarType::STRING: {
             // clang-format off
             constexpr const char *const riscv_assembly_constVal_load_str =
-                "    la t0, .LC%d\n";
+                "    la t0, %s\n";
             // clang-format on
-            dumpInstructions(m_output_file.get(), riscv_assembly_constVal_load_str, getNextL() - 1);
+            dumpInstructions(m_output_file.get(), riscv_assembly_constVal_load_str, label);
             break;
         }
         default: {
@@ -355,6 +642,25 @@ void CodeGenerator::visit(ConstantValueNode &p_constant_value) {
 void CodeGenerator::visit(FunctionNode &p_function) {
     /* Step 1: Ouput assembly                                   */
 
+    planFrame(*p_function.getBody(),
+              m_symbol_table_of_scoping_nodes.at(&p_function)->sizeOfLocals);
+    m_epilogue_label = getNextL();
+    nextL_add(1);
+    // A leaf never overwrites ra. (Its slot at s0 - 4 stays unused, since the semantic
+    // analyzer has laid out the locals already; s0 is still needed, as sp moves with every
+    // push/pop of the stack machine.)
+    CallFinder callFinder(p_function.getNameCString());
+    p_function.getBody()->accept(callFinder);
+    m_skips_ra = m_options.omitFramePointer && !callFinder.foundCall;
+    m_function = &p_function;
+    m_params.clear();
+    // A self tail call jumps back to the body, right after the parameters are saved.
+    m_body_label = 0;
+    if (m_options.tailCalls && callFinder.foundSelfCall) {
+        m_body_label = getNextL();
+        nextL_add(1);
+    }
+
     // clang-format off
     constexpr const char *const riscv_assembly_func =
         "    .section    .text\n"
@@ -362,15 +668,12 @@ void CodeGenerator::visit(FunctionNode &p_function) {
         "    .globl %s          # emit symbol '%s' to the global symbol table\n"
         "    .type %s, @function\n"
         "%s:\n"
-        "    # in the function prologue\n"
-        "    addi sp, sp, -128    # move stack pointer to lower address to allocate a new stack\n"
-        "    sw ra, 124(sp)       # save return address of the caller function in the current stack\n"
-        "    sw s0, 120(sp)       # save frame pointer of the last stack in the current stack\n"
-        "    addi s0, sp, 128     # move frame pointer to the bottom of the current stack\n";
+        "    # in the function prologue\n";
     // clang-format on
     dumpInstructions(m_output_file.get(), riscv_assembly_func, p_function.getNameCString(),
                      p_function.getNameCString(), p_function.getNameCString(),
                      p_function.getNameCString());
+    allocateFrame();
 
     /* Step 2: Push scope                                       */
 
@@ -387,6 +690,8 @@ void CodeGenerator::visit(FunctionNode &p_function) {
      *   - Remaining arguments are pushed (right to left) onto the caller's stack frame.
      * Here in the callee we:
      *   1. Copy each register argument into its slot in our local frame (relative to s0).
+     *      A scalar one that no call can overwrite before it is last referenced stays in its
+     *      register instead.
      *   2. For stack arguments, load them from the caller's frame (still reachable via s0)
      *      and store them into the matching slot in our own frame.
      */
@@ -410,10 +715,34 @@ void CodeGenerator::visit(FunctionNode &p_function) {
         }
     }
 
+    // The parameters referenced from the first statement making a call (print and read
+    // included) on must be in their slots; so must all of them if a self tail call restarts the
+    // body, which assigns the slots.
+    const bool keepsParamsInRegs = m_options.registerArguments && m_body_label == 0;
+    ReferenceFinder referencedAfterCall;
+    bool foundCall = false;
+    for (AstNode *statement : p_function.getBody()->getStatements()) {
+        CallFinder statementCalls(p_function.getNameCString());
+        statement->accept(statementCalls);
+        foundCall = foundCall || statementCalls.foundCall;
+        if (foundCall) {
+            statement->accept(referencedAfterCall);
+        }
+    }
+    m_arg_reg_of_param.clear();
     for (int paramIdx = 0; paramIdx < numOfParam; paramIdx++) {
+        m_params.push_back(&currTable[paramIdx]);
         const ParamLoc &loc = paramLocs[paramIdx];
         const int addrInCallee = currTable[paramIdx].addrOfLocal;
 
+        if (keepsParamsInRegs && loc.kind != ParamLoc::Kind::Stack &&
+            currTable[paramIdx].type.arrRefs.empty() &&
+            !referencedAfterCall.names.count(currTable[paramIdx].name)) {
+            m_arg_reg_of_param[&currTable[paramIdx]] = loc.index;
+            continue;
+        }
+
+        // (An array parameter is the address of the array, and is saved like an integer.)
         if (currTable[paramIdx].type.isSameType(ScalarType::REAL)) {
             if (loc.kind == ParamLoc::Kind::FloatReg) {  // float parameters in fa0 - fa7
                 // clang-format off
@@ -451,23 +780,29 @@ void CodeGenerator::visit(FunctionNode &p_function) {
         }
     }
 
+    if (m_body_label != 0) {
+        dumpInstructions(m_output_file.get(), ".L%d:\n", m_body_label);
+    }
     p_function.visitChildNodes(*this);
 
     // clang-format off
+    // Every return jumps here.
     constexpr const char *const riscv_assembly_func_epilogue = 
-        "    # in the function epilogue\n"
-        "    lw ra, 124(sp)       # load return address saved in the current stack\n"
-        "    lw s0, 120(sp)       # move frame pointer back to the bottom of the last stack\n"
-        "    addi sp, sp, 128     # move stack pointer back to the top of the last stack\n"
+        ".L%d:\n"
+        "    # in the function epilogue\n";
+    constexpr const char *const riscv_assembly_func_return =
         "    jr ra                # jump back to the caller function\n"
         "    .size %s, .-%s\n";
     // clang-format on
-    dumpInstructions(m_output_file.get(), riscv_assembly_func_epilogue, p_function.getNameCString(),
+    dumpInstructions(m_output_file.get(), riscv_assembly_func_epilogue, m_epilogue_label);
+    freeFrame();
+    dumpInstructions(m_output_file.get(), riscv_assembly_func_return, p_function.getNameCString(),
                      p_function.getNameCString());
 
     /* Step 4: Pop scope                                        */
 
     // Remove the entries in the hash table
+    m_arg_reg_of_param.clear();
     m_symbol_manager.popScope();
     m_symbol_manager.upperIsFunction = false;
 }
@@ -566,6 +901,244 @@ void CodeGenerator::visit(PrintNode &p_print) {
     // x
 }
 
+void CodeGenerator::popFloatOperands(const bool leftOperandIsReal, const bool rightOperandIsReal) {
+    if (rightOperandIsReal) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_right =
+            "    flw ft0, 0(sp)      # pop the value(of right operand) from the stack\n"
+            "    addi sp, sp, 4\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_right);
+
+    } else {
+        // Coercion(int -> real)
+        // clang-format off
+        constexpr const char *const riscv_assembly_right_is_int =
+            "    lw t0, 0(sp)      # pop the value(of right operand) from the stack\n"
+            "    addi sp, sp, 4\n"
+            "    fcvt.s.w ft0, t0        # Convert integer in t0 to float in ft0\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_right_is_int);
+    }
+    /// NOTE: same as above
+    if (leftOperandIsReal) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_left =
+            "    flw ft1, 0(sp)      # pop the value(of left operand) from the stack\n"
+            "    addi sp, sp, 4\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_left);
+    } else {
+        // Coercion(int -> real)
+        // clang-format off
+        constexpr const char *const riscv_assembly_left_is_int =
+            "    lw t1, 0(sp)      # pop the value(of left operand) from the stack\n"
+            "    addi sp, sp, 4\n"
+            "    fcvt.s.w ft1, t1        # Convert integer in t1 to float in ft1\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_left_is_int);
+    }
+}
+
+/// @return the operand as the rules of codegen/TreePatterns.hpp see it
+static PatternOperand getPatternOperandOf(ExpressionNode *p_expr) {
+    const auto *constant = dynamic_cast<const ConstantValueNode *>(p_expr);
+    if (constant == nullptr) {
+        return {};
+    }
+    const ConstVal &constVal = constant->getConstVal();
+    if (constVal.scalarType == ScalarType::INTEGER) {
+        return {true, constVal.valContainer.integer};
+    }
+    if (constVal.scalarType == ScalarType::BOOLEAN) {
+        return {true, constVal.valContainer.boolean ? 1 : 0};
+    }
+    return {};
+}
+
+static PatternOp getPatternOpOf(const OperatorType op) {
+    switch (op) {
+        case OperatorType::PLUS:
+            return PatternOp::ADD;
+        case OperatorType::SUBTRACTION:
+            return PatternOp::SUB;
+        case OperatorType::MULTIPLICATION:
+            return PatternOp::MUL;
+        case OperatorType::DIVISION:
+            return PatternOp::DIV;
+        case OperatorType::MOD:
+            return PatternOp::REM;
+        case OperatorType::LESS_THAN:
+            return PatternOp::LT;
+        case OperatorType::LESS_THAN_OR_EQUAL:
+            return PatternOp::LE;
+        case OperatorType::NOT_EQUAL:
+            return PatternOp::NE;
+        case OperatorType::GREATER_THAN_OR_EQUAL:
+            return PatternOp::GE;
+        case OperatorType::GREATER_THAN:
+            return PatternOp::GT;
+        case OperatorType::EQUAL:
+            return PatternOp::EQ;
+        case OperatorType::AND:
+            return PatternOp::AND;
+        case OperatorType::OR:
+            return PatternOp::OR;
+        default:
+            printf("Unknown bin op\n");
+            exit(1);
+    }
+}
+
+void CodeGenerator::generateByPattern(BinaryOperatorNode &p_bin_op) {
+    ExpressionNode *operands[2] = {p_bin_op.getLeftOperand(), p_bin_op.getRightOperand()};
+    const PatternOperand leaves[2] = {getPatternOperandOf(operands[0]),
+                                      getPatternOperandOf(operands[1])};
+    const PatternCover cover = coverBinary(getPatternOpOf(p_bin_op.getOperator()), leaves[0],
+                                           leaves[1]);
+    const OperandKind kinds[2] = {cover.rule->left, cover.rule->right};
+
+    // Only the operands computed at run time are pushed: the left one ends up in t1, the right
+    // one in t0, and a constant matched as a register is loaded there instead.
+    bool isPushed[2];
+    for (int k = 0; k < 2; ++k) {
+        isPushed[k] = kinds[k] == OperandKind::REG && !leaves[k].isConstant;
+        if (isPushed[k]) {
+            operands[k]->accept(*this);
+        }
+    }
+    // clang-format off
+    constexpr const char *const riscv_assembly_pop_operand =
+        "    lw %s, 0(sp)      # pop the value(of %s operand) from the stack\n"
+        "    addi sp, sp, 4\n";
+    // clang-format on
+    std::string regs[2] = {"t1", "t0"};
+    for (int k = 1; k >= 0; --k) {
+        if (isPushed[k]) {
+            dumpInstructions(m_output_file.get(), riscv_assembly_pop_operand, regs[k].c_str(),
+                             k == 0 ? "left" : "right");
+        } else if (kinds[k] == OperandKind::REG && isInZeroReg(leaves[k])) {
+            regs[k] = "zero";
+        } else if (kinds[k] == OperandKind::REG) {
+            dumpInstructions(m_output_file.get(), "    li %s, %d\n", regs[k].c_str(),
+                             leaves[k].value);
+        }
+    }
+
+    const auto getReg = [&regs](const int patReg) {
+        switch (patReg) {
+            case kPatLeft:
+                return regs[0];
+            case kPatRight:
+                return regs[1];
+            case kPatResult:
+                return std::string("t0");
+            default:
+                return std::string("zero");
+        }
+    };
+    for (const PatternStep &step : cover.rule->steps) {
+        if (step.format == MachineFormat::R) {
+            dumpInstructions(m_output_file.get(), "    %s t0, %s, %s\n", step.opcode,
+                             getReg(step.rs1).c_str(), getReg(step.rs2).c_str());
+        } else {
+            dumpInstructions(m_output_file.get(), "    %s t0, %s, %d\n", step.opcode,
+                             getReg(step.rs1).c_str(),
+                             step.imm == kPatConstant ? cover.imm : step.imm);
+        }
+    }
+
+    // clang-format off
+    constexpr const char *const riscv_assembly_bin_op_store_result =
+        "    addi sp, sp, -4\n"
+        "    sw t0, 0(sp)      # push the value to the stack\n";
+    // clang-format on
+    dumpInstructions(m_output_file.get(), riscv_assembly_bin_op_store_result);
+}
+
+static const ConstantValueNode *asIntegerLiteral(ExpressionNode *p_expr) {
+    const auto *constant = dynamic_cast<const ConstantValueNode *>(p_expr);
+    if (constant == nullptr || constant->getConstVal().scalarType != ScalarType::INTEGER) {
+        return nullptr;
+    }
+    return constant;
+}
+
+bool CodeGenerator::generateByConstant(BinaryOperatorNode &p_bin_op) {
+    ExpressionNode *operand = p_bin_op.getLeftOperand();
+    const ConstantValueNode *constant = asIntegerLiteral(p_bin_op.getRightOperand());
+    ArithOp op;
+    switch (p_bin_op.getOperator()) {
+        case OperatorType::MULTIPLICATION:
+            op = ArithOp::MUL;
+            if (constant == nullptr) {
+                operand = p_bin_op.getRightOperand();
+                constant = asIntegerLiteral(p_bin_op.getLeftOperand());
+            }
+            break;
+        case OperatorType::DIVISION:
+            op = ArithOp::DIV;
+            break;
+        case OperatorType::MOD:
+            op = ArithOp::REM;
+            break;
+        default:
+            return false;
+    }
+    if (constant == nullptr || operand->getTypeOfResult().scalarType != ScalarType::INTEGER) {
+        return false;
+    }
+    const int32_t value = constant->getConstVal().valContainer.integer;
+    const ReducedSequence sequence = reduceByConstant(op, value);
+    // x stays in t0; scratch registers are t1 ~ t6
+    if (sequence.steps.empty() || sequence.numScratchRegs > 6) {
+        return false;
+    }
+
+    operand->accept(*this);
+    // clang-format off
+    constexpr const char *const riscv_assembly_reduced_load_operand =
+        "    lw t0, 0(sp)      # pop the value(of the non-constant operand) from the stack\n"
+        "    addi sp, sp, 4    # %s by the constant %d, without the instruction\n";
+    // clang-format on
+    dumpInstructions(m_output_file.get(), riscv_assembly_reduced_load_operand,
+                     op == ArithOp::MUL ? "multiply" : (op == ArithOp::DIV ? "divide" : "mod"),
+                     value);
+
+    const auto getReg = [](const int seqReg) {
+        if (seqReg == kSeqOperand) {
+            return std::string("t0");
+        }
+        return (seqReg == kSeqZero) ? std::string("zero") : "t" + std::to_string(seqReg);
+    };
+    for (size_t i = 0; i < sequence.steps.size(); ++i) {
+        const ArithStep &step = sequence.steps[i];
+        // the last step leaves the result in t0
+        const std::string rd = (i + 1 == sequence.steps.size()) ? "t0" : getReg(step.rd);
+        switch (step.format) {
+            case MachineFormat::R:
+                dumpInstructions(m_output_file.get(), "    %s %s, %s, %s\n", step.opcode,
+                                 rd.c_str(), getReg(step.rs1).c_str(), getReg(step.rs2).c_str());
+                break;
+            case MachineFormat::I:
+                dumpInstructions(m_output_file.get(), "    %s %s, %s, %d\n", step.opcode,
+                                 rd.c_str(), getReg(step.rs1).c_str(), step.imm);
+                break;
+            default:
+                dumpInstructions(m_output_file.get(), "    li %s, %d\n", rd.c_str(), step.imm);
+                break;
+        }
+    }
+
+    // clang-format off
+    constexpr const char *const riscv_assembly_reduced_push =
+        "    addi sp, sp, -4\n"
+        "    sw t0, 0(sp)      # push the value to the stack\n";
+    // clang-format on
+    dumpInstructions(m_output_file.get(), riscv_assembly_reduced_push);
+    return true;
+}
+
 void CodeGenerator::visit(BinaryOperatorNode &p_bin_op) {
     /* Step 1: Ouput assembly                                   */
     // x
@@ -575,7 +1148,35 @@ void CodeGenerator::visit(BinaryOperatorNode &p_bin_op) {
 
     /* Step 3: Visit child nodes & Ouput assembly               */
 
-    p_bin_op.visitChildNodes(*this);
+    if (m_options.strengthReduction && generateByConstant(p_bin_op)) {
+        return;
+    }
+
+    // and/or: short-circuit, then push the 0/1 of where the branches end up
+    // (With a constant operand, there is nothing to skip: `x and c` is an `andi`, and so is
+    // `c and x` if c does not decide alone.)
+    const bool isAnd = p_bin_op.getOperator() == OperatorType::AND;
+    const PatternOperand left = getPatternOperandOf(p_bin_op.getLeftOperand());
+    const PatternOperand right = getPatternOperandOf(p_bin_op.getRightOperand());
+    if ((isAnd || p_bin_op.getOperator() == OperatorType::OR) &&
+        !right.isConstant && !(left.isConstant && left.value == (isAnd ? 1 : 0))) {
+        const int falseLabel = getNextL();
+        nextL_add(2);
+        generateBranch(&p_bin_op, falseLabel, false);
+        // clang-format off
+        constexpr const char *const riscv_assembly_bool_value =
+            "    li t0, 1\n"
+            "    j .L%d\n"
+            ".L%d:\n"
+            "    li t0, 0\n"
+            ".L%d:\n"
+            "    addi sp, sp, -4\n"
+            "    sw t0, 0(sp)      # push the value to the stack\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_bool_value, falseLabel + 1,
+                         falseLabel, falseLabel + 1);
+        return;
+    }
 
     bool leftOperandIsReal =
         p_bin_op.getLeftOperand()->getTypeOfResult().scalarType == ScalarType::REAL;
@@ -585,44 +1186,11 @@ void CodeGenerator::visit(BinaryOperatorNode &p_bin_op) {
     // - Float operations
 
     if (leftOperandIsReal || rightOperandIsReal) {
-        /* 1. Load operands to float registers */
+        p_bin_op.visitChildNodes(*this);
 
-        if (rightOperandIsReal) {
-            // clang-format off
-            constexpr const char *const riscv_assembly_right =
-                "    flw ft0, 0(sp)      # pop the value(of right operand) from the stack\n"
-                "    addi sp, sp, 4\n";
-            // clang-format on
-            dumpInstructions(m_output_file.get(), riscv_assembly_right);
+        /* 1. Load operands to float registers */
 
-        } else {
-            // Coercion(int -> real)
-            // clang-format off
-            constexpr const char *const riscv_assembly_right_is_int =
-                "    lw t0, 0(sp)      # pop the value(of right operand) from the stack\n"
-                "    addi sp, sp, 4\n"
-                "    fcvt.s.w ft0, t0        # Convert integer in t0 to float in ft0\n";
-            // clang-format on
-            dumpInstructions(m_output_file.get(), riscv_assembly_right_is_int);
-        }
-        /// NOTE: same as above
-        if (leftOperandIsReal) {
-            // clang-format off
-            constexpr const char *const riscv_assembly_left =
-                "    flw ft1, 0(sp)      # pop the value(of left operand) from the stack\n"
-                "    addi sp, sp, 4\n";
-            // clang-format on
-            dumpInstructions(m_output_file.get(), riscv_assembly_left);
-        } else {
-            // Coercion(int -> real)
-            // clang-format off
-            constexpr const char *const riscv_assembly_left_is_int =
-                "    lw t1, 0(sp)      # pop the value(of left operand) from the stack\n"
-                "    addi sp, sp, 4\n"
-                "    fcvt.s.w ft1, t1        # Convert integer in t1 to float in ft1\n";
-            // clang-format on
-            dumpInstructions(m_output_file.get(), riscv_assembly_left_is_int);
-        }
+        popFloatOperands(leftOperandIsReal, rightOperandIsReal);
 
         /* 2. Float operation */
 
@@ -735,122 +1303,7 @@ void CodeGenerator::visit(BinaryOperatorNode &p_bin_op) {
 
     // - Non float operations
 
-    // clang-format off
-    constexpr const char *const riscv_assembly_bin_op_load_operands = 
-        "    lw t0, 0(sp)      # pop the value(of right operand) from the stack\n"
-        "    addi sp, sp, 4\n"
-        "    lw t1, 0(sp)      # pop the value(of left operand) from the stack\n"
-        "    addi sp, sp, 4\n";
-    // clang-format on
-    dumpInstructions(m_output_file.get(), riscv_assembly_bin_op_load_operands);
-
-    std::string riscv_assembly_bin_op_operation;
-    switch (p_bin_op.getOperator()) {
-        case OperatorType::PLUS:
-            /// NOTE: There is no string concatenation in this hw.
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    add t0, t1, t0    # t0 = t1 + t0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::SUBTRACTION:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    sub t0, t1, t0    # t0 = t1 - t0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::MULTIPLICATION:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    mul t0, t1, t0    # t0 = t1 * t0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::DIVISION:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    div t0, t1, t0    # t0 = t1 / t0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::MOD:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    rem t0, t1, t0    # t0 = t1 % t0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-
-        case OperatorType::LESS_THAN:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    slt t0, t1, t0    # t0 = (t1 < t0) ? 1 : 0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::LESS_THAN_OR_EQUAL:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    slt t0, t0, t1\n"
-                "    xori t0, t0, 1\n"
-                "                      # t0 = (t1 <= t0) ? 1 : 0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::NOT_EQUAL:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    xor  t0, t1, t0      # t0 = 0 if t1 == t0, else non-zero\n"
-                /* -- to ensure when equal, res is 1. It is not necessary. */
-                "    sltiu t0, t0, 1      # t0 = 1 if t0 == 0 (equal), else 0\n"
-                "    xori  t0, t0, 1      # t0 = 0 if equal, else 1\n"
-                /* --                                                      */
-                "                         # t0 = (t1 != t0) ? 1 : 0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::GREATER_THAN_OR_EQUAL:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    slt t0, t1, t0\n"
-                "    xori t0, t0, 1\n"
-                "                      # t0 = (t1 >= t0) ? 1 : 0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::GREATER_THAN:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    slt t0, t0, t1    # t0 = (t1 > t0) ? 1 : 0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::EQUAL:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    xor  t0, t1, t0      # t0 = 0 if t1 == t0, else non-zero\n"
-                "    sltiu t0, t0, 1      # t0 = 1 if t0 == 0 (equal), else 0\n"
-                "                         # t0 = (t1 == t0) ? 1 : 0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::AND:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    and t0, t1, t0    # t0 = (t1 & t0) ? 1 : 0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-        case OperatorType::OR:
-            // clang-format off
-            riscv_assembly_bin_op_operation =
-                "    or t0, t1, t0    # t0 = (t1 | t0) ? 1 : 0, always save the value in a certain register you choose\n";
-            // clang-format on
-            break;
-
-        default:
-            printf("Unknown bin op\n");
-            exit(1);
-            break;
-    }
-    dumpInstructions(m_output_file.get(), riscv_assembly_bin_op_operation.c_str());
-
-    // clang-format off
-    constexpr const char *const riscv_assembly_bin_op_store_result =
-        "    addi sp, sp, -4\n"
-        "    sw t0, 0(sp)      # push the value to the stack\n";
-    // clang-format on
-    dumpInstructions(m_output_file.get(), riscv_assembly_bin_op_store_result);
+    generateByPattern(p_bin_op);
 
     /* Step 4: Pop scope                                        */
     // x
@@ -950,19 +1403,87 @@ void CodeGenerator::visit(UnaryOperatorNode &p_un_op) {
     // x
 }
 
-void CodeGenerator::visit(FunctionInvocationNode &p_func_invocation) {
-    /* Step 1: Ouput assembly                                   */
-    // x
+bool CodeGenerator::isDirectArgument(ExpressionNode *p_arg) {
+    if (!m_options.registerArguments) {
+        return false;
+    }
+    if (dynamic_cast<const ConstantValueNode *>(p_arg) != nullptr) {
+        return true;
+    }
+    auto *ref = dynamic_cast<VariableReferenceNode *>(p_arg);
+    if (ref == nullptr || !ref->getIndices().empty()) {
+        return false;
+    }
+    // A global may be changed by a call in another argument.
+    const SymbolEntry *entry = m_symbol_manager.findSymbol(ref->getNameCString());
+    return entry != nullptr && entry->level != 0 && entry->type.arrRefs.empty();
+}
 
-    /* Step 2: Push scope                                       */
-    // x
+void CodeGenerator::loadArgument(ExpressionNode *p_arg, bool p_to_real, const char *p_reg) {
+    const bool isReal = p_arg->getTypeOfResult().isSameType(ScalarType::REAL);
+    // An integer of a real parameter is loaded into t0 first.
+    const char *reg = (p_to_real && !isReal) ? "t0" : p_reg;
 
-    /* Step 3: Visit child nodes & Ouput assembly               */
+    if (auto *constant = dynamic_cast<ConstantValueNode *>(p_arg)) {
+        const ConstVal &constVal = constant->getConstVal();
+        if (constVal.scalarType == ScalarType::REAL) {
+            const char *label = m_constant_pool.getLabelOf(constVal).c_str();
+            // clang-format off
+            constexpr const char *const riscv_assembly_load_real_arg =
+                "    lui t0, %%hi(%s)\n"
+                "    flw %s, %%lo(%s)(t0)   # load the argument into '%s'\n";
+            // clang-format on
+            dumpInstructions(m_output_file.get(), riscv_assembly_load_real_arg, label, reg, label,
+                             reg);
+        } else if (constVal.scalarType == ScalarType::STRING) {
+            // clang-format off
+            constexpr const char *const riscv_assembly_load_str_arg =
+                "    la %s, %s         # load the argument into '%s'\n";
+            // clang-format on
+            dumpInstructions(m_output_file.get(), riscv_assembly_load_str_arg, reg,
+                             m_constant_pool.getLabelOf(constVal).c_str(), reg);
+        } else {
+            // clang-format off
+            constexpr const char *const riscv_assembly_load_int_arg =
+                "    li %s, %s         # load the argument into '%s'\n";
+            // clang-format on
+            dumpInstructions(m_output_file.get(), riscv_assembly_load_int_arg, reg,
+                             getImmediateInString(constVal).c_str(), reg);
+        }
+    } else {
+        auto *ref = static_cast<VariableReferenceNode *>(p_arg);
+        const SymbolEntry *entry = m_symbol_manager.findSymbol(ref->getNameCString());
+        // (a parameter kept in its argument register is never passed on: no statement making
+        // a call references it)
+        const auto counterReg = m_counter_reg_of_loop_var.find(entry);
+        if (counterReg != m_counter_reg_of_loop_var.end()) {
+            // clang-format off
+            constexpr const char *const riscv_assembly_move_counter_arg =
+                "    mv %s, s%d            # the value of '%s'\n";
+            // clang-format on
+            dumpInstructions(m_output_file.get(), riscv_assembly_move_counter_arg, reg,
+                             counterReg->second, entry->name);
+        } else {
+            // clang-format off
+            constexpr const char *const riscv_assembly_load_local_arg =
+                "    %s %s, %d(s0)        # load the value of '%s'\n";
+            // clang-format on
+            dumpInstructions(m_output_file.get(), riscv_assembly_load_local_arg,
+                             isReal ? "flw" : "lw", reg, entry->addrOfLocal, entry->name);
+        }
+    }
 
-    p_func_invocation.visitChildNodes(*this);  // arguments (expr)
+    if (reg != p_reg) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_convert_arg =
+            "    fcvt.s.w %s, t0        # Convert integer in t0 to float in '%s'\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_convert_arg, p_reg, p_reg);
+    }
+}
 
-    SymbolEntry *entry = m_symbol_manager.findSymbol(p_func_invocation.getNameCString());
-    const std::vector<Type> &typesOfParam = entry->attribute.typesOfFormalParam;
+int CodeGenerator::passArguments(const std::vector<Type> &typesOfParam,
+                                 const std::vector<ExpressionNode *> &args) {
     const int numOfParam = typesOfParam.size();
 
     struct ArgLoc {
@@ -981,81 +1502,84 @@ void CodeGenerator::visit(FunctionInvocationNode &p_func_invocation) {
             argLocs[i] = {ArgLoc::Kind::Stack, stackCnt++};
         }
     }
-    const int stackSizeBytes = stackCnt * 4;
-    const int spAdjustBytes = (numOfParam - stackCnt) * 4;
 
-    if (numOfParam > 0) {
-        // t2 is the base of evaluated arguments (top of stack after evaluation).
-        // t3 will become the final sp for the call, pointing to the outgoing stack-argument area.
+    // the position of each pushed argument on the evaluation stack, -1 for a direct one
+    std::vector<int> pushedIndex(numOfParam, -1);
+    int numOfPushed = 0;
+    for (int argIdx = 0; argIdx < numOfParam; ++argIdx) {
+        if (!isDirectArgument(args[argIdx])) {
+            args[argIdx]->accept(*this);
+            pushedIndex[argIdx] = numOfPushed++;
+        }
+    }
+
+    // The outgoing stack arguments go below the evaluated ones, which are popped after the call.
+    const int stackSizeBytes = stackCnt * 4;
+    if (stackSizeBytes > 0) {
         // clang-format off
-        constexpr const char *const riscv_assembly_arg_setup =
-            "    mv t2, sp                 # base of evaluated arguments\n"
-            "    addi t3, sp, %d           # target sp (keeps only stack args)\n";
+        constexpr const char *const riscv_assembly_alloc_stack_args =
+            "    addi sp, sp, -%d         # room for the stack arguments\n";
         // clang-format on
-        dumpInstructions(m_output_file.get(), riscv_assembly_arg_setup, spAdjustBytes);
+        dumpInstructions(m_output_file.get(), riscv_assembly_alloc_stack_args, stackSizeBytes);
+    }
 
-        for (int argIdx = 0; argIdx < numOfParam; ++argIdx) {
-            const bool isReal = typesOfParam[argIdx].isSameType(ScalarType::REAL);
-            const ArgLoc &loc = argLocs[argIdx];
-            const int offsetFromTop = (numOfParam - 1 - argIdx) * 4;
+    for (int argIdx = 0; argIdx < numOfParam; ++argIdx) {
+        const bool isReal = typesOfParam[argIdx].isSameType(ScalarType::REAL);
+        const ArgLoc &loc = argLocs[argIdx];
+        std::string reg = isReal ? "ft0" : "t0";
+        if (loc.kind != ArgLoc::Kind::Stack) {
+            reg = std::string(isReal ? "fa" : "a") + std::to_string(loc.index);
+        }
 
-            if (isReal) {
+        if (pushedIndex[argIdx] < 0) {
+            loadArgument(args[argIdx], isReal, reg.c_str());
+        } else {
+            const int offset = stackSizeBytes + (numOfPushed - 1 - pushedIndex[argIdx]) * 4;
+            if (isReal && !args[argIdx]->getTypeOfResult().isSameType(ScalarType::REAL)) {
+                // Coercion(int -> real)
                 // clang-format off
                 constexpr const char *const riscv_assembly_load_arg =
-                    "    flw ft0, %d(t2)         # load argument #%d (float) from eval stack\n";
+                    "    lw t0, %d(sp)          # load argument #%d (int) from eval stack\n"
+                    "    fcvt.s.w %s, t0        # Convert integer in t0 to float\n";
                 // clang-format on
-                dumpInstructions(m_output_file.get(), riscv_assembly_load_arg, offsetFromTop,
-                                 argIdx + 1);
-
-                if (loc.kind == ArgLoc::Kind::FloatReg) {
-                    // clang-format off
-                    constexpr const char *const riscv_assembly_move_to_reg =
-                        "    fsgnj.s fa%d, ft0, ft0 # move argument #%d to float arg register\n";
-                    // clang-format on
-                    dumpInstructions(m_output_file.get(), riscv_assembly_move_to_reg, loc.index,
-                                     argIdx + 1);
-                } else {  // stack
-                    // clang-format off
-                    constexpr const char *const riscv_assembly_store_to_stack =
-                        "    fsw ft0, %d(t3)         # store argument #%d to caller stack slot\n";
-                    // clang-format on
-                    dumpInstructions(m_output_file.get(), riscv_assembly_store_to_stack,
-                                     loc.index * 4, argIdx + 1);
-                }
+                dumpInstructions(m_output_file.get(), riscv_assembly_load_arg, offset, argIdx + 1,
+                                 reg.c_str());
             } else {
                 // clang-format off
                 constexpr const char *const riscv_assembly_load_arg =
-                    "    lw t0, %d(t2)          # load argument #%d (int/bool/str) from eval stack\n";
+                    "    %s %s, %d(sp)         # load argument #%d from eval stack\n";
                 // clang-format on
-                dumpInstructions(m_output_file.get(), riscv_assembly_load_arg, offsetFromTop,
-                                 argIdx + 1);
-
-                if (loc.kind == ArgLoc::Kind::IntReg) {
-                    // clang-format off
-                    constexpr const char *const riscv_assembly_move_to_reg =
-                        "    mv a%d, t0              # move argument #%d to integer arg register\n";
-                    // clang-format on
-                    dumpInstructions(m_output_file.get(), riscv_assembly_move_to_reg, loc.index,
-                                     argIdx + 1);
-                } else {  // stack
-                    // clang-format off
-                    constexpr const char *const riscv_assembly_store_to_stack =
-                        "    sw t0, %d(t3)           # store argument #%d to caller stack slot\n";
-                    // clang-format on
-                    dumpInstructions(m_output_file.get(), riscv_assembly_store_to_stack,
-                                     loc.index * 4, argIdx + 1);
-                }
+                dumpInstructions(m_output_file.get(), riscv_assembly_load_arg,
+                                 isReal ? "flw" : "lw", reg.c_str(), offset, argIdx + 1);
             }
         }
 
-        // Drop the evaluation stack; keep only the outgoing stack arguments (if any).
-        // clang-format off
-        constexpr const char *const riscv_assembly_finalize_sp =
-            "    mv sp, t3\n";
-        // clang-format on
-        dumpInstructions(m_output_file.get(), riscv_assembly_finalize_sp);
+        if (loc.kind == ArgLoc::Kind::Stack) {
+            // clang-format off
+            constexpr const char *const riscv_assembly_store_to_stack =
+                "    %s %s, %d(sp)           # store argument #%d to caller stack slot\n";
+            // clang-format on
+            dumpInstructions(m_output_file.get(), riscv_assembly_store_to_stack,
+                             isReal ? "fsw" : "sw", reg.c_str(), loc.index * 4, argIdx + 1);
+        }
     }
 
+    return stackSizeBytes + numOfPushed * 4;
+}
+
+void CodeGenerator::visit(FunctionInvocationNode &p_func_invocation) {
+    /* Step 1: Ouput assembly                                   */
+    // x
+
+    /* Step 2: Push scope                                       */
+    // x
+
+    /* Step 3: Visit child nodes & Ouput assembly               */
+
+    SymbolEntry *entry = m_symbol_manager.findSymbol(p_func_invocation.getNameCString());
+    const int argSizeBytes =
+        passArguments(entry->attribute.typesOfFormalParam, p_func_invocation.getArguments());
+
     // Jump to function & get the return value
     // clang-format off
     constexpr const char *const riscv_assembly_func_invocation =
@@ -1064,12 +1588,12 @@ void CodeGenerator::visit(FunctionInvocationNode &p_func_invocation) {
     dumpInstructions(m_output_file.get(), riscv_assembly_func_invocation,
                      p_func_invocation.getNameCString(), p_func_invocation.getNameCString());
 
-    if (stackSizeBytes > 0) {
+    if (argSizeBytes > 0) {
         // clang-format off
-        constexpr const char *const riscv_assembly_pop_stack_args =
-            "    addi sp, sp, %d         # pop stack arguments\n";
+        constexpr const char *const riscv_assembly_pop_args =
+            "    addi sp, sp, %d         # pop the arguments\n";
         // clang-format on
-        dumpInstructions(m_output_file.get(), riscv_assembly_pop_stack_args, stackSizeBytes);
+        dumpInstructions(m_output_file.get(), riscv_assembly_pop_args, argSizeBytes);
     }
 
     // Push return value to stack
@@ -1096,6 +1620,71 @@ void CodeGenerator::visit(FunctionInvocationNode &p_func_invocation) {
     // x
 }
 
+void CodeGenerator::pushAddressOf(VariableReferenceNode &p_variable_ref,
+                                  const SymbolEntry *entry) {
+    const std::vector<ExpressionNode *> &indices = p_variable_ref.getIndices();
+    int offset = 0;
+    for (size_t dim = 0; dim < indices.size(); ++dim) {
+        if (const ConstantValueNode *literal = asIntegerLiteral(indices[dim])) {
+            offset += literal->getConstVal().valContainer.integer * entry->type.getStrideOf(dim);
+        }
+    }
+
+    if (entry->level == 0) {
+        // Global
+        // clang-format off
+        constexpr const char *const riscv_assembly_global_var_ref = 
+            "    la t0, %s\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_global_var_ref, entry->name);
+        if (offset != 0) {
+            dumpAddImmediate(m_output_file.get(), "t0", "t0", offset);
+        }
+    } else if (entry->isAlias) {
+        // Array parameter: its slot holds the address of the caller's array
+        dumpInstructions(m_output_file.get(), "    lw t0, %d(s0)      # the address of '%s'\n",
+                         entry->addrOfLocal, entry->name);
+        if (offset != 0) {
+            dumpAddImmediate(m_output_file.get(), "t0", "t0", offset);
+        }
+    } else {
+        // Local
+        dumpAddImmediate(m_output_file.get(), "t0", "s0", entry->addrOfLocal + offset);
+    }
+    // clang-format off
+    constexpr const char *const riscv_assembly_var_ref = 
+        "    addi sp, sp, -4\n"
+        "    sw t0, 0(sp)     # push the address to the stack\n";
+    // clang-format on
+    dumpInstructions(m_output_file.get(), riscv_assembly_var_ref);
+
+    for (size_t dim = 0; dim < indices.size(); ++dim) {
+        if (asIntegerLiteral(indices[dim]) != nullptr) {
+            continue;
+        }
+        indices[dim]->accept(*this);
+        // clang-format off
+        constexpr const char *const riscv_assembly_pop_index =
+            "    lw t0, 0(sp)     # pop the index from the stack\n"
+            "    addi sp, sp, 4\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_pop_index);
+        const int stride = entry->type.getStrideOf(dim);
+        if ((stride & (stride - 1)) == 0) {
+            dumpInstructions(m_output_file.get(), "    slli t0, t0, %d\n", __builtin_ctz(stride));
+        } else {
+            dumpInstructions(m_output_file.get(), "    li t1, %d\n    mul t0, t0, t1\n", stride);
+        }
+        // clang-format off
+        constexpr const char *const riscv_assembly_add_index =
+            "    lw t1, 0(sp)\n"
+            "    add t1, t1, t0\n"
+            "    sw t1, 0(sp)     # the address, moved by the index\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_add_index);
+    }
+}
+
 void CodeGenerator::visit(VariableReferenceNode &p_variable_ref) {
     /* Step 1: Ouput assembly                                   */
     // x
@@ -1105,25 +1694,69 @@ void CodeGenerator::visit(VariableReferenceNode &p_variable_ref) {
 
     /* Step 3: Visit child nodes & Ouput assembly               */
 
-    p_variable_ref.visitChildNodes(*this);
-
     SymbolEntry *entry = m_symbol_manager.findSymbol(p_variable_ref.getNameCString());
     if (entry == nullptr) {
         perror("p_variable_ref, no symbol found\n");
         exit(1);
     }
 
-    if (entry->type.isSameType(ScalarType::REAL)) {
+    // An array is referred to by its address; an element, by its value.
+    if (!entry->type.arrRefs.empty()) {
+        pushAddressOf(p_variable_ref, entry);
+        if (p_variable_ref.getIndices().size() < entry->type.arrRefs.size()) {
+            return;
+        }
+        if (entry->type.scalarType == ScalarType::REAL) {
+            // clang-format off
+            constexpr const char *const riscv_assembly_element_ref =
+                "    lw t0, 0(sp)     # pop the address from the stack\n"
+                "    flw ft0, 0(t0)     # load the element of '%s'\n"
+                "    fsw ft0, 0(sp)     # push the value to the stack\n";
+            // clang-format on
+            dumpInstructions(m_output_file.get(), riscv_assembly_element_ref, entry->name);
+        } else {
+            // clang-format off
+            constexpr const char *const riscv_assembly_element_ref =
+                "    lw t0, 0(sp)     # pop the address from the stack\n"
+                "    lw t0, 0(t0)     # load the element of '%s'\n"
+                "    sw t0, 0(sp)     # push the value to the stack\n";
+            // clang-format on
+            dumpInstructions(m_output_file.get(), riscv_assembly_element_ref, entry->name);
+        }
+        return;
+    }
+
+    const auto counterReg = m_counter_reg_of_loop_var.find(entry);
+    if (counterReg != m_counter_reg_of_loop_var.end()) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_loop_var_ref =
+            "    mv t0, s%d            # the value of '%s'\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_loop_var_ref, counterReg->second,
+                         p_variable_ref.getNameCString());
+    } else if (m_arg_reg_of_param.count(entry)) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_float_param_ref =
+            "    fmv.s ft0, fa%d        # the value of '%s'\n";
+        constexpr const char *const riscv_assembly_param_ref =
+            "    mv t0, a%d            # the value of '%s'\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(),
+                         entry->type.isSameType(ScalarType::REAL) ? riscv_assembly_float_param_ref
+                                                                  : riscv_assembly_param_ref,
+                         m_arg_reg_of_param.at(entry), p_variable_ref.getNameCString());
+    } else if (entry->type.isSameType(ScalarType::REAL)) {
         // Load value of variable to 'ft0'
         if (entry->level == 0) {
             // Global
             // clang-format off
             constexpr const char *const riscv_assembly_global_var_ref = 
-                "    la t0, %s\n"
-                "    flw ft0, 0(t0)     # load the value of '%s'\n";
+                "    lui t0, %%hi(%s)\n"
+                "    flw ft0, %%lo(%s)(t0)     # load the value of '%s'\n";
             // clang-format on
             dumpInstructions(m_output_file.get(), riscv_assembly_global_var_ref,
-                             p_variable_ref.getNameCString(), p_variable_ref.getNameCString());
+                             p_variable_ref.getNameCString(), p_variable_ref.getNameCString(),
+                             p_variable_ref.getNameCString());
         } else {
             // Local
             // clang-format off
@@ -1139,12 +1772,12 @@ void CodeGenerator::visit(VariableReferenceNode &p_variable_ref) {
             // Global
             // clang-format off
             constexpr const char *const riscv_assembly_global_var_ref = 
-                "    la t0, %s\n"
-                "    lw t1, 0(t0)     # load the value of '%s'\n"
-                "    mv t0, t1\n";
+                "    lui t0, %%hi(%s)\n"
+                "    lw t0, %%lo(%s)(t0)     # load the value of '%s'\n";
             // clang-format on
             dumpInstructions(m_output_file.get(), riscv_assembly_global_var_ref,
-                             p_variable_ref.getNameCString(), p_variable_ref.getNameCString());
+                             p_variable_ref.getNameCString(), p_variable_ref.getNameCString(),
+                             p_variable_ref.getNameCString());
         } else {
             // Local
             // clang-format off
@@ -1194,35 +1827,27 @@ void CodeGenerator::visit(AssignmentNode &p_assignment) {
         perror("lvalEntry not found\n");
         exit(1);
     }
-
-    if (lvalEntry->level == 0) {
-        // Global
+    const auto argReg = m_arg_reg_of_param.find(lvalEntry);
+    if (argReg != m_arg_reg_of_param.end()) {
+        p_assignment.getExpression()->accept(*this);
         // clang-format off
-        constexpr const char *const riscv_assembly_global_var_ref = 
-            "    la t0, %s\n";
-        // clang-format on
-        dumpInstructions(m_output_file.get(), riscv_assembly_global_var_ref, lvalName.c_str());
-    } else {
-        // Local
-        // clang-format off
-        constexpr const char *const riscv_assembly_local_var_ref = 
-            "    addi t0, s0, %d\n";
+        constexpr const char *const riscv_assembly_assign_param =
+            "    %s %sa%d, 0(sp)     # pop the value into '%s'\n"
+            "    addi sp, sp, 4\n";
         // clang-format on
-        dumpInstructions(m_output_file.get(), riscv_assembly_local_var_ref, lvalEntry->addrOfLocal);
+        const bool isReal = lvalEntry->type.isSameType(ScalarType::REAL);
+        dumpInstructions(m_output_file.get(), riscv_assembly_assign_param, isReal ? "flw" : "lw",
+                         isReal ? "f" : "", argReg->second, lvalName.c_str());
+        return;
     }
-    // clang-format off
-    constexpr const char *const riscv_assembly_var_ref = 
-        "    addi sp, sp, -4\n"
-        "    sw t0, 0(sp)     # push the address to the stack\n";
-    // clang-format on
-    dumpInstructions(m_output_file.get(), riscv_assembly_var_ref);
+    pushAddressOf(*p_assignment.getVarRef(), lvalEntry);
 
     // (2) expression (rvalue)
     // After visiting expression node subtree, a single value will be pushed onto the stack.
     p_assignment.getExpression()->accept(*this);
 
     // (3) Assign val to var
-    if (lvalEntry->type.isSameType(ScalarType::REAL)) {
+    if (p_assignment.getVarRef()->getTypeOfResult().isSameType(ScalarType::REAL)) {
         // clang-format off
         constexpr const char *const riscv_assembly_assign = 
             "    flw ft0, 0(sp)     # pop the value from the stack\n"
@@ -1261,38 +1886,24 @@ void CodeGenerator::visit(ReadNode &p_read) {
     /// NOTE: There is no read string in this hw.
     bool isReal = p_read.getVarRef()->getTypeOfResult().scalarType == ScalarType::REAL;
 
-    // clang-format off
-    constexpr const char *const riscv_assembly_read = 
-        "    jal ra, %s  # call function '%s'\n";
-    // clang-format on
-    const char *functionToCall = isReal ? "readReal" : "readInt";
-    dumpInstructions(m_output_file.get(), riscv_assembly_read, functionToCall, functionToCall);
-
-    // lvalue
+    // lvalue, before the call, as its indices may call functions too
     const SymbolEntry *varRefEntry =
         m_symbol_manager.findSymbol(p_read.getVarRef()->getNameCString());
     if (varRefEntry == nullptr) {
         perror("var ref not found IN read node\n");
         exit(1);
     }
-    std::string lvalName = varRefEntry->name;
+    const char *lvalName = varRefEntry->name;
+    pushAddressOf(*const_cast<VariableReferenceNode *>(p_read.getVarRef()), varRefEntry);
 
-    if (varRefEntry->level == 0) {
-        // Global
-        // clang-format off
-        constexpr const char *const riscv_assembly_global_var_ref = 
-            "    la t0, %s\n";
-        // clang-format on
-        dumpInstructions(m_output_file.get(), riscv_assembly_global_var_ref, lvalName.c_str());
-    } else {
-        // Local
-        // clang-format off
-        constexpr const char *const riscv_assembly_local_var_ref = 
-            "    addi t0, s0, %d\n";
-        // clang-format on
-        dumpInstructions(m_output_file.get(), riscv_assembly_local_var_ref,
-                         varRefEntry->addrOfLocal);
-    }
+    // clang-format off
+    constexpr const char *const riscv_assembly_read = 
+        "    jal ra, %s  # call function '%s'\n"
+        "    lw t0, 0(sp)     # pop the address from the stack\n"
+        "    addi sp, sp, 4\n";
+    // clang-format on
+    const char *functionToCall = isReal ? "readReal" : "readInt";
+    dumpInstructions(m_output_file.get(), riscv_assembly_read, functionToCall, functionToCall);
 
     if (isReal) {
         // clang-format off
@@ -1312,6 +1923,156 @@ void CodeGenerator::visit(ReadNode &p_read) {
     // x
 }
 
+/// @return the comparison that holds exactly when `op` does not
+static OperatorType negateComparison(const OperatorType op) {
+    switch (op) {
+        case OperatorType::LESS_THAN:
+            return OperatorType::GREATER_THAN_OR_EQUAL;
+        case OperatorType::LESS_THAN_OR_EQUAL:
+            return OperatorType::GREATER_THAN;
+        case OperatorType::NOT_EQUAL:
+            return OperatorType::EQUAL;
+        case OperatorType::GREATER_THAN_OR_EQUAL:
+            return OperatorType::LESS_THAN;
+        case OperatorType::GREATER_THAN:
+            return OperatorType::LESS_THAN_OR_EQUAL;
+        default:
+            return OperatorType::NOT_EQUAL;
+    }
+}
+
+void CodeGenerator::generateBranch(ExpressionNode *p_condition, const int p_label,
+                                   const bool p_jumps_if_true) {
+    // - not: the same branch, the other way round
+
+    auto *unaryOp = dynamic_cast<UnaryOperatorNode *>(p_condition);
+    if (unaryOp != nullptr && unaryOp->getOperator() == OperatorType::NOT) {
+        generateBranch(unaryOp->getOperand(), p_label, !p_jumps_if_true);
+        return;
+    }
+
+    auto *binOp = dynamic_cast<BinaryOperatorNode *>(p_condition);
+    const OperatorType op = (binOp != nullptr) ? binOp->getOperator() : OperatorType::NOT;
+
+    // - and/or: the right operand is only evaluated if the left one does not decide
+
+    if (op == OperatorType::AND || op == OperatorType::OR) {
+        // `a and b` jumps if false as soon as a is false; `a or b` jumps if true once a is true.
+        const bool leftDecides = (op == OperatorType::OR) == p_jumps_if_true;
+        if (leftDecides) {
+            generateBranch(binOp->getLeftOperand(), p_label, p_jumps_if_true);
+            generateBranch(binOp->getRightOperand(), p_label, p_jumps_if_true);
+            return;
+        }
+        const int labelOfRightFalls = getNextL();
+        nextL_add(1);
+        generateBranch(binOp->getLeftOperand(), labelOfRightFalls, !p_jumps_if_true);
+        generateBranch(binOp->getRightOperand(), p_label, p_jumps_if_true);
+        // clang-format off
+        constexpr const char *const riscv_assembly_skip_right =
+            ".L%d:\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_skip_right, labelOfRightFalls);
+        return;
+    }
+
+    // - Anything but a comparison: branch on its 0/1 value
+
+    if (op < OperatorType::LESS_THAN || op > OperatorType::EQUAL) {
+        p_condition->accept(*this);
+        // clang-format off
+        constexpr const char *const riscv_assembly_branch_on_value =
+            "    lw t0, 0(sp)     # pop the value from the stack\n"
+            "    addi sp, sp, 4\n"
+            "    %s t0, x0, .L%d\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_branch_on_value,
+                         p_jumps_if_true ? "bne" : "beq", p_label);
+        return;
+    }
+
+    // - Comparison: branch on the operands
+
+    binOp->visitChildNodes(*this);
+    const bool leftOperandIsReal =
+        binOp->getLeftOperand()->getTypeOfResult().scalarType == ScalarType::REAL;
+    const bool rightOperandIsReal =
+        binOp->getRightOperand()->getTypeOfResult().scalarType == ScalarType::REAL;
+
+    if (leftOperandIsReal || rightOperandIsReal) {
+        popFloatOperands(leftOperandIsReal, rightOperandIsReal);
+
+        // t0 = whether the comparison holds (for `<>`: whether it does not)
+        const char *compare;
+        switch (op) {
+            case OperatorType::LESS_THAN:
+                compare = "flt.s t0, ft1, ft0";
+                break;
+            case OperatorType::LESS_THAN_OR_EQUAL:
+                compare = "fle.s t0, ft1, ft0";
+                break;
+            case OperatorType::GREATER_THAN_OR_EQUAL:
+                compare = "fle.s t0, ft0, ft1";
+                break;
+            case OperatorType::GREATER_THAN:
+                compare = "flt.s t0, ft0, ft1";
+                break;
+            default:  // EQUAL, NOT_EQUAL
+                compare = "feq.s t0, ft1, ft0";
+                break;
+        }
+        const bool holdsIfSet = op != OperatorType::NOT_EQUAL;
+        // clang-format off
+        constexpr const char *const riscv_assembly_float_branch =
+            "    %s\n"
+            "    %s t0, x0, .L%d     # jump when the condition is %s\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_float_branch, compare,
+                         holdsIfSet == p_jumps_if_true ? "bne" : "beq", p_label,
+                         p_jumps_if_true ? "true" : "false");
+        return;
+    }
+
+    // clang-format off
+    constexpr const char *const riscv_assembly_compare_load_operands =
+        "    lw t0, 0(sp)      # pop the value(of right operand) from the stack\n"
+        "    addi sp, sp, 4\n"
+        "    lw t1, 0(sp)      # pop the value(of left operand) from the stack\n"
+        "    addi sp, sp, 4\n";
+    // clang-format on
+    dumpInstructions(m_output_file.get(), riscv_assembly_compare_load_operands);
+
+    // the branch taken when t1 <jumpsOn> t0 holds
+    const OperatorType jumpsOn = p_jumps_if_true ? op : negateComparison(op);
+    const char *branch;
+    switch (jumpsOn) {
+        case OperatorType::LESS_THAN:
+            branch = "blt t1, t0";
+            break;
+        case OperatorType::LESS_THAN_OR_EQUAL:
+            branch = "bge t0, t1";
+            break;
+        case OperatorType::NOT_EQUAL:
+            branch = "bne t1, t0";
+            break;
+        case OperatorType::GREATER_THAN_OR_EQUAL:
+            branch = "bge t1, t0";
+            break;
+        case OperatorType::GREATER_THAN:
+            branch = "blt t0, t1";
+            break;
+        default:  // EQUAL
+            branch = "beq t1, t0";
+            break;
+    }
+    // clang-format off
+    constexpr const char *const riscv_assembly_int_branch =
+        "    %s, .L%d     # jump if t1 %s t0\n";
+    // clang-format on
+    dumpInstructions(m_output_file.get(), riscv_assembly_int_branch, branch, p_label,
+                     OperatorTypeStrings[static_cast<size_t>(jumpsOn)]);
+}
+
 void CodeGenerator::visit(IfNode &p_if) {
     /* Step 1: Ouput assembly                                   */
     // x
@@ -1321,8 +2082,6 @@ void CodeGenerator::visit(IfNode &p_if) {
 
     /* Step 3: Visit child nodes & Ouput assembly               */
 
-    p_if.getCondition()->accept(*this);
-
     // [if]:
 
     bool hasElseBody = p_if.getElseBody();
@@ -1335,16 +2094,16 @@ void CodeGenerator::visit(IfNode &p_if) {
         labelOfNext = firstLabel + 2;
     }
 
+    // jump to else/exit when the condition is false
+    generateBranch(p_if.getCondition(), firstLabel + 1, false);
+
     // clang-format off
     constexpr const char *const riscv_assembly_if1 =
-        "    lw t0, 0(sp)     # pop the value from the stack\n"
-        "    addi sp, sp, 4\n"
-        "    beq t0, x0, .L%d\n"  // jump to else/exit when the condition is false
     // [then]:
 
         ".L%d:\n";  // not necessary, but spec adds this, so I do, too.
     // clang-format on
-    dumpInstructions(m_output_file.get(), riscv_assembly_if1, firstLabel + 1, firstLabel);
+    dumpInstructions(m_output_file.get(), riscv_assembly_if1, firstLabel);
 
     p_if.getBody()->accept(*this);
 
@@ -1400,18 +2159,16 @@ void CodeGenerator::visit(WhileNode &p_while) {
     // clang-format on
     dumpInstructions(m_output_file.get(), riscv_assembly_while1, firstLabel);
 
-    p_while.getCondition()->accept(*this);
+    // exit loop once the condition becomes false
+    generateBranch(p_while.getCondition(), firstLabel + 2, false);
 
     // clang-format off
     constexpr const char *const riscv_assembly_while2 =
-        "    lw t0, 0(sp)     # pop the value from the stack\n"
-        "    addi sp, sp, 4\n"
-        "    beq t0, x0, .L%d\n"  // exit loop once the condition becomes false
     // [do]:
 
         ".L%d:\n";  // not necessary, but spec adds this, so I do, too.
     // clang-format on
-    dumpInstructions(m_output_file.get(), riscv_assembly_while2, firstLabel + 2, firstLabel + 1);
+    dumpInstructions(m_output_file.get(), riscv_assembly_while2, firstLabel + 1);
 
     p_while.getBody()->accept(*this);
 
@@ -1448,6 +2205,12 @@ void CodeGenerator::visit(ForNode &p_for) {
     const SymbolEntry *loopVarEntry =
         m_symbol_manager.findSymbol(p_for.getLoopVar()->getNameCString());
 
+    if (m_counter_depth < m_num_counter_regs) {
+        generateCountedLoop(p_for, loopVarEntry);
+        m_symbol_manager.popScope();
+        return;
+    }
+
     // [for]:
 
     // Acquire enough labels
@@ -1497,6 +2260,164 @@ void CodeGenerator::visit(ForNode &p_for) {
     m_symbol_manager.popScope();
 }
 
+void CodeGenerator::generateCountedLoop(ForNode &p_for, const SymbolEntry *loopVarEntry) {
+    // The bounds are constants, and the lower one is below the upper one (checked by the
+    // semantic analyzer): the body runs at least once, so the condition is only checked at
+    // the bottom.
+    const int reg = ++m_counter_depth;
+    const int32_t lower = p_for.getInitConstVal()->getConstVal().valContainer.integer;
+    const int32_t upper = p_for.getCondition()->getConstVal().valContainer.integer;
+    const bool readsCounter = m_loop_reads_counter.at(&p_for);
+    const int bodyLabel = getNextL();
+    nextL_add(1);
+
+    if (readsCounter) {
+        m_counter_reg_of_loop_var[loopVarEntry] = reg;
+        // clang-format off
+        constexpr const char *const riscv_assembly_counted_for_init =
+            "    li s%d, %d           # '%s' lives in s%d during the loop\n"
+            ".L%d:\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_counted_for_init, reg, lower,
+                         loopVarEntry->name, reg, bodyLabel);
+    } else {
+        // Nothing reads the loop variable, so s<reg> counts the iterations left down to 0.
+        // clang-format off
+        constexpr const char *const riscv_assembly_counted_for_init =
+            "    li s%d, %d           # the body never reads '%s': count the iterations down\n"
+            ".L%d:\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_counted_for_init, reg,
+                         upper - lower, loopVarEntry->name, bodyLabel);
+    }
+
+    p_for.getBody()->accept(*this);
+
+    if (readsCounter) {
+        m_counter_reg_of_loop_var.erase(loopVarEntry);
+        // clang-format off
+        constexpr const char *const riscv_assembly_counted_for_next =
+            "    addi s%d, s%d, 1     # %s + 1\n"
+            "    li t0, %d\n"
+            "    blt s%d, t0, .L%d     # loop while %s < %d\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_counted_for_next, reg, reg,
+                         loopVarEntry->name, upper, reg, bodyLabel, loopVarEntry->name, upper);
+    } else {
+        // clang-format off
+        constexpr const char *const riscv_assembly_counted_for_next =
+            "    addi s%d, s%d, -1\n"
+            "    bnez s%d, .L%d        # loop while iterations are left\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_counted_for_next, reg, reg, reg,
+                         bodyLabel);
+    }
+    --m_counter_depth;
+}
+
+bool CodeGenerator::generateTailCall(ReturnNode &p_return) {
+    auto *call = dynamic_cast<const FunctionInvocationNode *>(p_return.getReturnVal());
+    if (m_function == nullptr || call == nullptr) {
+        return false;
+    }
+    SymbolEntry *entry = m_symbol_manager.findSymbol(call->getNameCString());
+    const std::vector<Type> &typesOfParam = entry->attribute.typesOfFormalParam;
+    const bool isSelfCall = strcmp(call->getNameCString(), m_function->getNameCString()) == 0;
+    // An array is passed by its address: one in our frame would be gone (or, for a self call,
+    // overwritten) by the time the callee reads it.
+    const std::vector<ExpressionNode *> &args = call->getArguments();
+    if (std::any_of(args.begin(), args.end(), [this](ExpressionNode *arg) {
+            auto *ref = dynamic_cast<VariableReferenceNode *>(arg);
+            const SymbolEntry *argEntry =
+                ref ? m_symbol_manager.findSymbol(ref->getNameCString()) : nullptr;
+            return argEntry != nullptr && !argEntry->type.arrRefs.empty() &&
+                   argEntry->level != 0 && !argEntry->isAlias;
+        })) {
+        return false;
+    }
+
+    // Another function returns straight to our caller: its value must need no conversion, and
+    // all arguments must go in registers, since our frame (and the stack below it) is gone by then.
+    if (!isSelfCall) {
+        const bool returnsReal = entry->type.isSameType(ScalarType::REAL);
+        if (returnsReal != (m_function->getReturnType() == ScalarType::REAL)) {
+            return false;
+        }
+        int floatArgCnt = 0, intArgCnt = 0;
+        for (const Type &type : typesOfParam) {
+            if (type.isSameType(ScalarType::REAL)) {
+                ++floatArgCnt;
+            } else {
+                ++intArgCnt;
+            }
+        }
+        if (floatArgCnt > 8 || intArgCnt > 8) {
+            return false;
+        }
+    }
+
+    if (isSelfCall) {
+        const_cast<FunctionInvocationNode *>(call)->visitChildNodes(*this);  // arguments (expr)
+        // Pop the arguments (the last one on top) into the parameters and start over.
+        for (int paramIdx = typesOfParam.size() - 1; paramIdx >= 0; --paramIdx) {
+            const SymbolEntry *param = m_params[paramIdx];
+            const bool argIsReal =
+                call->getArguments()[paramIdx]->getTypeOfResult().isSameType(ScalarType::REAL);
+            if (param->type.isSameType(ScalarType::REAL) && argIsReal) {
+                // clang-format off
+                constexpr const char *const riscv_assembly_pop_arg_to_param =
+                    "    flw ft0, 0(sp)     # pop the argument from the stack\n"
+                    "    addi sp, sp, 4\n"
+                    "    fsw ft0, %d(s0)    # overwrite parameter '%s'\n";
+                // clang-format on
+                dumpInstructions(m_output_file.get(), riscv_assembly_pop_arg_to_param,
+                                 param->addrOfLocal, param->name);
+            } else if (param->type.isSameType(ScalarType::REAL)) {
+                // clang-format off
+                constexpr const char *const riscv_assembly_pop_arg_to_param =
+                    "    lw t0, 0(sp)       # pop the argument from the stack\n"
+                    "    addi sp, sp, 4\n"
+                    "    fcvt.s.w ft0, t0   # Convert integer in t0 to float in ft0\n"
+                    "    fsw ft0, %d(s0)    # overwrite parameter '%s'\n";
+                // clang-format on
+                dumpInstructions(m_output_file.get(), riscv_assembly_pop_arg_to_param,
+                                 param->addrOfLocal, param->name);
+            } else {
+                // clang-format off
+                constexpr const char *const riscv_assembly_pop_arg_to_param =
+                    "    lw t0, 0(sp)       # pop the argument from the stack\n"
+                    "    addi sp, sp, 4\n"
+                    "    sw t0, %d(s0)      # overwrite parameter '%s'\n";
+                // clang-format on
+                dumpInstructions(m_output_file.get(), riscv_assembly_pop_arg_to_param,
+                                 param->addrOfLocal, param->name);
+            }
+        }
+        // clang-format off
+        constexpr const char *const riscv_assembly_self_tail_call =
+            "    j .L%d                  # tail call to '%s' itself: start over\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_self_tail_call, m_body_label,
+                         m_function->getNameCString());
+        return true;
+    }
+
+    const int argSizeBytes = passArguments(typesOfParam, call->getArguments());
+    // clang-format off
+    constexpr const char *const riscv_assembly_pop_args =
+        "    addi sp, sp, %d         # pop the arguments\n";
+    constexpr const char *const riscv_assembly_tail_call =
+        "    j %s                # tail call: '%s' returns to our caller\n";
+    // clang-format on
+    if (argSizeBytes > 0) {
+        dumpInstructions(m_output_file.get(), riscv_assembly_pop_args, argSizeBytes);
+    }
+    freeFrame();
+    dumpInstructions(m_output_file.get(), riscv_assembly_tail_call, call->getNameCString(),
+                     call->getNameCString());
+    return true;
+}
+
 void CodeGenerator::visit(ReturnNode &p_return) {
     /* Step 1: Ouput assembly                                   */
     // x
@@ -1506,6 +2427,10 @@ void CodeGenerator::visit(ReturnNode &p_return) {
 
     /* Step 3: Visit child nodes & Ouput assembly               */
 
+    if (m_options.tailCalls && generateTailCall(p_return)) {
+        return;
+    }
+
     p_return.visitChildNodes(*this);
     bool isReal = p_return.getReturnVal()->getTypeOfResult().isSameType(ScalarType::REAL);
 
@@ -1529,15 +2454,11 @@ void CodeGenerator::visit(ReturnNode &p_return) {
 
     // clang-format off
     constexpr const char *const riscv_assembly_return = 
-        "    # in the function epilogue\n"
-        "    lw ra, 124(sp)       # load return address saved in the current stack\n"
-        "    lw s0, 120(sp)       # move frame pointer back to the bottom of the last stack\n"
-        "    addi sp, sp, 128     # move stack pointer back to the top of the last stack\n"
-        "    jr ra                # jump back to the caller function\n";
+        "    j .L%d                  # jump to the epilogue\n";
     // clang-format on
-    dumpInstructions(m_output_file.get(), riscv_assembly_return);
+    dumpInstructions(m_output_file.get(), riscv_assembly_return, m_epilogue_label);
 
-    /* in this hw, there seems to be no prevention from program after a return stmt. */
+    /* The statements after a return are removed by DeadCodeEliminator (unless --no-dce). */
 
     /* Step 4: Pop scope                                        */
     // x
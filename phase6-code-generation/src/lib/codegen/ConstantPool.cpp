@@ -0,0 +1,57 @@
+#include "codegen/ConstantPool.hpp"
+
+#include "AST/ConstantValue.hpp"
+#include "codegen/CodeGenerator.hpp"
+#include "ir/IR.hpp"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const std::string &ConstantPool::getLabelOf(const ConstVal &literal) {
+    const bool isReal = literal.scalarType == ScalarType::REAL;
+    std::vector<Literal> &literals = isReal ? m_reals : m_strings;
+    std::unordered_map<std::string, size_t> &indexOf =
+        isReal ? m_index_of_real : m_index_of_string;
+
+    // (Reals are printed with enough digits to tell apart any two floats.)
+    const std::string data = getImmediateInString(literal);
+    auto it = indexOf.find(data);
+    if (it == indexOf.end()) {
+        const std::string label = ".LC" + std::to_string(m_reals.size() + m_strings.size());
+        literals.push_back(Literal{label, data});
+        it = indexOf.emplace(data, literals.size() - 1).first;
+    }
+    return literals[it->second].label;
+}
+
+const std::string &ConstantPool::getLabelOf(const IrValue &literal) {
+    ConstVal constVal;
+    if (literal.kind == IrValue::Kind::FLOAT) {
+        constVal.scalarType = ScalarType::REAL;
+        constVal.valContainer.real = literal.floatVal;
+    } else {
+        constVal.scalarType = ScalarType::STRING;
+        constVal.valContainer.string = literal.strVal;
+    }
+    return getLabelOf(constVal);
+}
+
+void ConstantPool::dump(FILE *p_out_file) const {
+    if (!m_reals.empty()) {
+        fprintf(p_out_file, "    .section    .rodata       # the constant pool\n"
+                            "    .align 2\n");
+        for (const Literal &real : m_reals) {
+            fprintf(p_out_file, "%s:\n    .float %s\n", real.label.c_str(), real.data.c_str());
+        }
+    }
+    if (!m_strings.empty()) {
+        fprintf(p_out_file,
+                "    .section    .rodata.str1.1,\"aMS\",@progbits,1   # mergeable strings\n");
+        for (const Literal &string : m_strings) {
+            fprintf(p_out_file, "%s:\n    .string %s\n", string.label.c_str(),
+                    string.data.c_str());
+        }
+    }
+}
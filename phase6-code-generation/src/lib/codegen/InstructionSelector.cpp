@@ -0,0 +1,625 @@
+#include "codegen/InstructionSelector.hpp"
+
+#include "codegen/MachineCode.hpp"
+#include "codegen/StrengthReduction.hpp"
+#include "codegen/TreePatterns.hpp"
+#include "ir/IR.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+static RegClass getRegClassOf(const IrType type) {
+    return (type == IrType::F32) ? RegClass::FLOAT : RegClass::INT;
+}
+
+/// @return whether `ret` returns what `call` returns, so the callee may return to our caller
+static bool isTailCall(const IrInstr &call, const IrInstr &ret) {
+    if (call.op != IrOp::CALL || ret.op != IrOp::RET) {
+        return false;
+    }
+    if (ret.operands.empty() ? !call.dst.isNone() : !ret.operands[0].isSameAs(call.dst)) {
+        return false;
+    }
+    // Stack arguments would live in the frame that is gone by then.
+    int intArgCnt = 0, floatArgCnt = 0;
+    for (const IrValue &arg : call.operands) {
+        if (arg.type == IrType::F32) {
+            ++floatArgCnt;
+        } else {
+            ++intArgCnt;
+        }
+    }
+    return intArgCnt <= 8 && floatArgCnt <= 8;
+}
+
+/// @return the comparison that holds exactly when `op` does not
+static IrOp negateComparison(const IrOp op) {
+    switch (op) {
+        case IrOp::LT:
+            return IrOp::GE;
+        case IrOp::LE:
+            return IrOp::GT;
+        case IrOp::NE:
+            return IrOp::EQ;
+        case IrOp::GE:
+            return IrOp::LT;
+        case IrOp::GT:
+            return IrOp::LE;
+        default:
+            return IrOp::NE;
+    }
+}
+
+std::string InstructionSelector::newLabel() {
+    return ".L" + std::to_string(m_next_label++);
+}
+
+void InstructionSelector::emit(MachineInstr instr) {
+    const bool endsBlock = instr.endsBlock();
+    m_falls_through = instr.format != MachineFormat::JUMP && instr.format != MachineFormat::RET;
+    m_block->instrs.push_back(std::move(instr));
+    if (endsBlock) {
+        m_block = m_function->appendBlock("");
+    }
+}
+
+void InstructionSelector::jumpTo(const IrBasicBlock *target) {
+    if (target != m_next_block) {
+        emit(MachineInstr::makeJump(m_label_of_block.at(target)));
+    }
+}
+
+void InstructionSelector::materialize(const IrValue &value, const Reg dst) {
+    switch (value.kind) {
+        case IrValue::Kind::TEMP: {
+            const Reg src = m_reg_of_temp[value.temp];
+            emit(MachineInstr::makeUnary(value.type == IrType::F32 ? "fmv.s" : "mv", dst, src));
+            break;
+        }
+        case IrValue::Kind::INT:
+            emit(MachineInstr::makeLi(dst, value.intVal));
+            break;
+        case IrValue::Kind::FLOAT: {
+            const std::string &label = m_constant_pool.getLabelOf(value);
+            const Reg addr = m_function->newVirtualReg(RegClass::INT);
+            emit(MachineInstr::makeLui(addr, label));
+            emit(MachineInstr::makeLoad("flw", dst, addr, 0, label));
+            break;
+        }
+        case IrValue::Kind::STRING: {
+            emit(MachineInstr::makeLa(dst, m_constant_pool.getLabelOf(value)));
+            break;
+        }
+        default:
+            printf("Instruction selection: use of an undefined value\n");
+            exit(1);
+    }
+}
+
+Reg InstructionSelector::use(const IrValue &value) {
+    if (value.isTemp()) {
+        return m_reg_of_temp[value.temp];
+    }
+    if (value.kind == IrValue::Kind::INT && value.intVal == 0) {
+        return kRegZero;
+    }
+    const Reg reg = m_function->newVirtualReg(getRegClassOf(value.type));
+    materialize(value, reg);
+    return reg;
+}
+
+Reg InstructionSelector::def(const IrValue &value) const {
+    return m_reg_of_temp[value.temp];
+}
+
+int InstructionSelector::getFrameSlotOf(const int slot) {
+    auto it = m_frame_slot_of_slot.find(slot);
+    if (it == m_frame_slot_of_slot.end()) {
+        it = m_frame_slot_of_slot.emplace(slot, m_function->newFrameSlot(m_ir.getSlot(slot).size))
+                 .first;
+    }
+    return it->second;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+std::unique_ptr<MachineFunction> InstructionSelector::run() {
+    m_function.reset(new MachineFunction(m_ir.getName()));
+    m_block = m_function->appendBlock("");
+
+    for (int temp = 0; temp < m_ir.getNumTemps(); ++temp) {
+        m_reg_of_temp.push_back(
+            m_function->newVirtualReg(getRegClassOf(m_ir.getTempInfo(temp).type)));
+    }
+    m_use_count_of_temp.assign(m_ir.getNumTemps(), 0);
+    for (const auto &block : m_ir.getBlocks()) {
+        for (const IrInstr &instr : block->instrs) {
+            for (const IrValue &operand : instr.operands) {
+                if (operand.isTemp()) {
+                    ++m_use_count_of_temp[operand.temp];
+                }
+            }
+        }
+    }
+    for (const auto &block : m_ir.getBlocks()) {
+        if (!block->preds.empty()) {
+            m_label_of_block[block.get()] = newLabel();
+        }
+    }
+    m_exit_label = newLabel();
+
+    selectParams();
+
+    // An array of our frame may have been passed to the callee, which reads it after the frame
+    // is gone.
+    const bool selectsTailCalls = m_tail_calls && !m_ir.takesAddressOfSlot();
+    const auto &blocks = m_ir.getBlocks();
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const IrBasicBlock *block = blocks[i].get();
+        m_next_block = (i + 1 < blocks.size()) ? blocks[i + 1].get() : nullptr;
+
+        auto label = m_label_of_block.find(block);
+        if (label != m_label_of_block.end()) {
+            if (m_block->instrs.empty() && m_block->label.empty()) {
+                m_block->label = label->second;
+            } else {
+                m_block = m_function->appendBlock(label->second);
+            }
+        }
+        const auto &instrs = block->instrs;
+        for (size_t j = 0; j < instrs.size(); ++j) {
+            if (selectsTailCalls && j + 1 < instrs.size() && isTailCall(instrs[j], instrs[j + 1])) {
+                selectCall(instrs[j++], true);
+                continue;
+            }
+            if (j + 1 < instrs.size() && selectCompareBranch(instrs[j], instrs[j + 1])) {
+                ++j;
+                continue;
+            }
+            selectInstr(instrs[j]);
+        }
+    }
+
+    // All `ret`s jump to the single epilogue, which is unreachable if the last block ends in a tail
+    // call and nothing jumps to it.
+    if (!m_jumps_to_exit && !m_falls_through && m_block->label.empty()) {
+        return std::move(m_function);
+    }
+    if (m_block->instrs.empty() && m_block->label.empty()) {
+        m_block->label = m_exit_label;
+    } else {
+        m_block = m_function->appendBlock(m_exit_label);
+    }
+    std::vector<Reg> retRegs;
+    if (m_ir.getReturnType() == IrType::F32) {
+        retRegs.push_back(kRegFa0);
+    } else if (m_ir.getReturnType() != IrType::VOID) {
+        retRegs.push_back(kRegA0);
+    }
+    emit(MachineInstr::makeRet(retRegs));
+
+    return std::move(m_function);
+}
+
+void InstructionSelector::selectParams() {
+    // same calling convention as CodeGenerator: a0 ~ a7, fa0 ~ fa7, then the caller's stack
+    int floatRegCnt = 0, intRegCnt = 0, stackCnt = 0;
+    for (const IrValue &param : m_ir.getParams()) {
+        const Reg reg = def(param);
+        const bool isReal = param.type == IrType::F32;
+        if (isReal && floatRegCnt < 8) {
+            emit(MachineInstr::makeUnary("fmv.s", reg, getArgReg(RegClass::FLOAT, floatRegCnt++)));
+        } else if (!isReal && intRegCnt < 8) {
+            emit(MachineInstr::makeUnary("mv", reg, getArgReg(RegClass::INT, intRegCnt++)));
+        } else {
+            emit(MachineInstr::makeLoadIncomingStackArg(isReal ? "flw" : "lw", reg, stackCnt++));
+        }
+    }
+}
+
+void InstructionSelector::selectInstr(const IrInstr &instr) {
+    switch (instr.op) {
+        case IrOp::COPY:
+            materialize(instr.operands[0], def(instr.dst));
+            break;
+        case IrOp::NEG: {
+            const Reg operand = use(instr.operands[0]);
+            if (instr.dst.type == IrType::F32) {
+                emit(MachineInstr::makeR("fsgnjn.s", def(instr.dst), operand, operand));
+            } else {
+                emit(MachineInstr::makeR("sub", def(instr.dst), kRegZero, operand));
+            }
+            break;
+        }
+        case IrOp::NOT:
+            emit(MachineInstr::makeI("xori", def(instr.dst), use(instr.operands[0]), 1));
+            break;
+        case IrOp::ITOF:
+            emit(MachineInstr::makeUnary("fcvt.s.w", def(instr.dst), use(instr.operands[0])));
+            break;
+        case IrOp::ADDR:
+        case IrOp::LOAD:
+        case IrOp::STORE:
+            selectMemory(instr);
+            break;
+        case IrOp::CALL:
+            selectCall(instr, false);
+            break;
+        case IrOp::BR:
+            jumpTo(instr.target);
+            break;
+        case IrOp::CBR: {
+            const Reg condition = use(instr.operands[0]);
+            if (instr.target2 == m_next_block) {
+                emit(MachineInstr::makeBranch("bne", condition, kRegZero,
+                                              m_label_of_block.at(instr.target)));
+            } else {
+                emit(MachineInstr::makeBranch("beq", condition, kRegZero,
+                                              m_label_of_block.at(instr.target2)));
+                jumpTo(instr.target);
+            }
+            break;
+        }
+        case IrOp::RET:
+            if (!instr.operands.empty()) {
+                const bool isReal = m_ir.getReturnType() == IrType::F32;
+                materialize(instr.operands[0], isReal ? kRegFa0 : kRegA0);
+            }
+            if (m_next_block != nullptr) {
+                emit(MachineInstr::makeJump(m_exit_label));
+                m_jumps_to_exit = true;
+            }
+            break;
+        default:
+            selectBinary(instr);
+            break;
+    }
+}
+
+bool InstructionSelector::selectByConstant(const IrInstr &instr) {
+    if (!m_strength_reduction || instr.operands[0].type != IrType::I32) {
+        return false;
+    }
+    ArithOp op;
+    switch (instr.op) {
+        case IrOp::MUL:
+            op = ArithOp::MUL;
+            break;
+        case IrOp::DIV:
+            op = ArithOp::DIV;
+            break;
+        case IrOp::REM:
+            op = ArithOp::REM;
+            break;
+        default:
+            return false;
+    }
+    const IrValue *x = &instr.operands[0];
+    const IrValue *c = &instr.operands[1];
+    if (op == ArithOp::MUL && x->kind == IrValue::Kind::INT) {
+        std::swap(x, c);
+    }
+    // (two constants are left to foldConstant)
+    if (c->kind != IrValue::Kind::INT || x->kind == IrValue::Kind::INT) {
+        return false;
+    }
+    const ReducedSequence sequence = reduceByConstant(op, c->intVal);
+    if (sequence.steps.empty()) {
+        return false;
+    }
+
+    std::vector<Reg> scratchRegs(sequence.numScratchRegs + 1);
+    for (int i = 1; i <= sequence.numScratchRegs; ++i) {
+        scratchRegs[i] = m_function->newVirtualReg(RegClass::INT);
+    }
+    // e.g. `x * 0` is `mv rd, zero`, which never reads x
+    const bool readsOperand = std::any_of(
+        sequence.steps.begin(), sequence.steps.end(), [](const ArithStep &step) {
+            return step.rs1 == kSeqOperand || step.rs2 == kSeqOperand;
+        });
+    const Reg operand = readsOperand ? use(*x) : kRegZero;
+    const auto getReg = [&](const int seqReg) {
+        if (seqReg == kSeqOperand) {
+            return operand;
+        }
+        return (seqReg == kSeqZero) ? kRegZero : scratchRegs[seqReg];
+    };
+    for (size_t i = 0; i < sequence.steps.size(); ++i) {
+        const ArithStep &step = sequence.steps[i];
+        const Reg rd = (i + 1 == sequence.steps.size()) ? def(instr.dst) : getReg(step.rd);
+        switch (step.format) {
+            case MachineFormat::R:
+                emit(MachineInstr::makeR(step.opcode, rd, getReg(step.rs1), getReg(step.rs2)));
+                break;
+            case MachineFormat::I:
+                emit(MachineInstr::makeI(step.opcode, rd, getReg(step.rs1), step.imm));
+                break;
+            default:
+                emit(MachineInstr::makeLi(rd, step.imm));
+                break;
+        }
+    }
+    return true;
+}
+
+static PatternOp getPatternOpOf(const IrOp op) {
+    switch (op) {
+        case IrOp::ADD:
+            return PatternOp::ADD;
+        case IrOp::SUB:
+            return PatternOp::SUB;
+        case IrOp::MUL:
+            return PatternOp::MUL;
+        case IrOp::DIV:
+            return PatternOp::DIV;
+        case IrOp::REM:
+            return PatternOp::REM;
+        case IrOp::AND:
+            return PatternOp::AND;
+        case IrOp::OR:
+            return PatternOp::OR;
+        case IrOp::LT:
+            return PatternOp::LT;
+        case IrOp::LE:
+            return PatternOp::LE;
+        case IrOp::NE:
+            return PatternOp::NE;
+        case IrOp::GE:
+            return PatternOp::GE;
+        case IrOp::GT:
+            return PatternOp::GT;
+        case IrOp::EQ:
+            return PatternOp::EQ;
+        default:
+            printf("Unknown bin op\n");
+            exit(1);
+    }
+}
+
+void InstructionSelector::selectByPattern(const IrInstr &instr) {
+    PatternOperand operands[2];
+    for (int k = 0; k < 2; ++k) {
+        if (instr.operands[k].kind == IrValue::Kind::INT) {
+            operands[k] = {true, instr.operands[k].intVal};
+        }
+    }
+    const PatternCover cover = coverBinary(getPatternOpOf(instr.op), operands[0], operands[1]);
+    // an IMM/ZERO operand needs no register
+    const Reg lhs = (cover.rule->left == OperandKind::REG) ? use(instr.operands[0]) : kNoReg;
+    const Reg rhs = (cover.rule->right == OperandKind::REG) ? use(instr.operands[1]) : kNoReg;
+
+    Reg previous = kNoReg;
+    const auto getReg = [&](const int patReg) {
+        switch (patReg) {
+            case kPatLeft:
+                return lhs;
+            case kPatRight:
+                return rhs;
+            case kPatResult:
+                return previous;
+            default:
+                return kRegZero;
+        }
+    };
+    const std::vector<PatternStep> &steps = cover.rule->steps;
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const PatternStep &step = steps[i];
+        const Reg rd =
+            (i + 1 == steps.size()) ? def(instr.dst) : m_function->newVirtualReg(RegClass::INT);
+        if (step.format == MachineFormat::R) {
+            emit(MachineInstr::makeR(step.opcode, rd, getReg(step.rs1), getReg(step.rs2)));
+        } else {
+            emit(MachineInstr::makeI(step.opcode, rd, getReg(step.rs1),
+                                     step.imm == kPatConstant ? cover.imm : step.imm));
+        }
+        previous = rd;
+    }
+}
+
+void InstructionSelector::selectBinary(const IrInstr &instr) {
+    if (selectByConstant(instr)) {
+        return;
+    }
+    if (instr.operands[0].type != IrType::F32) {
+        selectByPattern(instr);
+        return;
+    }
+
+    const Reg lhs = use(instr.operands[0]);
+    const Reg rhs = use(instr.operands[1]);
+    const Reg result = def(instr.dst);
+
+    // - Float operations
+
+    switch (instr.op) {
+        case IrOp::ADD:
+            emit(MachineInstr::makeR("fadd.s", result, lhs, rhs));
+            break;
+        case IrOp::SUB:
+            emit(MachineInstr::makeR("fsub.s", result, lhs, rhs));
+            break;
+        case IrOp::MUL:
+            emit(MachineInstr::makeR("fmul.s", result, lhs, rhs));
+            break;
+        case IrOp::DIV:
+            emit(MachineInstr::makeR("fdiv.s", result, lhs, rhs));
+            break;
+        case IrOp::LT:
+            emit(MachineInstr::makeR("flt.s", result, lhs, rhs));
+            break;
+        case IrOp::LE:
+            emit(MachineInstr::makeR("fle.s", result, lhs, rhs));
+            break;
+        case IrOp::NE: {
+            const Reg equal = m_function->newVirtualReg(RegClass::INT);
+            emit(MachineInstr::makeR("feq.s", equal, lhs, rhs));
+            emit(MachineInstr::makeI("xori", result, equal, 1));
+            break;
+        }
+        case IrOp::GE:
+            emit(MachineInstr::makeR("fle.s", result, rhs, lhs));
+            break;
+        case IrOp::GT:
+            emit(MachineInstr::makeR("flt.s", result, rhs, lhs));
+            break;
+        case IrOp::EQ:
+            emit(MachineInstr::makeR("feq.s", result, lhs, rhs));
+            break;
+        default:
+            printf("Invalid bin op for real type\n");
+            exit(1);
+    }
+}
+
+bool InstructionSelector::selectCompareBranch(const IrInstr &compare, const IrInstr &branch) {
+    if (compare.op < IrOp::LT || compare.op > IrOp::EQ || branch.op != IrOp::CBR ||
+        !branch.operands[0].isSameAs(compare.dst) ||
+        m_use_count_of_temp[compare.dst.temp] != 1) {
+        return false;
+    }
+    // Branch to the target that is not laid out next, on the condition (or its negation).
+    const bool branchesIfTrue = branch.target2 == m_next_block;
+    const IrBasicBlock *target = branchesIfTrue ? branch.target : branch.target2;
+    const std::string &label = m_label_of_block.at(target);
+    Reg lhs = use(compare.operands[0]);
+    Reg rhs = use(compare.operands[1]);
+
+    if (compare.operands[0].type == IrType::F32) {
+        // flt.s/fle.s/feq.s, then branch on the 0/1 result
+        const Reg result = m_function->newVirtualReg(RegClass::INT);
+        bool holdsCondition = true;
+        switch (compare.op) {
+            case IrOp::LT:
+                emit(MachineInstr::makeR("flt.s", result, lhs, rhs));
+                break;
+            case IrOp::LE:
+                emit(MachineInstr::makeR("fle.s", result, lhs, rhs));
+                break;
+            case IrOp::GT:
+                emit(MachineInstr::makeR("flt.s", result, rhs, lhs));
+                break;
+            case IrOp::GE:
+                emit(MachineInstr::makeR("fle.s", result, rhs, lhs));
+                break;
+            case IrOp::EQ:
+                emit(MachineInstr::makeR("feq.s", result, lhs, rhs));
+                break;
+            default:  // NE
+                emit(MachineInstr::makeR("feq.s", result, lhs, rhs));
+                holdsCondition = false;
+                break;
+        }
+        emit(MachineInstr::makeBranch(holdsCondition == branchesIfTrue ? "bne" : "beq", result,
+                                      kRegZero, label));
+    } else {
+        const IrOp op = branchesIfTrue ? compare.op : negateComparison(compare.op);
+        // a <= b is b >= a, a > b is b < a
+        if (op == IrOp::LE || op == IrOp::GT) {
+            std::swap(lhs, rhs);
+        }
+        const char *opcode;
+        switch (op) {
+            case IrOp::LT:
+            case IrOp::GT:
+                opcode = "blt";
+                break;
+            case IrOp::LE:
+            case IrOp::GE:
+                opcode = "bge";
+                break;
+            case IrOp::NE:
+                opcode = "bne";
+                break;
+            default:
+                opcode = "beq";
+                break;
+        }
+        emit(MachineInstr::makeBranch(opcode, lhs, rhs, label));
+    }
+    if (!branchesIfTrue) {
+        jumpTo(branch.target);
+    }
+    return true;
+}
+
+void InstructionSelector::selectMemory(const IrInstr &instr) {
+    if (instr.op == IrOp::ADDR) {
+        if (instr.address.kind == IrAddress::Kind::SLOT) {
+            emit(MachineInstr::makeAddrSlot(def(instr.dst), getFrameSlotOf(instr.address.slot)));
+        } else {
+            emit(MachineInstr::makeLa(def(instr.dst), instr.address.global));
+        }
+        return;
+    }
+
+    const bool isLoad = instr.op == IrOp::LOAD;
+    const IrType type = isLoad ? instr.dst.type : instr.operands[0].type;
+    const bool isReal = type == IrType::F32;
+    const char *op = isLoad ? (isReal ? "flw" : "lw") : (isReal ? "fsw" : "sw");
+
+    if (instr.address.kind == IrAddress::Kind::SLOT) {
+        const int frameSlot = getFrameSlotOf(instr.address.slot);
+        if (isLoad) {
+            emit(MachineInstr::makeLoadSlot(op, def(instr.dst), frameSlot));
+        } else {
+            emit(MachineInstr::makeStoreSlot(op, use(instr.operands[0]), frameSlot));
+        }
+        return;
+    }
+
+    // Global, or through a pointer
+    const Reg value = isLoad ? def(instr.dst) : use(instr.operands[0]);
+    Reg addr;
+    if (instr.address.kind == IrAddress::Kind::POINTER) {
+        addr = use(instr.operands.back());
+    } else {
+        // lui + %lo(global) in the load/store itself
+        addr = m_function->newVirtualReg(RegClass::INT);
+        emit(MachineInstr::makeLui(addr, instr.address.global));
+    }
+    const std::string symbol =
+        (instr.address.kind == IrAddress::Kind::POINTER) ? "" : instr.address.global;
+    if (isLoad) {
+        emit(MachineInstr::makeLoad(op, value, addr, 0, symbol));
+    } else {
+        emit(MachineInstr::makeStore(op, value, addr, 0, symbol));
+    }
+}
+
+void InstructionSelector::selectCall(const IrInstr &instr, const bool isTail) {
+    // Values living in temporaries are already computed, so only the constants are left to
+    // put into the argument registers.
+    std::vector<Reg> argRegs;
+    int floatRegCnt = 0, intRegCnt = 0, stackCnt = 0;
+    for (const IrValue &arg : instr.operands) {
+        const bool isReal = arg.type == IrType::F32;
+        if (isReal && floatRegCnt < 8) {
+            argRegs.push_back(getArgReg(RegClass::FLOAT, floatRegCnt++));
+            materialize(arg, argRegs.back());
+        } else if (!isReal && intRegCnt < 8) {
+            argRegs.push_back(getArgReg(RegClass::INT, intRegCnt++));
+            materialize(arg, argRegs.back());
+        } else {
+            // the outgoing argument area is at the bottom of the frame
+            emit(MachineInstr::makeStore(isReal ? "fsw" : "sw", use(arg), kRegSp, 4 * stackCnt++));
+        }
+    }
+    m_function->noteOutgoingStackArgs(stackCnt);
+
+    if (isTail) {
+        emit(MachineInstr::makeTailCall(instr.callee, argRegs));
+        return;
+    }
+    emit(MachineInstr::makeCall(instr.callee, argRegs));
+
+    if (instr.dst.isTemp()) {
+        const bool isReal = instr.dst.type == IrType::F32;
+        emit(MachineInstr::makeUnary(isReal ? "fmv.s" : "mv", def(instr.dst),
+                                     isReal ? kRegFa0 : kRegA0));
+    }
+}
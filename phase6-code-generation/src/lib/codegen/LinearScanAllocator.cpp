@@ -0,0 +1,330 @@
+#include "codegen/LinearScanAllocator.hpp"
+
+#include "codegen/MachineCode.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// clang-format off
+// t0 ~ t4, s1 ~ s11
+static const Reg kIntCallerSaved[] = {5, 6, 7, 28, 29};
+static const Reg kIntCalleeSaved[] = {9, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27};
+// ft0 ~ ft9, fs0 ~ fs11
+static const Reg kFloatCallerSaved[] = {32, 33, 34, 35, 36, 37, 38, 39, 60, 61};
+static const Reg kFloatCalleeSaved[] = {40, 41, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59};
+// t5, t6 / ft10, ft11
+static const Reg kIntScratch[] = {30, 31};
+static const Reg kFloatScratch[] = {62, 63};
+// clang-format on
+
+void LinearScanAllocator::run() {
+    computeLiveIntervals();
+    allocateRegisters();
+    rewriteFunction();
+}
+
+void LinearScanAllocator::computeLiveIntervals() {
+    auto &blocks = m_function.getBlocks();
+    const int numBlocks = blocks.size();
+    const int numVRegs = m_function.getNumVirtualRegs();
+
+    // - Control flow between blocks
+
+    std::unordered_map<std::string, int> blockOfLabel;
+    for (int i = 0; i < numBlocks; ++i) {
+        if (!blocks[i]->label.empty()) {
+            blockOfLabel[blocks[i]->label] = i;
+        }
+    }
+    std::vector<std::vector<int>> successors(numBlocks);
+    for (int i = 0; i < numBlocks; ++i) {
+        bool fallsThrough = true;
+        for (const auto &instr : blocks[i]->instrs) {
+            if (instr.format == MachineFormat::BRANCH || instr.format == MachineFormat::JUMP) {
+                successors[i].push_back(blockOfLabel.at(instr.symbol));
+            }
+            if (instr.format == MachineFormat::JUMP || instr.format == MachineFormat::RET) {
+                fallsThrough = false;
+            }
+        }
+        if (fallsThrough && i + 1 < numBlocks) {
+            successors[i].push_back(i + 1);
+        }
+    }
+
+    // - Local uses/defs and instruction numbering
+    // Instructions are numbered 0, 2, 4, ... in layout order.
+
+    std::vector<std::vector<bool>> upwardUses(numBlocks, std::vector<bool>(numVRegs));
+    std::vector<std::vector<bool>> defs(numBlocks, std::vector<bool>(numVRegs));
+    std::vector<int> blockStart(numBlocks), blockEnd(numBlocks);
+    std::vector<int> callPositions;
+
+    m_intervals.clear();
+    for (int v = 0; v < numVRegs; ++v) {
+        m_intervals.push_back(LiveInterval{kFirstVirtualReg + v, INT_MAX, INT_MIN});
+    }
+    auto extend = [&](Reg r, int pos) {
+        LiveInterval &interval = m_intervals[r - kFirstVirtualReg];
+        interval.start = std::min(interval.start, pos);
+        interval.end = std::max(interval.end, pos);
+    };
+
+    int pos = 0;
+    for (int i = 0; i < numBlocks; ++i) {
+        blockStart[i] = pos;
+        for (const auto &instr : blocks[i]->instrs) {
+            for (Reg r : instr.getUses()) {
+                if (isVirtualReg(r)) {
+                    if (!defs[i][r - kFirstVirtualReg]) {
+                        upwardUses[i][r - kFirstVirtualReg] = true;
+                    }
+                    extend(r, pos);
+                }
+            }
+            for (Reg r : instr.getDefs()) {
+                if (isVirtualReg(r)) {
+                    defs[i][r - kFirstVirtualReg] = true;
+                    extend(r, pos);
+                }
+            }
+            if (instr.isCall()) {
+                callPositions.push_back(pos);
+            }
+            pos += 2;
+        }
+        blockEnd[i] = std::max(blockStart[i], pos - 2);
+    }
+
+    // - Global liveness (iterate to a fixed point, backwards for faster convergence)
+
+    std::vector<std::vector<bool>> liveIn(numBlocks, std::vector<bool>(numVRegs));
+    std::vector<std::vector<bool>> liveOut(numBlocks, std::vector<bool>(numVRegs));
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = numBlocks - 1; i >= 0; --i) {
+            for (int succ : successors[i]) {
+                for (int v = 0; v < numVRegs; ++v) {
+                    if (liveIn[succ][v] && !liveOut[i][v]) {
+                        liveOut[i][v] = true;
+                        changed = true;
+                    }
+                }
+            }
+            for (int v = 0; v < numVRegs; ++v) {
+                const bool in = upwardUses[i][v] || (liveOut[i][v] && !defs[i][v]);
+                if (in && !liveIn[i][v]) {
+                    liveIn[i][v] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < numBlocks; ++i) {
+        for (int v = 0; v < numVRegs; ++v) {
+            if (liveIn[i][v]) {
+                extend(kFirstVirtualReg + v, blockStart[i]);
+            }
+            if (liveOut[i][v]) {
+                // + 1: still alive after the last instruction of the block
+                extend(kFirstVirtualReg + v, blockEnd[i] + 1);
+            }
+        }
+    }
+
+    for (auto &interval : m_intervals) {
+        for (int callPos : callPositions) {
+            if (interval.start < callPos && callPos < interval.end) {
+                interval.crossesCall = true;
+                break;
+            }
+        }
+    }
+}
+
+void LinearScanAllocator::allocateRegisters() {
+    std::vector<LiveInterval *> unhandled;
+    for (auto &interval : m_intervals) {
+        if (interval.start <= interval.end) {
+            unhandled.push_back(&interval);
+        }
+    }
+    std::stable_sort(unhandled.begin(), unhandled.end(),
+                     [](const LiveInterval *a, const LiveInterval *b) { return a->start < b->start; });
+
+    std::vector<LiveInterval *> active;
+    std::vector<bool> isFree(kFirstVirtualReg, true);
+    std::vector<Reg> usedCalleeSaved;
+
+    auto assign = [&](LiveInterval *interval, Reg r) {
+        interval->physReg = r;
+        isFree[r] = false;
+        active.push_back(interval);
+        if (isCalleeSavedReg(r) &&
+            std::find(usedCalleeSaved.begin(), usedCalleeSaved.end(), r) == usedCalleeSaved.end()) {
+            usedCalleeSaved.push_back(r);
+        }
+    };
+    auto spill = [&](LiveInterval *interval) {
+        interval->physReg = kNoReg;
+        interval->spillSlot = m_function.newFrameSlot(4);
+    };
+
+    for (LiveInterval *current : unhandled) {
+        // Expire the intervals that end before the current one starts.
+        // An interval ending exactly at `current->start` is last read by the instruction that
+        // defines `current`, so the two can share a register.
+        for (auto it = active.begin(); it != active.end();) {
+            if ((*it)->end <= current->start) {
+                isFree[(*it)->physReg] = true;
+                it = active.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        const RegClass cls = m_function.getRegClass(current->vreg);
+        std::vector<Reg> candidates;
+        if (!current->crossesCall) {
+            if (cls == RegClass::INT) {
+                candidates.insert(candidates.end(), std::begin(kIntCallerSaved),
+                                  std::end(kIntCallerSaved));
+            } else {
+                candidates.insert(candidates.end(), std::begin(kFloatCallerSaved),
+                                  std::end(kFloatCallerSaved));
+            }
+        }
+        if (cls == RegClass::INT) {
+            candidates.insert(candidates.end(), std::begin(kIntCalleeSaved),
+                              std::end(kIntCalleeSaved));
+            if (m_function.omitsFramePointer()) {
+                candidates.push_back(kRegS0);
+            }
+        } else {
+            candidates.insert(candidates.end(), std::begin(kFloatCalleeSaved),
+                              std::end(kFloatCalleeSaved));
+        }
+
+        auto freeReg = std::find_if(candidates.begin(), candidates.end(),
+                                    [&](Reg r) { return isFree[r]; });
+        if (freeReg != candidates.end()) {
+            assign(current, *freeReg);
+            continue;
+        }
+
+        // No register left: spill the interval that ends last (possibly the current one).
+        LiveInterval *victim = nullptr;
+        for (LiveInterval *interval : active) {
+            const bool usable = std::find(candidates.begin(), candidates.end(),
+                                          interval->physReg) != candidates.end();
+            if (usable && (victim == nullptr || interval->end > victim->end)) {
+                victim = interval;
+            }
+        }
+        if (victim != nullptr && victim->end > current->end) {
+            const Reg r = victim->physReg;
+            active.erase(std::find(active.begin(), active.end(), victim));
+            spill(victim);
+            assign(current, r);
+        } else {
+            spill(current);
+        }
+    }
+
+    std::sort(usedCalleeSaved.begin(), usedCalleeSaved.end());
+    m_function.setUsedCalleeSavedRegs(usedCalleeSaved);
+}
+
+void LinearScanAllocator::rewriteFunction() {
+    for (auto &block : m_function.getBlocks()) {
+        std::vector<MachineInstr> rewritten;
+        rewritten.reserve(block->instrs.size());
+
+        for (auto &instr : block->instrs) {
+            std::vector<MachineInstr> reloads, stores;
+            int intScratchUsed = 0, floatScratchUsed = 0;
+            std::unordered_map<Reg, Reg> reloaded;
+
+            auto rewriteUse = [&](Reg &r) {
+                if (!isVirtualReg(r)) {
+                    return;
+                }
+                const LiveInterval &interval = m_intervals[r - kFirstVirtualReg];
+                if (interval.spillSlot < 0) {
+                    r = interval.physReg;
+                    return;
+                }
+                auto it = reloaded.find(r);
+                if (it != reloaded.end()) {
+                    r = it->second;
+                    return;
+                }
+                const bool isFloat = m_function.getRegClass(r) == RegClass::FLOAT;
+                const Reg scratch =
+                    isFloat ? kFloatScratch[floatScratchUsed++] : kIntScratch[intScratchUsed++];
+                reloads.push_back(
+                    MachineInstr::makeLoadSlot(isFloat ? "flw" : "lw", scratch, interval.spillSlot));
+                reloaded[r] = scratch;
+                r = scratch;
+            };
+            auto rewriteDef = [&](Reg &r) {
+                if (!isVirtualReg(r)) {
+                    return;
+                }
+                const LiveInterval &interval = m_intervals[r - kFirstVirtualReg];
+                if (interval.spillSlot < 0) {
+                    r = interval.physReg;
+                    return;
+                }
+                // all uses are read before the write, so the first scratch can be reused
+                const bool isFloat = m_function.getRegClass(r) == RegClass::FLOAT;
+                const Reg scratch = isFloat ? kFloatScratch[0] : kIntScratch[0];
+                stores.push_back(MachineInstr::makeStoreSlot(isFloat ? "fsw" : "sw", scratch,
+                                                             interval.spillSlot));
+                r = scratch;
+            };
+
+            switch (instr.format) {
+                case MachineFormat::R:
+                    rewriteUse(instr.rs1);
+                    rewriteUse(instr.rs2);
+                    rewriteDef(instr.rd);
+                    break;
+                case MachineFormat::I:
+                case MachineFormat::UNARY:
+                case MachineFormat::LOAD:
+                    rewriteUse(instr.rs1);
+                    rewriteDef(instr.rd);
+                    break;
+                case MachineFormat::LI:
+                case MachineFormat::LA:
+                case MachineFormat::LUI:
+                    rewriteDef(instr.rd);
+                    break;
+                case MachineFormat::STORE:
+                case MachineFormat::BRANCH:
+                    rewriteUse(instr.rs1);
+                    rewriteUse(instr.rs2);
+                    break;
+                default:
+                    break;
+            }
+
+            // moves that were coalesced by the allocation are no longer needed
+            const bool isMove = instr.opcode == "mv" || instr.opcode == "fmv.s";
+            if (isMove && instr.rd == instr.rs1 && stores.empty()) {
+                continue;
+            }
+
+            rewritten.insert(rewritten.end(), reloads.begin(), reloads.end());
+            rewritten.push_back(std::move(instr));
+            rewritten.insert(rewritten.end(), stores.begin(), stores.end());
+        }
+        block->instrs = std::move(rewritten);
+    }
+}
@@ -0,0 +1,486 @@
+#include "codegen/MachineCode.hpp"
+
+#include <cassert>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// clang-format off
+static const char *const kIntRegNames[] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+    "s0", "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+    "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+    "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+static const char *const kFloatRegNames[] = {
+    "ft0", "ft1", "ft2", "ft3", "ft4", "ft5", "ft6", "ft7",
+    "fs0", "fs1", "fa0", "fa1", "fa2", "fa3", "fa4", "fa5",
+    "fa6", "fa7", "fs2", "fs3", "fs4", "fs5", "fs6", "fs7",
+    "fs8", "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"};
+// clang-format on
+
+const char *getPhysRegName(const Reg r) {
+    assert(r >= 0 && r < kFirstVirtualReg && "not a physical register");
+    return (r < kFirstFloatReg) ? kIntRegNames[r] : kFloatRegNames[r - kFirstFloatReg];
+}
+
+Reg getArgReg(const RegClass cls, const int index) {
+    assert(index >= 0 && index < 8);
+    return (cls == RegClass::INT) ? kRegA0 + index : kRegFa0 + index;
+}
+
+bool isCalleeSavedReg(const Reg r) {
+    // s0, s1, s2 ~ s11 and fs0, fs1, fs2 ~ fs11
+    const int num = (r < kFirstFloatReg) ? r : r - kFirstFloatReg;
+    return num == 8 || num == 9 || (18 <= num && num <= 27);
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+std::vector<Reg> MachineInstr::getDefs() const {
+    switch (format) {
+        case MachineFormat::R:
+        case MachineFormat::I:
+        case MachineFormat::UNARY:
+        case MachineFormat::LI:
+        case MachineFormat::LA:
+        case MachineFormat::LUI:
+        case MachineFormat::LOAD:
+            return {rd};
+        default:
+            return {};
+    }
+}
+
+std::vector<Reg> MachineInstr::getUses() const {
+    std::vector<Reg> uses;
+    switch (format) {
+        case MachineFormat::R:
+        case MachineFormat::BRANCH:
+            uses = {rs1, rs2};
+            break;
+        case MachineFormat::I:
+            if (!accessesFrame()) {
+                uses = {rs1};
+            }
+            break;
+        case MachineFormat::UNARY:
+            uses = {rs1};
+            break;
+        case MachineFormat::LOAD:
+            if (!accessesFrame()) {
+                uses = {rs1};
+            }
+            break;
+        case MachineFormat::STORE:
+            uses = {rs2};
+            if (!accessesFrame()) {
+                uses.push_back(rs1);
+            }
+            break;
+        case MachineFormat::CALL:
+        case MachineFormat::RET:
+            uses = implicitUses;
+            break;
+        default:
+            break;
+    }
+    return uses;
+}
+
+MachineInstr MachineInstr::makeR(const char *op, Reg rd, Reg rs1, Reg rs2) {
+    MachineInstr instr{op, MachineFormat::R};
+    instr.rd = rd;
+    instr.rs1 = rs1;
+    instr.rs2 = rs2;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeI(const char *op, Reg rd, Reg rs1, int32_t imm) {
+    MachineInstr instr{op, MachineFormat::I};
+    instr.rd = rd;
+    instr.rs1 = rs1;
+    instr.imm = imm;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeUnary(const char *op, Reg rd, Reg rs1) {
+    MachineInstr instr{op, MachineFormat::UNARY};
+    instr.rd = rd;
+    instr.rs1 = rs1;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeLi(Reg rd, int32_t imm) {
+    MachineInstr instr{"li", MachineFormat::LI};
+    instr.rd = rd;
+    instr.imm = imm;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeLa(Reg rd, const std::string &symbol) {
+    MachineInstr instr{"la", MachineFormat::LA};
+    instr.rd = rd;
+    instr.symbol = symbol;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeLui(Reg rd, const std::string &symbol) {
+    MachineInstr instr{"lui", MachineFormat::LUI};
+    instr.rd = rd;
+    instr.symbol = symbol;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeLoad(const char *op, Reg rd, Reg base, int32_t offset,
+                                    const std::string &symbol) {
+    MachineInstr instr{op, MachineFormat::LOAD};
+    instr.rd = rd;
+    instr.rs1 = base;
+    instr.imm = offset;
+    instr.symbol = symbol;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeStore(const char *op, Reg value, Reg base, int32_t offset,
+                                     const std::string &symbol) {
+    MachineInstr instr{op, MachineFormat::STORE};
+    instr.rs2 = value;
+    instr.rs1 = base;
+    instr.imm = offset;
+    instr.symbol = symbol;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeLoadSlot(const char *op, Reg rd, int slot) {
+    MachineInstr instr{op, MachineFormat::LOAD};
+    instr.rd = rd;
+    instr.frameSlot = slot;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeStoreSlot(const char *op, Reg value, int slot) {
+    MachineInstr instr{op, MachineFormat::STORE};
+    instr.rs2 = value;
+    instr.frameSlot = slot;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeAddrSlot(Reg rd, int slot) {
+    MachineInstr instr{"addi", MachineFormat::I};
+    instr.rd = rd;
+    instr.frameSlot = slot;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeLoadIncomingStackArg(const char *op, Reg rd, int index) {
+    MachineInstr instr{op, MachineFormat::LOAD};
+    instr.rd = rd;
+    instr.incomingStackArg = index;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeBranch(const char *op, Reg rs1, Reg rs2, const std::string &label) {
+    MachineInstr instr{op, MachineFormat::BRANCH};
+    instr.rs1 = rs1;
+    instr.rs2 = rs2;
+    instr.symbol = label;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeJump(const std::string &label) {
+    MachineInstr instr{"j", MachineFormat::JUMP};
+    instr.symbol = label;
+    return instr;
+}
+
+MachineInstr MachineInstr::makeCall(const std::string &callee, std::vector<Reg> argRegs) {
+    MachineInstr instr{"jal", MachineFormat::CALL};
+    instr.symbol = callee;
+    instr.implicitUses = std::move(argRegs);
+    return instr;
+}
+
+MachineInstr MachineInstr::makeRet(std::vector<Reg> retRegs) {
+    MachineInstr instr{"ret", MachineFormat::RET};
+    instr.implicitUses = std::move(retRegs);
+    return instr;
+}
+
+MachineInstr MachineInstr::makeTailCall(const std::string &callee, std::vector<Reg> argRegs) {
+    MachineInstr instr{"tail", MachineFormat::RET};
+    instr.symbol = callee;
+    instr.implicitUses = std::move(argRegs);
+    return instr;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+Reg MachineFunction::newVirtualReg(const RegClass cls) {
+    m_vreg_classes.push_back(cls);
+    return kFirstVirtualReg + m_vreg_classes.size() - 1;
+}
+
+RegClass MachineFunction::getRegClass(const Reg r) const {
+    if (isVirtualReg(r)) {
+        return m_vreg_classes.at(r - kFirstVirtualReg);
+    }
+    return (r < kFirstFloatReg) ? RegClass::INT : RegClass::FLOAT;
+}
+
+int MachineFunction::newFrameSlot(const int size) {
+    m_frame_slot_sizes.push_back(size);
+    return m_frame_slot_sizes.size() - 1;
+}
+
+MachineBasicBlock *MachineFunction::appendBlock(const std::string &label) {
+    m_blocks.emplace_back(new MachineBasicBlock{label, {}});
+    return m_blocks.back().get();
+}
+
+void MachineFunction::noteOutgoingStackArgs(const int count) {
+    if (count > m_max_outgoing_stack_args) {
+        m_max_outgoing_stack_args = count;
+    }
+}
+
+void MachineFunction::omitFramePointerIfLeaf() {
+    for (const auto &block : m_blocks) {
+        for (const MachineInstr &instr : block->instrs) {
+            if (instr.isCall()) {
+                return;
+            }
+        }
+    }
+    // Every offset from sp must fit in a 12-bit immediate, whatever the allocator adds:
+    // at most one spill slot per virtual register and 24 callee-saved registers.
+    int maxSize = 16 + 4 * 24 + 4 * getNumVirtualRegs();
+    for (int slotSize : m_frame_slot_sizes) {
+        maxSize += slotSize;
+    }
+    m_omits_frame_pointer = maxSize <= 2047;
+}
+
+int MachineFunction::getFrameSize() const {
+    int size = getSizeOfLinkArea() + 4 * m_used_callee_saved_regs.size() +
+               4 * m_max_outgoing_stack_args;
+    for (int slotSize : m_frame_slot_sizes) {
+        size += slotSize;
+    }
+    // the stack pointer is always kept 16-byte aligned
+    return (size + 15) / 16 * 16;
+}
+
+int MachineFunction::getFrameSlotOffset(const int slot) const {
+    auto isScalar = [this](const int i) { return m_frame_slot_sizes[i] == 4; };
+    int offset = -getSizeOfLinkArea() - 4 * static_cast<int>(m_used_callee_saved_regs.size());
+    for (int i = 0; i < static_cast<int>(m_frame_slot_sizes.size()); ++i) {
+        const bool isAbove = (isScalar(i) == isScalar(slot)) ? i <= slot : isScalar(i);
+        if (isAbove) {
+            offset -= m_frame_slot_sizes[i];
+        }
+    }
+    return offset;
+}
+
+std::string MachineFunction::getFrameAddress(const int offset) const {
+    if (m_omits_frame_pointer) {
+        return std::to_string(getFrameSize() + offset) + "(sp)";
+    }
+    return std::to_string(offset) + "(s0)";
+}
+
+static void dumpInstructions(FILE *p_out_file, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(p_out_file, format, args);
+    va_end(args);
+}
+
+static const char *getCalleeSavedStoreOp(const Reg r) {
+    return (r < kFirstFloatReg) ? "sw" : "fsw";
+}
+
+static const char *getCalleeSavedLoadOp(const Reg r) {
+    return (r < kFirstFloatReg) ? "lw" : "flw";
+}
+
+void MachineFunction::dump(FILE *p_out_file) const {
+    const int frameSize = getFrameSize();
+    const char *name = m_name.c_str();
+
+    // clang-format off
+    constexpr const char *const riscv_assembly_func =
+        "    .section    .text\n"
+        "    .align 2\n"
+        "    .globl %s          # emit symbol '%s' to the global symbol table\n"
+        "    .type %s, @function\n"
+        "%s:\n"
+        "    # in the function prologue\n";
+    // clang-format on
+    dumpInstructions(p_out_file, riscv_assembly_func, name, name, name, name);
+
+    if (m_omits_frame_pointer) {
+        // a leaf: ra is never overwritten and nothing needs s0
+        if (frameSize > 0) {
+            dumpInstructions(p_out_file, "    addi sp, sp, -%d\n", frameSize);
+        }
+    } else if (frameSize <= 2047) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_func_prologue =
+            "    addi sp, sp, -%d\n"
+            "    sw ra, %d(sp)\n"
+            "    sw s0, %d(sp)\n"
+            "    addi s0, sp, %d\n";
+        // clang-format on
+        dumpInstructions(p_out_file, riscv_assembly_func_prologue, frameSize, frameSize - 4,
+                         frameSize - 8, frameSize);
+    } else {
+        // the frame size does not fit in a 12-bit immediate
+        // clang-format off
+        constexpr const char *const riscv_assembly_func_prologue =
+            "    li t0, %d\n"
+            "    sub sp, sp, t0\n"
+            "    add t0, sp, t0\n"
+            "    sw ra, -4(t0)\n"
+            "    sw s0, -8(t0)\n"
+            "    mv s0, t0\n";
+        // clang-format on
+        dumpInstructions(p_out_file, riscv_assembly_func_prologue, frameSize);
+    }
+    for (size_t i = 0; i < m_used_callee_saved_regs.size(); ++i) {
+        const Reg r = m_used_callee_saved_regs[i];
+        const int offset = -getSizeOfLinkArea() - 4 - 4 * static_cast<int>(i);
+        dumpInstructions(p_out_file, "    %s %s, %s\n", getCalleeSavedStoreOp(r),
+                         getPhysRegName(r), getFrameAddress(offset).c_str());
+    }
+
+    for (const auto &block : m_blocks) {
+        if (!block->label.empty()) {
+            dumpInstructions(p_out_file, "%s:\n", block->label.c_str());
+        }
+        for (const auto &instr : block->instrs) {
+            dumpInstr(p_out_file, instr);
+        }
+    }
+
+    dumpInstructions(p_out_file, "    .size %s, .-%s\n", name, name);
+}
+
+void MachineFunction::dumpInstr(FILE *p_out_file, const MachineInstr &instr) const {
+    const char *op = instr.opcode.c_str();
+    auto name = [](Reg r) { return getPhysRegName(r); };
+    std::string address;
+    if (instr.format == MachineFormat::LOAD || instr.format == MachineFormat::STORE) {
+        if (instr.frameSlot >= 0) {
+            address = getFrameAddress(getFrameSlotOffset(instr.frameSlot));
+        } else if (instr.incomingStackArg >= 0) {
+            // right above the frame
+            address = getFrameAddress(4 * instr.incomingStackArg);
+        } else if (!instr.symbol.empty()) {
+            address = "%lo(" + instr.symbol + ")(" + name(instr.rs1) + ")";
+        } else {
+            address = std::to_string(instr.imm) + "(" + name(instr.rs1) + ")";
+        }
+    }
+
+    switch (instr.format) {
+        case MachineFormat::R:
+            dumpInstructions(p_out_file, "    %s %s, %s, %s", op, name(instr.rd), name(instr.rs1),
+                             name(instr.rs2));
+            break;
+        case MachineFormat::I: {
+            if (instr.frameSlot < 0) {
+                dumpInstructions(p_out_file, "    %s %s, %s, %d", op, name(instr.rd),
+                                 name(instr.rs1), instr.imm);
+                break;
+            }
+            int offset = getFrameSlotOffset(instr.frameSlot);
+            const char *base = "s0";
+            if (m_omits_frame_pointer) {
+                offset += getFrameSize();
+                base = "sp";
+            }
+            if (offset >= -2048 && offset <= 2047) {
+                dumpInstructions(p_out_file, "    addi %s, %s, %d", name(instr.rd), base, offset);
+            } else {
+                dumpInstructions(p_out_file, "    li %s, %d\n    add %s, %s, %s", name(instr.rd),
+                                 offset, name(instr.rd), base, name(instr.rd));
+            }
+            break;
+        }
+        case MachineFormat::UNARY:
+            dumpInstructions(p_out_file, "    %s %s, %s", op, name(instr.rd), name(instr.rs1));
+            break;
+        case MachineFormat::LI:
+            dumpInstructions(p_out_file, "    li %s, %d", name(instr.rd), instr.imm);
+            break;
+        case MachineFormat::LA:
+            dumpInstructions(p_out_file, "    la %s, %s", name(instr.rd), instr.symbol.c_str());
+            break;
+        case MachineFormat::LUI:
+            dumpInstructions(p_out_file, "    lui %s, %%hi(%s)", name(instr.rd),
+                             instr.symbol.c_str());
+            break;
+        case MachineFormat::LOAD:
+            dumpInstructions(p_out_file, "    %s %s, %s", op, name(instr.rd), address.c_str());
+            break;
+        case MachineFormat::STORE:
+            dumpInstructions(p_out_file, "    %s %s, %s", op, name(instr.rs2), address.c_str());
+            break;
+        case MachineFormat::BRANCH:
+            dumpInstructions(p_out_file, "    %s %s, %s, %s", op, name(instr.rs1),
+                             name(instr.rs2), instr.symbol.c_str());
+            break;
+        case MachineFormat::JUMP:
+            dumpInstructions(p_out_file, "    j %s", instr.symbol.c_str());
+            break;
+        case MachineFormat::CALL:
+            dumpInstructions(p_out_file, "    jal ra, %s", instr.symbol.c_str());
+            break;
+        case MachineFormat::RET: {
+            dumpInstructions(p_out_file, "    # in the function epilogue\n");
+            for (size_t i = 0; i < m_used_callee_saved_regs.size(); ++i) {
+                const Reg r = m_used_callee_saved_regs[i];
+                const int offset = -getSizeOfLinkArea() - 4 - 4 * static_cast<int>(i);
+                dumpInstructions(p_out_file, "    %s %s, %s\n", getCalleeSavedLoadOp(r),
+                                 getPhysRegName(r), getFrameAddress(offset).c_str());
+            }
+            const int frameSize = getFrameSize();
+            const std::string ret = instr.symbol.empty() ? "jr ra" : "j " + instr.symbol;
+            if (m_omits_frame_pointer) {
+                if (frameSize > 0) {
+                    dumpInstructions(p_out_file, "    addi sp, sp, %d\n", frameSize);
+                }
+                dumpInstructions(p_out_file, "    %s", ret.c_str());
+            } else if (frameSize <= 2047) {
+                // clang-format off
+                constexpr const char *const riscv_assembly_func_epilogue =
+                    "    lw ra, %d(sp)\n"
+                    "    lw s0, %d(sp)\n"
+                    "    addi sp, sp, %d\n"
+                    "    %s";
+                // clang-format on
+                dumpInstructions(p_out_file, riscv_assembly_func_epilogue, frameSize - 4,
+                                 frameSize - 8, frameSize, ret.c_str());
+            } else {
+                // clang-format off
+                constexpr const char *const riscv_assembly_func_epilogue =
+                    "    lw ra, -4(s0)\n"
+                    "    mv t0, s0\n"
+                    "    lw s0, -8(s0)\n"
+                    "    mv sp, t0\n"
+                    "    %s";
+                // clang-format on
+                dumpInstructions(p_out_file, riscv_assembly_func_epilogue, ret.c_str());
+            }
+            break;
+        }
+    }
+
+    if (!instr.comment.empty()) {
+        dumpInstructions(p_out_file, "    # %s", instr.comment.c_str());
+    }
+    dumpInstructions(p_out_file, "\n");
+}
@@ -0,0 +1,487 @@
+#include "codegen/PeepholeOptimizer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* ------------------------------------------------------------------------------------------------- */
+// - Registers
+
+static std::string trim(const std::string &s) {
+    const size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    const size_t end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+/// @return the ABI name of the register, or "" if `name` is not a register
+static std::string getRegName(const std::string &name) {
+    static const char *const kIntNames[] = {
+        "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "s0", "s1", "a0",
+        "a1",   "a2", "a3", "a4", "a5", "a6", "a7", "s2", "s3", "s4", "s5",
+        "s6",   "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+    static const char *const kFloatNames[] = {
+        "ft0", "ft1", "ft2",  "ft3",  "ft4", "ft5", "ft6", "ft7", "fs0", "fs1", "fa0",
+        "fa1", "fa2", "fa3",  "fa4",  "fa5", "fa6", "fa7", "fs2", "fs3", "fs4", "fs5",
+        "fs6", "fs7", "fs8",  "fs9",  "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"};
+
+    for (int i = 0; i < 32; ++i) {
+        if (name == kIntNames[i] || name == kFloatNames[i]) {
+            return name;
+        }
+    }
+    if (name == "fp") {
+        return "s0";
+    }
+    if (name.size() >= 2 && (name[0] == 'x' || name[0] == 'f') &&
+        std::all_of(name.begin() + 1, name.end(), ::isdigit)) {
+        const int index = atoi(name.c_str() + 1);
+        if (index < 32) {
+            return (name[0] == 'x') ? kIntNames[index] : kFloatNames[index];
+        }
+    }
+    return "";
+}
+
+static bool isFloatReg(const std::string &reg) {
+    return !reg.empty() && reg[0] == 'f';
+}
+
+/// @return the registers in an operand, e.g. "t0", "-12(s0)", "%lo(.LC1)(t0)"
+static std::vector<std::string> getRegsIn(const std::string &operand) {
+    if (!operand.empty() && operand.back() == ')') {
+        const size_t open = operand.rfind('(');
+        const std::string base = getRegName(operand.substr(open + 1, operand.size() - open - 2));
+        return base.empty() ? std::vector<std::string>{} : std::vector<std::string>{base};
+    }
+    const std::string reg = getRegName(operand);
+    return reg.empty() ? std::vector<std::string>{} : std::vector<std::string>{reg};
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+// - Effects of instructions
+
+static bool isStoreOp(const std::string &op) {
+    return op == "sb" || op == "sh" || op == "sw" || op == "sd" || op == "fsw" || op == "fsd";
+}
+
+static bool isBranchOp(const std::string &op) {
+    return op.size() >= 3 && op[0] == 'b' && op != "bset" && op != "bclr";
+}
+
+struct InstrEffects {
+    std::vector<std::string> defs;
+    std::vector<std::string> uses;
+    bool isCall = false;
+    bool isReturn = false;
+    /// ends the block: branch, jump, return
+    bool isControl = false;
+    bool isStore = false;
+};
+
+static InstrEffects getEffects(const std::string &op, const std::vector<std::string> &operands) {
+    InstrEffects effects;
+    auto useAll = [&](size_t from) {
+        for (size_t i = from; i < operands.size(); ++i) {
+            for (const std::string &reg : getRegsIn(operands[i])) {
+                effects.uses.push_back(reg);
+            }
+        }
+    };
+
+    const bool isCall = op == "call" || (op == "jal" && (operands.size() == 1 ||
+                                                         getRegName(operands[0]) == "ra"));
+    if (isCall) {
+        effects.isCall = true;
+    } else if (op == "ret" || (op == "jr" && operands.size() == 1 && getRegName(operands[0]) == "ra")) {
+        effects.isControl = effects.isReturn = true;
+        useAll(0);
+    } else if (op == "j" || op == "jal" || op == "jr" || op == "jalr" || op == "tail" ||
+               isBranchOp(op)) {
+        effects.isControl = true;
+        useAll(0);
+    } else if (isStoreOp(op)) {
+        effects.isStore = true;
+        useAll(0);
+    } else if (!operands.empty()) {
+        effects.defs = getRegsIn(operands[0]);
+        useAll(1);
+    }
+    return effects;
+}
+
+static bool contains(const std::vector<std::string> &regs, const std::string &reg) {
+    return std::find(regs.begin(), regs.end(), reg) != regs.end();
+}
+
+static bool isArgReg(const std::string &reg) {
+    return reg.size() == 2 && reg[0] == 'a';
+}
+
+static bool isFloatArgReg(const std::string &reg) {
+    return reg.size() == 3 && reg[0] == 'f' && reg[1] == 'a';
+}
+
+static bool isCallerSavedReg(const std::string &reg) {
+    return reg == "ra" || (reg[0] == 't' && reg != "tp") || reg.compare(0, 2, "ft") == 0 ||
+           isArgReg(reg) || isFloatArgReg(reg);
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+PeepholeOptimizer::PeepholeOptimizer() {
+    // clang-format off
+    m_rules = {
+        {"push-pop cancel", &PeepholeOptimizer::cancelPushPop, 0},
+        {"push-pop move", &PeepholeOptimizer::turnPushPopIntoMove, 0},
+        {"self move", &PeepholeOptimizer::removeSelfMove, 0},
+        {"move folding", &PeepholeOptimizer::foldMoveIntoProducer, 0},
+    };
+    // clang-format on
+}
+
+void PeepholeOptimizer::AsmLine::setInstr(const std::string &new_opcode,
+                                          std::vector<std::string> new_operands) {
+    opcode = new_opcode;
+    operands = std::move(new_operands);
+    text = "    " + opcode;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        text += (i == 0 ? " " : ", ") + operands[i];
+    }
+}
+
+PeepholeOptimizer::AsmLine PeepholeOptimizer::parseLine(const std::string &text) {
+    AsmLine line;
+    line.text = text;
+
+    std::string code = text;
+    // Strip the comment, but not a '#' inside a string literal.
+    bool inString = false;
+    for (size_t i = 0; i < code.size(); ++i) {
+        if (code[i] == '"' && (i == 0 || code[i - 1] != '\\')) {
+            inString = !inString;
+        } else if (code[i] == '#' && !inString) {
+            code.resize(i);
+            break;
+        }
+    }
+    code = trim(code);
+    if (code.empty()) {
+        return line;
+    }
+
+    if (code.back() == ':') {
+        line.kind = AsmLine::Kind::LABEL;
+        line.label = code.substr(0, code.size() - 1);
+        return line;
+    }
+    if (code[0] == '.') {
+        const bool isSection = code.compare(0, 8, ".section") == 0 || code == ".text" ||
+                               code == ".data" || code == ".bss" || code == ".rodata";
+        line.kind = isSection ? AsmLine::Kind::SECTION : AsmLine::Kind::DIRECTIVE;
+        return line;
+    }
+
+    line.kind = AsmLine::Kind::INSTR;
+    const size_t space = code.find_first_of(" \t");
+    line.opcode = code.substr(0, space);
+    if (space != std::string::npos) {
+        std::stringstream operands(code.substr(space));
+        std::string operand;
+        while (std::getline(operands, operand, ',')) {
+            line.operands.push_back(trim(operand));
+        }
+    }
+    return line;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+void PeepholeOptimizer::run(const std::string &asm_file_path) {
+    std::vector<AsmLine> lines;
+    {
+        std::ifstream in(asm_file_path);
+        if (!in) {
+            perror("peephole: cannot open the assembly file");
+            exit(1);
+        }
+        std::string text;
+        while (std::getline(in, text)) {
+            lines.push_back(parseLine(text));
+        }
+    }
+
+    // - Basic blocks of the .text section
+    // Lines of other sections (e.g. literals emitted in the middle of a function) are not
+    // part of any block and do not split one.
+
+    bool inText = false;
+    Block block;
+    for (AsmLine &line : lines) {
+        if (line.kind == AsmLine::Kind::SECTION) {
+            const std::string code = trim(line.text);
+            inText = code == ".text" || code.find(".text") != std::string::npos;
+            continue;
+        }
+        line.inText = inText;
+        if (!inText || line.kind == AsmLine::Kind::OTHER) {
+            continue;
+        }
+        if (line.kind != AsmLine::Kind::INSTR) {
+            optimizeBlock(block);
+            block.clear();
+            continue;
+        }
+        block.push_back(&line);
+        if (getEffects(line.opcode, line.operands).isControl) {
+            optimizeBlock(block);
+            block.clear();
+        }
+    }
+    optimizeBlock(block);
+
+    removeJumpsToNextLabel(lines);
+
+    FILE *out = fopen(asm_file_path.c_str(), "w");
+    if (out == nullptr) {
+        perror("peephole: cannot write the assembly file");
+        exit(1);
+    }
+    for (const AsmLine &line : lines) {
+        if (!line.deleted) {
+            fprintf(out, "%s\n", line.text.c_str());
+        }
+    }
+    fclose(out);
+}
+
+void PeepholeOptimizer::dumpCounters(FILE *p_out_file) const {
+    fprintf(p_out_file, "peephole:\n");
+    for (const Rule &rule : m_rules) {
+        fprintf(p_out_file, "    %-20s %d\n", rule.name, rule.count);
+    }
+    fprintf(p_out_file, "    %-20s %d\n", "jump to next label", m_jumps_to_next_label);
+}
+
+void PeepholeOptimizer::optimizeBlock(Block &block) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < block.size(); ++i) {
+            for (Rule &rule : m_rules) {
+                if (rule.apply(block, i)) {
+                    ++rule.count;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void PeepholeOptimizer::removeJumpsToNextLabel(std::vector<AsmLine> &lines) {
+    for (size_t i = 0; i < lines.size(); ++i) {
+        AsmLine &jump = lines[i];
+        if (jump.deleted || !jump.inText || jump.kind != AsmLine::Kind::INSTR ||
+            jump.opcode != "j" || jump.operands.size() != 1) {
+            continue;
+        }
+        for (size_t k = i + 1; k < lines.size(); ++k) {
+            const AsmLine &next = lines[k];
+            if (next.deleted || !next.inText || next.kind == AsmLine::Kind::OTHER ||
+                next.kind == AsmLine::Kind::SECTION) {
+                continue;
+            }
+            if (next.kind == AsmLine::Kind::LABEL) {
+                if (next.label == jump.operands[0]) {
+                    jump.deleted = true;
+                    ++m_jumps_to_next_label;
+                    break;
+                }
+                continue;
+            }
+            break;
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+// - Rules
+
+static bool isPush(const std::string &op, const std::vector<std::string> &operands) {
+    return op == "addi" && operands.size() == 3 && getRegName(operands[0]) == "sp" &&
+           getRegName(operands[1]) == "sp" && operands[2] == "-4";
+}
+
+static bool isPop(const std::string &op, const std::vector<std::string> &operands) {
+    return op == "addi" && operands.size() == 3 && getRegName(operands[0]) == "sp" &&
+           getRegName(operands[1]) == "sp" && operands[2] == "4";
+}
+
+/// @brief Whether the instruction is `op reg, 0(sp)`.
+static bool accessesTopOfStack(const std::vector<std::string> &operands) {
+    return operands.size() == 2 && !getRegName(operands[0]).empty() &&
+           (operands[1] == "0(sp)" || operands[1] == "0(x2)");
+}
+
+size_t PeepholeOptimizer::findMatchingPop(const Block &block, const size_t i) {
+    // addi sp, sp, -4
+    // sw X, 0(sp)
+    if (i + 1 >= block.size() || !isPush(block[i]->opcode, block[i]->operands)) {
+        return 0;
+    }
+    const AsmLine &store = *block[i + 1];
+    if (!(store.opcode == "sw" || store.opcode == "fsw") || !accessesTopOfStack(store.operands)) {
+        return 0;
+    }
+
+    for (size_t k = i + 2; k + 1 < block.size(); ++k) {
+        const AsmLine &line = *block[k];
+        // lw Y, 0(sp)
+        // addi sp, sp, 4
+        const bool isLoad = line.opcode == "lw" || line.opcode == "flw";
+        if (isLoad && accessesTopOfStack(line.operands) &&
+            isPop(block[k + 1]->opcode, block[k + 1]->operands)) {
+            // only the same register class can be moved
+            const bool sameClass = (store.opcode == "fsw") == (line.opcode == "flw");
+            return sameClass ? k : 0;
+        }
+
+        // In between, the slot must stay untouched and the value of the pop must not be needed.
+        const InstrEffects effects = getEffects(line.opcode, line.operands);
+        if (effects.isCall || effects.isControl || effects.isStore ||
+            contains(effects.uses, "sp") || contains(effects.defs, "sp")) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+bool PeepholeOptimizer::cancelPushPop(Block &block, const size_t i) {
+    const size_t k = findMatchingPop(block, i);
+    if (k == 0) {
+        return false;
+    }
+    const std::string pushed = getRegName(block[i + 1]->operands[0]);
+    const std::string popped = getRegName(block[k]->operands[0]);
+    if (pushed != popped) {
+        return false;
+    }
+    for (size_t j = i + 2; j < k; ++j) {
+        if (contains(getEffects(block[j]->opcode, block[j]->operands).defs, pushed)) {
+            return false;
+        }
+    }
+
+    for (size_t j : {k + 1, k, i + 1, i}) {
+        block[j]->deleted = true;
+        block.erase(block.begin() + j);
+    }
+    return true;
+}
+
+bool PeepholeOptimizer::turnPushPopIntoMove(Block &block, const size_t i) {
+    const size_t k = findMatchingPop(block, i);
+    if (k == 0) {
+        return false;
+    }
+    const std::string pushed = getRegName(block[i + 1]->operands[0]);
+    const std::string popped = getRegName(block[k]->operands[0]);
+    if (pushed == popped) {
+        return false;
+    }
+    // The move is done at the push, so the popped register must be untouched in between.
+    for (size_t j = i + 2; j < k; ++j) {
+        const InstrEffects effects = getEffects(block[j]->opcode, block[j]->operands);
+        if (contains(effects.uses, popped) || contains(effects.defs, popped)) {
+            return false;
+        }
+    }
+
+    block[i]->setInstr(isFloatReg(pushed) ? "fmv.s" : "mv", {popped, pushed});
+    for (size_t j : {k + 1, k, i + 1}) {
+        block[j]->deleted = true;
+        block.erase(block.begin() + j);
+    }
+    return true;
+}
+
+/// @return the source register if the instruction only copies a register, otherwise ""
+static std::string getMoveSource(const std::string &op, const std::vector<std::string> &operands) {
+    if ((op == "mv" || op == "fmv.s") && operands.size() == 2) {
+        return getRegName(operands[1]);
+    }
+    if (op == "fsgnj.s" && operands.size() == 3 && operands[1] == operands[2]) {
+        return getRegName(operands[1]);
+    }
+    return "";
+}
+
+bool PeepholeOptimizer::removeSelfMove(Block &block, const size_t i) {
+    const std::string source = getMoveSource(block[i]->opcode, block[i]->operands);
+    if (source.empty() || source != getRegName(block[i]->operands[0])) {
+        return false;
+    }
+    block[i]->deleted = true;
+    block.erase(block.begin() + i);
+    return true;
+}
+
+bool PeepholeOptimizer::isDeadAfter(const Block &block, const size_t i, const std::string &reg) {
+    for (size_t j = i + 1; j < block.size(); ++j) {
+        const InstrEffects effects = getEffects(block[j]->opcode, block[j]->operands);
+        if (effects.isCall) {
+            // A call reads the argument registers and clobbers the other caller-saved ones.
+            if (isArgReg(reg) || isFloatArgReg(reg)) {
+                return false;
+            }
+            return isCallerSavedReg(reg);
+        }
+        if (contains(effects.uses, reg)) {
+            return false;
+        }
+        if (contains(effects.defs, reg)) {
+            return true;
+        }
+        if (effects.isReturn) {
+            // only the return value is read by the caller
+            return isCallerSavedReg(reg) && reg != "ra" && reg != "a0" && reg != "fa0";
+        }
+    }
+    // live out of the block, as far as we know
+    return false;
+}
+
+bool PeepholeOptimizer::foldMoveIntoProducer(Block &block, const size_t i) {
+    if (i == 0) {
+        return false;
+    }
+    const std::string source = getMoveSource(block[i]->opcode, block[i]->operands);
+    const std::string dest = getRegName(block[i]->operands.empty() ? "" : block[i]->operands[0]);
+    if (source.empty() || dest.empty() || source == dest || isFloatReg(source) != isFloatReg(dest)) {
+        return false;
+    }
+
+    AsmLine &producer = *block[i - 1];
+    const InstrEffects effects = getEffects(producer.opcode, producer.operands);
+    if (effects.isCall || effects.isControl || effects.isStore || effects.defs.size() != 1 ||
+        effects.defs[0] != source || source == "sp" || source == "zero" ||
+        !isDeadAfter(block, i, source)) {
+        return false;
+    }
+
+    std::vector<std::string> operands = producer.operands;
+    operands[0] = dest;
+    producer.setInstr(producer.opcode, std::move(operands));
+    block[i]->deleted = true;
+    block.erase(block.begin() + i);
+    return true;
+}
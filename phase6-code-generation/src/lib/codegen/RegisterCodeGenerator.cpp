@@ -0,0 +1,113 @@
+#include "codegen/RegisterCodeGenerator.hpp"
+
+#include "AST/ConstantValue.hpp"
+#include "codegen/CodeGenerator.hpp"
+#include "codegen/InstructionSelector.hpp"
+#include "codegen/LinearScanAllocator.hpp"
+#include "codegen/MachineCode.hpp"
+#include "ir/IR.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+
+RegisterCodeGenerator::RegisterCodeGenerator(const std::string &source_file_name,
+                                             const std::string &save_path,
+                                             const IrModule &p_module,
+                                             const CompilerOptions &p_options)
+    : m_module(p_module), m_options(p_options), m_source_file_path(source_file_name) {
+    m_output_file.reset(openAssemblyFile(source_file_name, save_path));
+}
+
+static void dumpInstructions(FILE *p_out_file, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(p_out_file, format, args);
+    va_end(args);
+}
+
+/// @return the directive (.word/.float/.string) and its operand that hold the constant
+static std::pair<const char *, std::string> getDataOf(const IrValue &value) {
+    switch (value.kind) {
+        case IrValue::Kind::INT:
+            return {"word", std::to_string(value.intVal)};
+        case IrValue::Kind::FLOAT: {
+            ConstVal constVal;
+            constVal.scalarType = ScalarType::REAL;
+            constVal.valContainer.real = value.floatVal;
+            return {"float", getImmediateInString(constVal)};
+        }
+        default: {
+            ConstVal constVal;
+            constVal.scalarType = ScalarType::STRING;
+            constVal.valContainer.string = value.strVal;
+            return {"string", getImmediateInString(constVal)};
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+void RegisterCodeGenerator::generate() {
+    // clang-format off
+    constexpr const char *const riscv_assembly_file_prologue =
+        "    .file \"%s\"\n"
+        "    .option nopic\n";
+    // clang-format on
+    dumpInstructions(m_output_file.get(), riscv_assembly_file_prologue, m_source_file_path.c_str());
+
+    for (const IrGlobal &global : m_module.globals) {
+        generateGlobal(global);
+    }
+    for (const auto &function : m_module.functions) {
+        generateFunction(*function);
+    }
+    m_constant_pool.dump(m_output_file.get());
+}
+
+void RegisterCodeGenerator::generateGlobal(const IrGlobal &global) {
+    const char *name = global.name.c_str();
+
+    // global var
+    if (global.init.isNone()) {
+        // clang-format off
+        constexpr const char *const riscv_assembly_global_var =
+            "    .comm %s, %d, 4            # emit object '%s' to .bss section with size = %d, align = 4\n";
+        // clang-format on
+        dumpInstructions(m_output_file.get(), riscv_assembly_global_var, name, global.size, name,
+                         global.size);
+        return;
+    }
+
+    // global const
+    std::pair<const char *, std::string> data = getDataOf(global.init);
+    if (global.init.kind == IrValue::Kind::STRING) {
+        // the address of the string, in the constant pool
+        data = {"word", m_constant_pool.getLabelOf(global.init)};
+    }
+    // clang-format off
+    constexpr const char *const riscv_assembly_global_const =
+        "    .section    .rodata       # emit rodata section\n"
+        "    .align 2\n"
+        "    .globl %s              # emit symbol '%s' to the global symbol table\n"
+        "    .type %s, @object\n"
+        "%s:\n"
+        "    .%s %s\n";
+    // clang-format on
+    dumpInstructions(m_output_file.get(), riscv_assembly_global_const, name, name, name, name,
+                     data.first, data.second.c_str());
+}
+
+void RegisterCodeGenerator::generateFunction(const IrFunction &function) {
+    std::unique_ptr<MachineFunction> machineFunction =
+        InstructionSelector(function, m_next_label, m_constant_pool, m_options.tailCalls,
+                            m_options.strengthReduction)
+            .run();
+    if (m_options.omitFramePointer) {
+        machineFunction->omitFramePointerIfLeaf();
+    }
+    LinearScanAllocator(*machineFunction).run();
+    machineFunction->dump(m_output_file.get());
+}
@@ -0,0 +1,257 @@
+#include "codegen/StrengthReduction.hpp"
+
+#include "codegen/MachineCode.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace {
+
+bool fitsInImm12(const int64_t value) {
+    return -2048 <= value && value <= 2047;
+}
+
+int getCostOfLi(const int32_t value) {
+    return fitsInImm12(value) ? kCostOfAluOp : 2 * kCostOfAluOp;  // lui + addi
+}
+
+class SequenceBuilder {
+   public:
+    ReducedSequence sequence;
+
+    int newScratch() {
+        return ++sequence.numScratchRegs;
+    }
+    int r(const char *op, const int rd, const int rs1, const int rs2) {
+        ArithStep step{MachineFormat::R, op, rd};
+        step.rs1 = rs1;
+        step.rs2 = rs2;
+        add(step, (op[0] == 'm') ? kCostOfMul : kCostOfAluOp);
+        return rd;
+    }
+    int i(const char *op, const int rd, const int rs1, const int32_t imm) {
+        ArithStep step{MachineFormat::I, op, rd};
+        step.rs1 = rs1;
+        step.imm = imm;
+        add(step, kCostOfAluOp);
+        return rd;
+    }
+    int li(const int rd, const int32_t imm) {
+        ArithStep step{MachineFormat::LI, "li", rd};
+        step.imm = imm;
+        add(step, getCostOfLi(imm));
+        return rd;
+    }
+
+   private:
+    void add(const ArithStep &step, const int cost) {
+        sequence.steps.push_back(step);
+        sequence.cost += cost;
+    }
+};
+
+/// @return the non-zero digits (shift, +1/-1) of `c` in non-adjacent form, modulo 2^32
+std::vector<std::pair<int, int>> getSignedDigits(const uint32_t c) {
+    std::vector<std::pair<int, int>> digits;
+    uint64_t n = c;
+    for (int shift = 0; n != 0 && shift < 32; ++shift, n >>= 1) {
+        if (n & 1) {
+            const int digit = ((n & 3) == 1) ? 1 : -1;
+            n = (digit == 1) ? n - 1 : n + 1;
+            digits.emplace_back(shift, digit);
+        }
+    }
+    return digits;
+}
+
+/// @return the register holding `src * c`
+int multiply(SequenceBuilder &b, const int src, const int32_t c) {
+    const std::vector<std::pair<int, int>> digits = getSignedDigits(c);
+    if (digits.empty()) {
+        return b.li(b.newScratch(), 0);
+    }
+    auto shifted = [&](const int shift) {
+        return (shift == 0) ? src : b.i("slli", b.newScratch(), src, shift);
+    };
+
+    // Start from a positive term, so that only a negative c needs a negation.
+    size_t first = 0;
+    while (first < digits.size() && digits[first].second < 0) {
+        ++first;
+    }
+    int acc;
+    if (first == digits.size()) {
+        first = 0;
+        acc = b.r("sub", b.newScratch(), kSeqZero, shifted(digits[0].first));
+    } else {
+        acc = shifted(digits[first].first);
+    }
+    for (size_t i = 0; i < digits.size(); ++i) {
+        if (i == first) {
+            continue;
+        }
+        const int term = shifted(digits[i].first);
+        const int sum = (acc == src) ? b.newScratch() : acc;
+        acc = b.r(digits[i].second > 0 ? "add" : "sub", sum, acc, term);
+    }
+    if (acc == src) {
+        acc = b.i("addi", b.newScratch(), src, 0);
+    }
+    return acc;
+}
+
+/// @return the register holding x + (2^k - 1 if x < 0, else 0), for rounding x / 2^k toward zero
+int addRoundingBias(SequenceBuilder &b, const int k) {
+    const int bias = b.newScratch();
+    if (k == 1) {
+        b.i("srli", bias, kSeqOperand, 31);
+    } else {
+        b.i("srai", bias, kSeqOperand, 31);
+        b.i("srli", bias, bias, 32 - k);
+    }
+    return b.r("add", bias, kSeqOperand, bias);
+}
+
+/// @return the number of trailing zeros of |c| if it is a power of two (2 ~ 2^31), else 0
+int getLog2OfAbs(const int32_t c) {
+    const uint32_t magnitude = (c < 0) ? 0u - static_cast<uint32_t>(c) : c;
+    if (magnitude < 2 || (magnitude & (magnitude - 1)) != 0) {
+        return 0;
+    }
+    int k = 0;
+    while ((magnitude >> k) != 1) {
+        ++k;
+    }
+    return k;
+}
+
+/// @brief The magic number and shift for dividing by `d` (Hacker's Delight, 10-1).
+/// @pre |d| >= 2 and d is not a power of two
+std::pair<int32_t, int> getMagicOf(const int32_t d) {
+    const uint32_t two31 = 0x80000000u;
+    const uint32_t ad = (d < 0) ? 0u - static_cast<uint32_t>(d) : d;
+    const uint32_t t = two31 + (static_cast<uint32_t>(d) >> 31);
+    const uint32_t anc = t - 1 - t % ad;
+    int p = 31;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;
+    uint32_t delta;
+    do {
+        ++p;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            ++q1;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            ++q2;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    int32_t magic = static_cast<int32_t>(q2 + 1);
+    if (d < 0) {
+        magic = static_cast<int32_t>(0u - static_cast<uint32_t>(magic));
+    }
+    return {magic, p - 32};
+}
+
+/// @return the register holding x / d, rounded toward zero
+/// @pre d is not 0, 1 or -1
+int divide(SequenceBuilder &b, const int32_t d) {
+    const int k = getLog2OfAbs(d);
+    if (k > 0) {
+        const int q = addRoundingBias(b, k);
+        b.i("srai", q, q, k);
+        return (d < 0) ? b.r("sub", q, kSeqZero, q) : q;
+    }
+
+    const std::pair<int32_t, int> magic = getMagicOf(d);
+    const int q = b.newScratch();
+    b.li(q, magic.first);
+    b.r("mulh", q, kSeqOperand, q);
+    if (d > 0 && magic.first < 0) {
+        b.r("add", q, q, kSeqOperand);
+    } else if (d < 0 && magic.first > 0) {
+        b.r("sub", q, q, kSeqOperand);
+    }
+    if (magic.second > 0) {
+        b.i("srai", q, q, magic.second);
+    }
+    // + 1 if the quotient is negative
+    const int sign = b.i("srli", b.newScratch(), q, 31);
+    return b.r("add", q, q, sign);
+}
+
+/// @return the register holding x % d, with the sign of x
+/// @pre d is not 0, 1 or -1
+int remainder(SequenceBuilder &b, const int32_t d) {
+    const int k = getLog2OfAbs(d);
+    if (k > 0) {
+        // x - ((x + bias) & -2^k)
+        const int rounded = addRoundingBias(b, k);
+        const int32_t mask = static_cast<int32_t>(~((1u << k) - 1));
+        if (fitsInImm12(mask)) {
+            b.i("andi", rounded, rounded, mask);
+        } else {
+            b.r("and", rounded, rounded, b.li(b.newScratch(), mask));
+        }
+        return b.r("sub", rounded, kSeqOperand, rounded);
+    }
+
+    const int q = divide(b, d);
+    // q * d, by whichever of a reduced sequence and `mul` is cheaper
+    SequenceBuilder product;
+    multiply(product, kSeqOperand, d);
+    int qd;
+    if (product.sequence.cost < getCostOfLi(d) + kCostOfMul) {
+        qd = multiply(b, q, d);
+    } else {
+        qd = b.r("mul", b.newScratch(), q, b.li(b.newScratch(), d));
+    }
+    return b.r("sub", qd, kSeqOperand, qd);
+}
+
+}  // namespace
+
+ReducedSequence reduceByConstant(const ArithOp op, const int32_t c) {
+    SequenceBuilder b;
+    int result;
+    switch (op) {
+        case ArithOp::MUL:
+            result = multiply(b, kSeqOperand, c);
+            break;
+        case ArithOp::DIV:
+            if (c == 0) {
+                return {};  // left to run time
+            }
+            if (c == 1) {
+                result = b.i("addi", b.newScratch(), kSeqOperand, 0);
+            } else if (c == -1) {
+                result = b.r("sub", b.newScratch(), kSeqZero, kSeqOperand);
+            } else {
+                result = divide(b, c);
+            }
+            break;
+        case ArithOp::REM:
+            if (c == 0) {
+                return {};
+            }
+            result = (c == 1 || c == -1) ? b.li(b.newScratch(), 0) : remainder(b, c);
+            break;
+        default:
+            return {};
+    }
+    (void)result;  // always computed by the last step
+
+    const int costOfInstr = getCostOfLi(c) + (op == ArithOp::MUL ? kCostOfMul : kCostOfDiv);
+    if (b.sequence.cost >= costOfInstr) {
+        return {};
+    }
+    return b.sequence;
+}
@@ -0,0 +1,154 @@
+#include "codegen/TreePatterns.hpp"
+
+#include "codegen/MachineCode.hpp"
+#include "codegen/StrengthReduction.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+using K = OperandKind;
+using F = MachineFormat;
+
+constexpr int kAlu = kCostOfAluOp;
+
+PatternStep r(const char *op, const int rs1, const int rs2) {
+    return {F::R, op, rs1, rs2};
+}
+PatternStep i(const char *op, const int rs1, const int32_t imm = kPatConstant) {
+    return {F::I, op, rs1, kSeqZero, imm};
+}
+
+// x < c is slti; a comparison the other way around is its negation (xori 1), or compares with
+// c + 1 instead (x <= c is x < c + 1).
+const std::vector<PatternRule> kRules = {
+    {PatternOp::ADD, K::REG, K::REG, ImmOf::C, kAlu, {r("add", kPatLeft, kPatRight)}},
+    {PatternOp::ADD, K::REG, K::IMM, ImmOf::C, kAlu, {i("addi", kPatLeft)}},
+    {PatternOp::ADD, K::IMM, K::REG, ImmOf::C, kAlu, {i("addi", kPatRight)}},
+
+    {PatternOp::SUB, K::REG, K::REG, ImmOf::C, kAlu, {r("sub", kPatLeft, kPatRight)}},
+    {PatternOp::SUB, K::REG, K::IMM, ImmOf::MINUS_C, kAlu, {i("addi", kPatLeft)}},
+
+    {PatternOp::MUL, K::REG, K::REG, ImmOf::C, kCostOfMul, {r("mul", kPatLeft, kPatRight)}},
+    {PatternOp::DIV, K::REG, K::REG, ImmOf::C, kCostOfDiv, {r("div", kPatLeft, kPatRight)}},
+    {PatternOp::REM, K::REG, K::REG, ImmOf::C, kCostOfDiv, {r("rem", kPatLeft, kPatRight)}},
+
+    {PatternOp::LT, K::REG, K::REG, ImmOf::C, kAlu, {r("slt", kPatLeft, kPatRight)}},
+    {PatternOp::LT, K::REG, K::IMM, ImmOf::C, kAlu, {i("slti", kPatLeft)}},
+    {PatternOp::LT, K::IMM, K::REG, ImmOf::C_PLUS_1, 2 * kAlu,
+     {i("slti", kPatRight), i("xori", kPatResult, 1)}},
+
+    {PatternOp::GT, K::REG, K::REG, ImmOf::C, kAlu, {r("slt", kPatRight, kPatLeft)}},
+    {PatternOp::GT, K::REG, K::IMM, ImmOf::C_PLUS_1, 2 * kAlu,
+     {i("slti", kPatLeft), i("xori", kPatResult, 1)}},
+    {PatternOp::GT, K::IMM, K::REG, ImmOf::C, kAlu, {i("slti", kPatRight)}},
+
+    {PatternOp::LE, K::REG, K::REG, ImmOf::C, 2 * kAlu,
+     {r("slt", kPatRight, kPatLeft), i("xori", kPatResult, 1)}},
+    {PatternOp::LE, K::REG, K::IMM, ImmOf::C_PLUS_1, kAlu, {i("slti", kPatLeft)}},
+    {PatternOp::LE, K::IMM, K::REG, ImmOf::C, 2 * kAlu,
+     {i("slti", kPatRight), i("xori", kPatResult, 1)}},
+
+    {PatternOp::GE, K::REG, K::REG, ImmOf::C, 2 * kAlu,
+     {r("slt", kPatLeft, kPatRight), i("xori", kPatResult, 1)}},
+    {PatternOp::GE, K::REG, K::IMM, ImmOf::C, 2 * kAlu,
+     {i("slti", kPatLeft), i("xori", kPatResult, 1)}},
+    {PatternOp::GE, K::IMM, K::REG, ImmOf::C_PLUS_1, kAlu, {i("slti", kPatRight)}},
+
+    {PatternOp::EQ, K::REG, K::REG, ImmOf::C, 2 * kAlu,
+     {r("xor", kPatLeft, kPatRight), i("sltiu", kPatResult, 1)}},
+    {PatternOp::EQ, K::REG, K::IMM, ImmOf::C, 2 * kAlu,
+     {i("xori", kPatLeft), i("sltiu", kPatResult, 1)}},
+    {PatternOp::EQ, K::IMM, K::REG, ImmOf::C, 2 * kAlu,
+     {i("xori", kPatRight), i("sltiu", kPatResult, 1)}},
+    {PatternOp::EQ, K::REG, K::ZERO, ImmOf::C, kAlu, {i("sltiu", kPatLeft, 1)}},
+    {PatternOp::EQ, K::ZERO, K::REG, ImmOf::C, kAlu, {i("sltiu", kPatRight, 1)}},
+
+    {PatternOp::NE, K::REG, K::REG, ImmOf::C, 2 * kAlu,
+     {r("xor", kPatLeft, kPatRight), r("sltu", kSeqZero, kPatResult)}},
+    {PatternOp::NE, K::REG, K::IMM, ImmOf::C, 2 * kAlu,
+     {i("xori", kPatLeft), r("sltu", kSeqZero, kPatResult)}},
+    {PatternOp::NE, K::IMM, K::REG, ImmOf::C, 2 * kAlu,
+     {i("xori", kPatRight), r("sltu", kSeqZero, kPatResult)}},
+    {PatternOp::NE, K::REG, K::ZERO, ImmOf::C, kAlu, {r("sltu", kSeqZero, kPatLeft)}},
+    {PatternOp::NE, K::ZERO, K::REG, ImmOf::C, kAlu, {r("sltu", kSeqZero, kPatRight)}},
+
+    // (booleans, 0 or 1)
+    {PatternOp::AND, K::REG, K::REG, ImmOf::C, kAlu, {r("and", kPatLeft, kPatRight)}},
+    {PatternOp::AND, K::REG, K::IMM, ImmOf::C, kAlu, {i("andi", kPatLeft)}},
+    {PatternOp::AND, K::IMM, K::REG, ImmOf::C, kAlu, {i("andi", kPatRight)}},
+    {PatternOp::OR, K::REG, K::REG, ImmOf::C, kAlu, {r("or", kPatLeft, kPatRight)}},
+    {PatternOp::OR, K::REG, K::IMM, ImmOf::C, kAlu, {i("ori", kPatLeft)}},
+    {PatternOp::OR, K::IMM, K::REG, ImmOf::C, kAlu, {i("ori", kPatRight)}},
+};
+
+bool fitsInImm12(const int64_t value) {
+    return -2048 <= value && value <= 2047;
+}
+
+int getCostOfLi(const int32_t value) {
+    return fitsInImm12(value) ? kCostOfAluOp : 2 * kCostOfAluOp;  // lui + addi
+}
+
+/// @return the cost of matching `operand` as `kind`, or -1 if it does not match
+int getCostOfMatch(const OperandKind kind, const PatternOperand &operand) {
+    switch (kind) {
+        case OperandKind::REG:
+            if (!operand.isConstant || isInZeroReg(operand)) {
+                return 0;
+            }
+            return getCostOfLi(operand.value);
+        case OperandKind::ZERO:
+            return isInZeroReg(operand) ? 0 : -1;
+        default:
+            return operand.isConstant ? 0 : -1;
+    }
+}
+
+/// @return whether the immediate of `rule` for the constant `c` fits, with it in `imm`
+bool getImmediate(const PatternRule &rule, const int32_t c, int32_t &imm) {
+    int64_t value = c;
+    if (rule.immOf == ImmOf::C_PLUS_1) {
+        value = static_cast<int64_t>(c) + 1;
+    } else if (rule.immOf == ImmOf::MINUS_C) {
+        value = -static_cast<int64_t>(c);
+    }
+    imm = static_cast<int32_t>(value);
+    return fitsInImm12(value);
+}
+
+}  // namespace
+
+PatternCover coverBinary(const PatternOp op, const PatternOperand &left,
+                         const PatternOperand &right) {
+    PatternCover best;
+    for (const PatternRule &rule : kRules) {
+        if (rule.op != op) {
+            continue;
+        }
+        const int leftCost = getCostOfMatch(rule.left, left);
+        const int rightCost = getCostOfMatch(rule.right, right);
+        if (leftCost < 0 || rightCost < 0) {
+            continue;
+        }
+        int32_t imm = 0;
+        if (rule.left == OperandKind::IMM && !getImmediate(rule, left.value, imm)) {
+            continue;
+        }
+        if (rule.right == OperandKind::IMM && !getImmediate(rule, right.value, imm)) {
+            continue;
+        }
+        const int cost = rule.cost + leftCost + rightCost;
+        if (best.rule == nullptr || cost < best.cost) {
+            best = {&rule, imm, cost};
+        }
+    }
+    if (best.rule == nullptr) {
+        printf("Unknown bin op\n");
+        exit(1);
+    }
+    return best;
+}
@@ -0,0 +1,121 @@
+#include "ir/Dominators.hpp"
+
+#include "ir/IR.hpp"
+
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+DominatorTree::DominatorTree(const IrFunction &function) {
+    // - Reverse postorder, by an iterative depth-first search
+
+    std::vector<IrBasicBlock *> postorder;
+    std::unordered_set<const IrBasicBlock *> visited;
+    std::vector<std::pair<IrBasicBlock *, size_t>> stack;
+    IrBasicBlock *entry = function.getBlocks().front().get();
+    visited.insert(entry);
+    stack.emplace_back(entry, 0);
+    while (!stack.empty()) {
+        IrBasicBlock *block = stack.back().first;
+        const size_t next = stack.back().second++;
+        if (next < block->succs.size()) {
+            IrBasicBlock *succ = block->succs[next];
+            if (visited.insert(succ).second) {
+                stack.emplace_back(succ, 0);
+            }
+            continue;
+        }
+        postorder.push_back(block);
+        stack.pop_back();
+    }
+    m_rpo.assign(postorder.rbegin(), postorder.rend());
+    for (size_t i = 0; i < m_rpo.size(); ++i) {
+        m_rpo_index[m_rpo[i]] = i;
+    }
+
+    // - Immediate dominators, until nothing changes
+
+    constexpr int kUndefined = -1;
+    m_idom.assign(m_rpo.size(), kUndefined);
+    m_idom[0] = 0;
+    const auto intersect = [this](int a, int b) {
+        while (a != b) {
+            while (a > b) {
+                a = m_idom[a];
+            }
+            while (b > a) {
+                b = m_idom[b];
+            }
+        }
+        return a;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < m_rpo.size(); ++i) {
+            int newIdom = kUndefined;
+            for (const IrBasicBlock *pred : m_rpo[i]->preds) {
+                auto it = m_rpo_index.find(pred);
+                if (it == m_rpo_index.end() || m_idom[it->second] == kUndefined) {
+                    continue;  // unreachable, or not processed yet
+                }
+                newIdom = (newIdom == kUndefined) ? it->second : intersect(it->second, newIdom);
+            }
+            if (m_idom[i] != newIdom) {
+                m_idom[i] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    // - Children and dominance frontiers
+
+    m_children.assign(m_rpo.size(), {});
+    m_frontiers.assign(m_rpo.size(), {});
+    for (size_t i = 1; i < m_rpo.size(); ++i) {
+        m_children[m_idom[i]].push_back(m_rpo[i]);
+    }
+    for (size_t i = 0; i < m_rpo.size(); ++i) {
+        // Each predecessor up to (not including) the immediate dominator of a join has it in
+        // its frontier.
+        std::unordered_set<const IrBasicBlock *> preds(m_rpo[i]->preds.begin(),
+                                                       m_rpo[i]->preds.end());
+        if (preds.size() < 2) {
+            continue;
+        }
+        for (const IrBasicBlock *pred : preds) {
+            auto it = m_rpo_index.find(pred);
+            if (it == m_rpo_index.end()) {
+                continue;
+            }
+            for (int runner = it->second; runner != m_idom[i]; runner = m_idom[runner]) {
+                std::vector<IrBasicBlock *> &frontier = m_frontiers[runner];
+                if (frontier.empty() || frontier.back() != m_rpo[i]) {
+                    frontier.push_back(m_rpo[i]);
+                }
+                if (runner == 0) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+IrBasicBlock *DominatorTree::getIdom(const IrBasicBlock *block) const {
+    const int index = m_rpo_index.at(block);
+    return (index == 0) ? nullptr : m_rpo[m_idom[index]];
+}
+
+bool DominatorTree::dominates(const IrBasicBlock *a, const IrBasicBlock *b) const {
+    auto itA = m_rpo_index.find(a);
+    auto itB = m_rpo_index.find(b);
+    if (itA == m_rpo_index.end() || itB == m_rpo_index.end()) {
+        return false;
+    }
+    // Walk up from b; a dominator always comes earlier in reverse postorder.
+    int index = itB->second;
+    while (index > itA->second) {
+        index = m_idom[index];
+    }
+    return index == itA->second;
+}
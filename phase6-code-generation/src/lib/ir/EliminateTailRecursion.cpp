@@ -0,0 +1,65 @@
+#include "ir/IR.hpp"
+#include "ir/IrPasses.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/// @return whether the block ends with `%r = call <function>(..); ret %r` (or a void one)
+static bool endsWithSelfTailCall(const IrBasicBlock &block, const IrFunction &function) {
+    const auto &instrs = block.instrs;
+    if (instrs.size() < 2) {
+        return false;
+    }
+    const IrInstr &call = instrs[instrs.size() - 2];
+    const IrInstr &ret = instrs.back();
+    if (call.op != IrOp::CALL || call.callee != function.getName() || ret.op != IrOp::RET) {
+        return false;
+    }
+    return ret.operands.empty() ? call.dst.isNone() : ret.operands[0].isSameAs(call.dst);
+}
+
+void eliminateTailRecursion(IrFunction &function) {
+    // An array of the frame passed on would be the same array in the next iteration.
+    if (function.takesAddressOfSlot()) {
+        return;
+    }
+    std::vector<IrBasicBlock *> tailCalls;
+    for (auto &block : function.getBlocks()) {
+        if (endsWithSelfTailCall(*block, function)) {
+            tailCalls.push_back(block.get());
+        }
+    }
+    if (tailCalls.empty()) {
+        return;
+    }
+
+    // The old entry block becomes the head of the loop; a new one just enters it.
+    auto &blocks = function.getBlocks();
+    IrBasicBlock *loopHead = blocks.front().get();
+    function.newBlock()->instrs.push_back(IrInstr::makeBr(loopHead));
+    std::rotate(blocks.begin(), blocks.end() - 1, blocks.end());
+
+    const std::vector<IrValue> &params = function.getParams();
+    for (IrBasicBlock *block : tailCalls) {
+        auto &instrs = block->instrs;
+        const IrInstr call = std::move(instrs[instrs.size() - 2]);
+        instrs.resize(instrs.size() - 2);
+
+        // Every argument is taken before any parameter is assigned, e.g. f(b, a) in f(a, b).
+        std::vector<IrValue> args;
+        for (const IrValue &arg : call.operands) {
+            if (arg.isTemp()) {
+                args.push_back(function.newTemp(arg.type));
+                instrs.push_back(IrInstr::makeUnary(IrOp::COPY, args.back(), arg));
+            } else {
+                args.push_back(arg);
+            }
+        }
+        for (size_t i = 0; i < params.size(); ++i) {
+            instrs.push_back(IrInstr::makeUnary(IrOp::COPY, params[i], args[i]));
+        }
+        instrs.push_back(IrInstr::makeBr(loopHead));
+    }
+    function.rebuildCfg();
+}
@@ -0,0 +1,256 @@
+#include "ir/Dominators.hpp"
+#include "ir/IR.hpp"
+#include "ir/IrPasses.hpp"
+#include "ir/Loops.hpp"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+class LoopInvariantHoister {
+   public:
+    LoopInvariantHoister(IrFunction &p_function, const std::unordered_set<std::string> &p_pure)
+        : m_function(p_function), m_pure(p_pure) {}
+
+    void run(IrBasicBlock *header);
+
+   private:
+    IrFunction &m_function;
+    const std::unordered_set<std::string> &m_pure;
+
+    // - The loop being processed
+
+    BlockSet m_body;
+    std::vector<int> m_defs_in_loop;
+    std::unordered_set<std::string> m_stored_globals;
+    std::unordered_set<int> m_stored_slots;
+    /// whether the loop may write memory it does not name: an impure call or a store through a
+    /// pointer
+    bool m_writes_any_memory = false;
+    std::vector<IrBasicBlock *> m_exiting_blocks;
+
+    bool isInvariant(const IrValue &value) const {
+        return !value.isTemp() || m_defs_in_loop[value.temp] == 0;
+    }
+    bool readsInvariantMemory(const IrInstr &instr) const;
+    bool canHoist(const IrInstr &instr, const IrBasicBlock *block, const DominatorTree &dom,
+                  const std::vector<int> &defs, const std::vector<bool> &usesDominated) const;
+};
+
+bool LoopInvariantHoister::readsInvariantMemory(const IrInstr &instr) const {
+    if (m_writes_any_memory) {
+        return false;
+    }
+    switch (instr.address.kind) {
+        case IrAddress::Kind::GLOBAL:
+            return !m_stored_globals.count(instr.address.global);
+        case IrAddress::Kind::SLOT:
+            return !m_stored_slots.count(instr.address.slot);
+        default:
+            return false;  // a pointer may point anywhere
+    }
+}
+
+bool LoopInvariantHoister::canHoist(const IrInstr &instr, const IrBasicBlock *block,
+                                    const DominatorTree &dom, const std::vector<int> &defs,
+                                    const std::vector<bool> &usesDominated) const {
+    // The destination must not be assigned anywhere else, nor read where this assignment
+    // might not have happened yet (e.g. after the loop, when it ran zero times).
+    if (!instr.dst.isTemp() || defs[instr.dst.temp] != 1 || !usesDominated[instr.dst.temp]) {
+        return false;
+    }
+    const auto &params = m_function.getParams();
+    if (std::any_of(params.begin(), params.end(),
+                    [&instr](const IrValue &param) { return param.isSameAs(instr.dst); })) {
+        return false;
+    }
+    if (!std::all_of(instr.operands.begin(), instr.operands.end(),
+                     [this](const IrValue &operand) { return isInvariant(operand); })) {
+        return false;
+    }
+
+    switch (instr.op) {
+        case IrOp::LOAD:
+            return readsInvariantMemory(instr);
+        case IrOp::CALL: {
+            // A pure call reads any global, and is only hoisted if it runs on every way out of
+            // the loop anyway, so that it is never run when it would not have been.
+            if (!m_pure.count(instr.callee) || m_writes_any_memory || !m_stored_globals.empty()) {
+                return false;
+            }
+            return std::all_of(
+                m_exiting_blocks.begin(), m_exiting_blocks.end(),
+                [&](const IrBasicBlock *exiting) { return dom.dominates(block, exiting); });
+        }
+        default:
+            // Nothing else traps: division by zero has a result on RISC-V.
+            return instr.isPure();
+    }
+}
+
+void LoopInvariantHoister::run(IrBasicBlock *header) {
+    m_function.rebuildCfg();
+    {
+        const DominatorTree dom(m_function);
+        m_body = getLoopOf(header, dom);
+    }
+    IrBasicBlock *preheader = getPreheaderOf(m_function, header, m_body);
+    const DominatorTree dom(m_function);
+
+    // - What the loop writes
+
+    m_defs_in_loop.assign(m_function.getNumTemps(), 0);
+    m_stored_globals.clear();
+    m_stored_slots.clear();
+    m_writes_any_memory = false;
+    m_exiting_blocks.clear();
+    for (IrBasicBlock *block : m_body) {
+        for (const IrInstr &instr : block->instrs) {
+            if (instr.dst.isTemp()) {
+                ++m_defs_in_loop[instr.dst.temp];
+            }
+            if (instr.op == IrOp::STORE) {
+                if (instr.address.kind == IrAddress::Kind::GLOBAL) {
+                    m_stored_globals.insert(instr.address.global);
+                } else if (instr.address.kind == IrAddress::Kind::SLOT) {
+                    m_stored_slots.insert(instr.address.slot);
+                } else {
+                    m_writes_any_memory = true;
+                }
+            } else if (instr.op == IrOp::CALL && !m_pure.count(instr.callee)) {
+                m_writes_any_memory = true;
+            }
+        }
+        if (std::any_of(block->succs.begin(), block->succs.end(),
+                        [this](IrBasicBlock *succ) { return !m_body.count(succ); })) {
+            m_exiting_blocks.push_back(block);
+        }
+    }
+
+    // - Whether every use of each temporary comes after its (only) definition
+
+    const std::vector<int> defs = countDefsOfTemps(m_function);
+    std::map<int, std::pair<const IrBasicBlock *, size_t>> defOf;
+    for (const auto &block : m_function.getBlocks()) {
+        for (size_t i = 0; i < block->instrs.size(); ++i) {
+            const IrValue &dst = block->instrs[i].dst;
+            if (dst.isTemp() && defs[dst.temp] == 1) {
+                defOf[dst.temp] = {block.get(), i};
+            }
+        }
+    }
+    std::vector<bool> usesDominated(m_function.getNumTemps(), true);
+    for (const auto &block : m_function.getBlocks()) {
+        for (size_t i = 0; i < block->instrs.size(); ++i) {
+            for (const IrValue &operand : block->instrs[i].operands) {
+                if (!operand.isTemp() || !defOf.count(operand.temp)) {
+                    continue;
+                }
+                const auto &def = defOf.at(operand.temp);
+                const bool dominated = (def.first == block.get())
+                                           ? def.second < i
+                                           : dom.dominates(def.first, block.get());
+                if (!dominated) {
+                    usesDominated[operand.temp] = false;
+                }
+            }
+        }
+    }
+
+    // - Hoist, until nothing more becomes invariant
+
+    std::vector<IrInstr> hoisted;
+    std::vector<IrBasicBlock *> bodyInOrder;
+    for (const auto &block : m_function.getBlocks()) {
+        if (m_body.count(block.get())) {
+            bodyInOrder.push_back(block.get());
+        }
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (IrBasicBlock *block : bodyInOrder) {
+            auto &instrs = block->instrs;
+            for (size_t i = 0; i < instrs.size(); ++i) {
+                if (!canHoist(instrs[i], block, dom, defs, usesDominated)) {
+                    continue;
+                }
+                m_defs_in_loop[instrs[i].dst.temp] = 0;
+                hoisted.push_back(std::move(instrs[i]));
+                instrs.erase(instrs.begin() + i--);
+                changed = true;
+            }
+        }
+    }
+
+    // - Globals still accessed in the loop are accessed through a pointer set up once
+
+    std::unordered_map<std::string, IrValue> pointerOf;
+    for (IrBasicBlock *block : bodyInOrder) {
+        for (IrInstr &instr : block->instrs) {
+            if ((instr.op != IrOp::LOAD && instr.op != IrOp::STORE) ||
+                instr.address.kind != IrAddress::Kind::GLOBAL) {
+                continue;
+            }
+            auto it = pointerOf.find(instr.address.global);
+            if (it == pointerOf.end()) {
+                const IrValue pointer = m_function.newTemp(IrType::PTR, instr.address.global);
+                hoisted.push_back(IrInstr::makeAddr(pointer, instr.address));
+                it = pointerOf.emplace(instr.address.global, pointer).first;
+            }
+            instr.setPointer(it->second);
+        }
+    }
+
+    auto &instrs = preheader->instrs;
+    instrs.insert(instrs.end() - 1, std::make_move_iterator(hoisted.begin()),
+                  std::make_move_iterator(hoisted.end()));
+}
+
+}  // namespace
+
+std::unordered_set<std::string> findPureFunctions(const IrModule &module) {
+    // Start from all functions and drop the impure ones until none is left, so that (mutually)
+    // recursive functions may be pure.
+    std::unordered_set<std::string> pure;
+    for (const auto &function : module.functions) {
+        pure.insert(function->getName());
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto &function : module.functions) {
+            if (!pure.count(function->getName())) {
+                continue;
+            }
+            for (const auto &block : function->getBlocks()) {
+                const bool impure = std::any_of(
+                    block->instrs.begin(), block->instrs.end(), [&pure](const IrInstr &instr) {
+                        return (instr.op == IrOp::STORE &&
+                                instr.address.kind != IrAddress::Kind::SLOT) ||
+                               (instr.op == IrOp::CALL && !pure.count(instr.callee));
+                    });
+                if (impure) {
+                    pure.erase(function->getName());
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return pure;
+}
+
+void hoistLoopInvariants(IrFunction &function, const std::unordered_set<std::string> &pure) {
+    function.rebuildCfg();
+    // Inner loops first: what they hoist into their preheader may go on out of the outer loop.
+    for (IrBasicBlock *header : getLoopHeaders(function)) {
+        LoopInvariantHoister(function, pure).run(header);
+    }
+    function.rebuildCfg();
+}
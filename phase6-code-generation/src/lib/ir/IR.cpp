@@ -0,0 +1,459 @@
+#include "ir/IR.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+const char *getIrTypeName(const IrType type) {
+    switch (type) {
+        case IrType::VOID:
+            return "void";
+        case IrType::I32:
+            return "i32";
+        case IrType::F32:
+            return "f32";
+        case IrType::PTR:
+            return "ptr";
+    }
+    return "?";
+}
+
+const char *getIrOpName(const IrOp op) {
+    // clang-format off
+    static const char *const kNames[] = {
+        "copy", "neg", "not", "itof",
+        "add", "sub", "mul", "div", "rem", "and", "or",
+        "lt", "le", "ne", "ge", "gt", "eq",
+        "addr", "load", "store", "call", "br", "cbr", "ret"
+    };
+    // clang-format on
+    return kNames[static_cast<int>(op)];
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+IrValue IrValue::makeTemp(const int temp, const IrType type) {
+    IrValue value;
+    value.kind = Kind::TEMP;
+    value.type = type;
+    value.temp = temp;
+    return value;
+}
+
+IrValue IrValue::makeInt(const int32_t intVal) {
+    IrValue value;
+    value.kind = Kind::INT;
+    value.type = IrType::I32;
+    value.intVal = intVal;
+    return value;
+}
+
+IrValue IrValue::makeFloat(const double floatVal) {
+    IrValue value;
+    value.kind = Kind::FLOAT;
+    value.type = IrType::F32;
+    value.floatVal = floatVal;
+    return value;
+}
+
+IrValue IrValue::makeString(const std::string &strVal) {
+    IrValue value;
+    value.kind = Kind::STRING;
+    value.type = IrType::PTR;
+    value.strVal = strVal;
+    return value;
+}
+
+bool IrValue::isSameAs(const IrValue &other) const {
+    if (kind != other.kind) {
+        return false;
+    }
+    switch (kind) {
+        case Kind::NONE:
+            return true;
+        case Kind::TEMP:
+            return temp == other.temp;
+        case Kind::INT:
+            return intVal == other.intVal;
+        case Kind::FLOAT:
+            return floatVal == other.floatVal;
+        case Kind::STRING:
+            return strVal == other.strVal;
+    }
+    return false;
+}
+
+IrAddress IrAddress::makeSlot(const int slot) {
+    IrAddress address;
+    address.kind = Kind::SLOT;
+    address.slot = slot;
+    return address;
+}
+
+IrAddress IrAddress::makeGlobal(const std::string &name) {
+    IrAddress address;
+    address.kind = Kind::GLOBAL;
+    address.global = name;
+    return address;
+}
+
+IrAddress IrAddress::makePointer() {
+    IrAddress address;
+    address.kind = Kind::POINTER;
+    return address;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+IrInstr IrInstr::makeUnary(const IrOp op, const IrValue &dst, const IrValue &a) {
+    IrInstr instr{op};
+    instr.dst = dst;
+    instr.operands = {a};
+    return instr;
+}
+
+IrInstr IrInstr::makeBinary(const IrOp op, const IrValue &dst, const IrValue &a,
+                            const IrValue &b) {
+    IrInstr instr{op};
+    instr.dst = dst;
+    instr.operands = {a, b};
+    return instr;
+}
+
+IrInstr IrInstr::makeLoad(const IrValue &dst, const IrAddress &address) {
+    IrInstr instr{IrOp::LOAD};
+    instr.dst = dst;
+    instr.address = address;
+    return instr;
+}
+
+IrInstr IrInstr::makeStore(const IrAddress &address, const IrValue &value) {
+    IrInstr instr{IrOp::STORE};
+    instr.address = address;
+    instr.operands = {value};
+    return instr;
+}
+
+IrInstr IrInstr::makeAddr(const IrValue &dst, const IrAddress &address) {
+    IrInstr instr{IrOp::ADDR};
+    instr.dst = dst;
+    instr.address = address;
+    return instr;
+}
+
+void IrInstr::setPointer(const IrValue &pointer) {
+    address = IrAddress::makePointer();
+    operands.push_back(pointer);
+}
+
+IrInstr IrInstr::makeCall(const IrValue &dst, const std::string &callee,
+                          std::vector<IrValue> args) {
+    IrInstr instr{IrOp::CALL};
+    instr.dst = dst;
+    instr.callee = callee;
+    instr.operands = std::move(args);
+    return instr;
+}
+
+IrInstr IrInstr::makeBr(IrBasicBlock *target) {
+    IrInstr instr{IrOp::BR};
+    instr.target = target;
+    return instr;
+}
+
+IrInstr IrInstr::makeCbr(const IrValue &cond, IrBasicBlock *ifTrue, IrBasicBlock *ifFalse) {
+    IrInstr instr{IrOp::CBR};
+    instr.operands = {cond};
+    instr.target = ifTrue;
+    instr.target2 = ifFalse;
+    return instr;
+}
+
+IrInstr IrInstr::makeRet(const IrValue &value) {
+    IrInstr instr{IrOp::RET};
+    if (!value.isNone()) {
+        instr.operands = {value};
+    }
+    return instr;
+}
+
+IrValue foldConstant(const IrInstr &instr) {
+    for (const IrValue &operand : instr.operands) {
+        if (operand.kind != IrValue::Kind::INT) {
+            return IrValue();
+        }
+    }
+    if (instr.op == IrOp::NEG || instr.op == IrOp::NOT) {
+        const uint32_t a = static_cast<uint32_t>(instr.operands[0].intVal);
+        return IrValue::makeInt(static_cast<int32_t>((instr.op == IrOp::NEG) ? 0u - a : a ^ 1u));
+    }
+    if (!instr.isBinary()) {
+        return IrValue();
+    }
+
+    const int32_t l = instr.operands[0].intVal;
+    const int32_t r = instr.operands[1].intVal;
+    // wrap around like add/sub/mul do
+    const uint32_t ul = static_cast<uint32_t>(l);
+    const uint32_t ur = static_cast<uint32_t>(r);
+    // div/rem: INT_MIN / -1 overflows to INT_MIN with remainder 0
+    const bool overflows = l == INT32_MIN && r == -1;
+    switch (instr.op) {
+        case IrOp::ADD:
+            return IrValue::makeInt(static_cast<int32_t>(ul + ur));
+        case IrOp::SUB:
+            return IrValue::makeInt(static_cast<int32_t>(ul - ur));
+        case IrOp::MUL:
+            return IrValue::makeInt(static_cast<int32_t>(ul * ur));
+        case IrOp::DIV:
+            if (r == 0) {
+                return IrValue();
+            }
+            return IrValue::makeInt(overflows ? l : l / r);
+        case IrOp::REM:
+            if (r == 0) {
+                return IrValue();
+            }
+            return IrValue::makeInt(overflows ? 0 : l % r);
+        case IrOp::AND:
+            return IrValue::makeInt(l & r);
+        case IrOp::OR:
+            return IrValue::makeInt(l | r);
+        case IrOp::LT:
+            return IrValue::makeInt(l < r);
+        case IrOp::LE:
+            return IrValue::makeInt(l <= r);
+        case IrOp::NE:
+            return IrValue::makeInt(l != r);
+        case IrOp::GE:
+            return IrValue::makeInt(l >= r);
+        case IrOp::GT:
+            return IrValue::makeInt(l > r);
+        case IrOp::EQ:
+            return IrValue::makeInt(l == r);
+        default:
+            return IrValue();
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+IrValue IrFunction::newTemp(const IrType type, const std::string &name) {
+    m_temps.push_back(IrTempInfo{type, name});
+    return IrValue::makeTemp(m_temps.size() - 1, type);
+}
+
+int IrFunction::newSlot(const std::string &name, const IrType type, const int size) {
+    m_slots.push_back(IrSlot{name, type, size});
+    return m_slots.size() - 1;
+}
+
+void IrFunction::eraseSlots(const std::vector<bool> &erased) {
+    std::vector<int> newIndex(m_slots.size(), -1);
+    std::vector<IrSlot> kept;
+    for (size_t slot = 0; slot < m_slots.size(); ++slot) {
+        if (!erased[slot]) {
+            newIndex[slot] = kept.size();
+            kept.push_back(std::move(m_slots[slot]));
+        }
+    }
+    m_slots = std::move(kept);
+
+    for (auto &block : m_blocks) {
+        for (IrInstr &instr : block->instrs) {
+            if (instr.address.kind == IrAddress::Kind::SLOT) {
+                instr.address.slot = newIndex[instr.address.slot];
+            }
+        }
+    }
+}
+
+IrBasicBlock *IrFunction::newBlock() {
+    m_blocks.emplace_back(new IrBasicBlock{m_next_block_id++});
+    return m_blocks.back().get();
+}
+
+void IrFunction::rebuildCfg() {
+    for (auto &block : m_blocks) {
+        block->preds.clear();
+        block->succs.clear();
+    }
+    for (auto &block : m_blocks) {
+        if (!block->hasTerminator()) {
+            continue;
+        }
+        const IrInstr &term = block->instrs.back();
+        for (IrBasicBlock *succ : {term.target, term.target2}) {
+            if (succ != nullptr && (block->succs.empty() || block->succs.back() != succ)) {
+                block->succs.push_back(succ);
+                succ->preds.push_back(block.get());
+            }
+        }
+    }
+}
+
+bool IrFunction::takesAddressOfSlot() const {
+    for (const auto &block : m_blocks) {
+        for (const IrInstr &instr : block->instrs) {
+            if (instr.op == IrOp::ADDR && instr.address.kind == IrAddress::Kind::SLOT) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool IrFunction::removeUnreachableBlocks() {
+    rebuildCfg();
+
+    std::unordered_set<IrBasicBlock *> reachable;
+    std::vector<IrBasicBlock *> worklist{m_blocks.front().get()};
+    reachable.insert(worklist.back());
+    while (!worklist.empty()) {
+        IrBasicBlock *block = worklist.back();
+        worklist.pop_back();
+        for (IrBasicBlock *succ : block->succs) {
+            if (reachable.insert(succ).second) {
+                worklist.push_back(succ);
+            }
+        }
+    }
+    if (reachable.size() == m_blocks.size()) {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<IrBasicBlock>> kept;
+    for (auto &block : m_blocks) {
+        if (reachable.count(block.get())) {
+            kept.push_back(std::move(block));
+        }
+    }
+    m_blocks = std::move(kept);
+    m_next_block_id = 0;
+    for (auto &block : m_blocks) {
+        block->id = m_next_block_id++;
+    }
+    rebuildCfg();
+    return true;
+}
+
+std::string IrFunction::getValueInString(const IrValue &value) const {
+    switch (value.kind) {
+        case IrValue::Kind::NONE:
+            return "<none>";
+        case IrValue::Kind::TEMP: {
+            const std::string &name = m_temps.at(value.temp).name;
+            return "%" + (name.empty() ? "" : name + ".") + std::to_string(value.temp);
+        }
+        case IrValue::Kind::INT:
+            return std::to_string(value.intVal);
+        case IrValue::Kind::FLOAT:
+            return std::to_string(value.floatVal);
+        case IrValue::Kind::STRING:
+            return "\"" + value.strVal + "\"";
+    }
+    return "?";
+}
+
+std::string IrFunction::getAddressInString(const IrAddress &address) const {
+    if (address.kind == IrAddress::Kind::SLOT) {
+        return "$" + m_slots.at(address.slot).name;
+    }
+    return "@" + address.global;
+}
+
+void IrFunction::dump(FILE *p_out_file) const {
+    fprintf(p_out_file, "function %s(", m_name.c_str());
+    for (size_t i = 0; i < m_params.size(); ++i) {
+        fprintf(p_out_file, "%s%s: %s", (i == 0) ? "" : ", ",
+                getValueInString(m_params[i]).c_str(), getIrTypeName(m_params[i].type));
+    }
+    fprintf(p_out_file, "): %s\n", getIrTypeName(m_return_type));
+
+    for (const IrSlot &slot : m_slots) {
+        fprintf(p_out_file, "    slot $%s: %s, %d bytes\n", slot.name.c_str(),
+                getIrTypeName(slot.type), slot.size);
+    }
+
+    for (const auto &block : m_blocks) {
+        fprintf(p_out_file, "bb%d:", block->id);
+        if (!block->preds.empty()) {
+            fprintf(p_out_file, "    ; preds =");
+            for (const IrBasicBlock *pred : block->preds) {
+                fprintf(p_out_file, " bb%d", pred->id);
+            }
+        }
+        fprintf(p_out_file, "\n");
+
+        for (const IrInstr &instr : block->instrs) {
+            fprintf(p_out_file, "    ");
+            if (!instr.dst.isNone()) {
+                fprintf(p_out_file, "%s: %s = ", getValueInString(instr.dst).c_str(),
+                        getIrTypeName(instr.dst.type));
+            }
+            fprintf(p_out_file, "%s", getIrOpName(instr.op));
+
+            std::vector<std::string> operands;
+            if (instr.op == IrOp::CALL) {
+                std::string call = " " + instr.callee + "(";
+                for (size_t i = 0; i < instr.operands.size(); ++i) {
+                    call += (i == 0 ? "" : ", ") + getValueInString(instr.operands[i]);
+                }
+                fprintf(p_out_file, "%s)\n", call.c_str());
+                continue;
+            }
+            // the pointer of a load/store goes in the place of the address, as [%p]
+            size_t numOperands = instr.operands.size();
+            if (instr.address.kind == IrAddress::Kind::POINTER) {
+                operands.push_back("[" + getValueInString(instr.operands.back()) + "]");
+                --numOperands;
+            } else if (instr.address.kind != IrAddress::Kind::NONE) {
+                operands.push_back(getAddressInString(instr.address));
+            }
+            for (size_t i = 0; i < numOperands; ++i) {
+                operands.push_back(getValueInString(instr.operands[i]));
+            }
+            for (const IrBasicBlock *target : {instr.target, instr.target2}) {
+                if (target != nullptr) {
+                    operands.push_back("bb" + std::to_string(target->id));
+                }
+            }
+            for (size_t i = 0; i < operands.size(); ++i) {
+                fprintf(p_out_file, "%s%s", (i == 0) ? " " : ", ", operands[i].c_str());
+            }
+            fprintf(p_out_file, "\n");
+        }
+    }
+}
+
+void IrModule::dump(FILE *p_out_file) const {
+    fprintf(p_out_file, "; module %s\n", name.c_str());
+    for (const IrGlobal &global : globals) {
+        if (global.init.isNone()) {
+            fprintf(p_out_file, "global @%s: %s, %d bytes\n", global.name.c_str(),
+                    getIrTypeName(global.type), global.size);
+        } else {
+            std::string init;
+            switch (global.init.kind) {
+                case IrValue::Kind::INT:
+                    init = std::to_string(global.init.intVal);
+                    break;
+                case IrValue::Kind::FLOAT:
+                    init = std::to_string(global.init.floatVal);
+                    break;
+                default:
+                    init = "\"" + global.init.strVal + "\"";
+                    break;
+            }
+            fprintf(p_out_file, "constant @%s: %s = %s\n", global.name.c_str(),
+                    getIrTypeName(global.type), init.c_str());
+        }
+    }
+    for (const auto &function : functions) {
+        fprintf(p_out_file, "\n");
+        function->dump(p_out_file);
+    }
+}
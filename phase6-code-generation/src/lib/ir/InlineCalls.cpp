@@ -0,0 +1,229 @@
+#include "ir/IR.hpp"
+#include "ir/IrPasses.hpp"
+#include "util/CompilerOptions.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using FunctionMap = std::unordered_map<std::string, IrFunction *>;
+
+int getSizeOf(const IrFunction &function) {
+    int size = 0;
+    for (const auto &block : function.getBlocks()) {
+        size += block->instrs.size();
+    }
+    return size;
+}
+
+/// @return the functions of the module called by `function` (runtime routines not included)
+std::vector<IrFunction *> getCallees(const IrFunction &function, const FunctionMap &functions) {
+    std::vector<IrFunction *> callees;
+    for (const auto &block : function.getBlocks()) {
+        for (const IrInstr &instr : block->instrs) {
+            if (instr.op != IrOp::CALL) {
+                continue;
+            }
+            auto it = functions.find(instr.callee);
+            if (it != functions.end() &&
+                std::find(callees.begin(), callees.end(), it->second) == callees.end()) {
+                callees.push_back(it->second);
+            }
+        }
+    }
+    return callees;
+}
+
+/// @return whether `function` may end up calling itself
+bool isRecursive(IrFunction *function, const FunctionMap &functions) {
+    std::unordered_set<IrFunction *> visited;
+    std::vector<IrFunction *> worklist = getCallees(*function, functions);
+    while (!worklist.empty()) {
+        IrFunction *callee = worklist.back();
+        worklist.pop_back();
+        if (callee == function) {
+            return true;
+        }
+        if (visited.insert(callee).second) {
+            for (IrFunction *next : getCallees(*callee, functions)) {
+                worklist.push_back(next);
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Replaces the call `block->instrs[index]` by a copy of the body of `callee`.
+ *
+ * The temporaries and slots of the callee are renamed to new ones of the caller (a slot keeps
+ * its name, prefixed with the name of the callee); the entry block of the callee is appended to
+ * `block`, the parameters are assigned the arguments, and each `ret` becomes a copy into the
+ * destination of the call followed by a branch to the instructions after the call.
+ */
+void inlineCall(IrFunction &caller, IrBasicBlock *block, const size_t index,
+                const IrFunction &callee) {
+    const IrInstr call = std::move(block->instrs[index]);
+    std::vector<IrInstr> rest(std::make_move_iterator(block->instrs.begin() + index + 1),
+                              std::make_move_iterator(block->instrs.end()));
+    block->instrs.resize(index);
+
+    std::vector<IrValue> tempOf;
+    for (int temp = 0; temp < callee.getNumTemps(); ++temp) {
+        const IrTempInfo &info = callee.getTempInfo(temp);
+        tempOf.push_back(caller.newTemp(info.type, info.name));
+    }
+    std::vector<int> slotOf;
+    for (int slot = 0; slot < callee.getNumSlots(); ++slot) {
+        const IrSlot &info = callee.getSlot(slot);
+        slotOf.push_back(caller.newSlot(callee.getName() + "." + info.name, info.type, info.size));
+    }
+
+    // The entry block is merged into `block` unless it is the target of a branch.
+    const auto &calleeBlocks = callee.getBlocks();
+    const bool mergesEntry = calleeBlocks.front()->preds.empty();
+    std::unordered_map<const IrBasicBlock *, IrBasicBlock *> blockOf;
+    std::vector<IrBasicBlock *> newBlocks;
+    for (const auto &calleeBlock : calleeBlocks) {
+        if (mergesEntry && calleeBlock == calleeBlocks.front()) {
+            blockOf[calleeBlock.get()] = block;
+            continue;
+        }
+        newBlocks.push_back(caller.newBlock());
+        blockOf[calleeBlock.get()] = newBlocks.back();
+    }
+
+    for (size_t i = 0; i < call.operands.size(); ++i) {
+        const IrValue &param = tempOf[callee.getParams()[i].temp];
+        block->instrs.push_back(IrInstr::makeUnary(IrOp::COPY, param, call.operands[i]));
+    }
+    if (!mergesEntry) {
+        block->instrs.push_back(IrInstr::makeBr(blockOf.at(calleeBlocks.front().get())));
+    }
+
+    std::vector<IrBasicBlock *> returningBlocks;
+    for (const auto &calleeBlock : calleeBlocks) {
+        IrBasicBlock *newBlock = blockOf.at(calleeBlock.get());
+        for (IrInstr instr : calleeBlock->instrs) {
+            for (IrValue &operand : instr.operands) {
+                if (operand.isTemp()) {
+                    operand = tempOf[operand.temp];
+                }
+            }
+            if (instr.dst.isTemp()) {
+                instr.dst = tempOf[instr.dst.temp];
+            }
+            if (instr.address.kind == IrAddress::Kind::SLOT) {
+                instr.address.slot = slotOf[instr.address.slot];
+            }
+            if (instr.target != nullptr) {
+                instr.target = blockOf.at(instr.target);
+            }
+            if (instr.target2 != nullptr) {
+                instr.target2 = blockOf.at(instr.target2);
+            }
+
+            if (instr.op == IrOp::RET) {
+                if (!call.dst.isNone() && !instr.operands.empty()) {
+                    newBlock->instrs.push_back(
+                        IrInstr::makeUnary(IrOp::COPY, call.dst, instr.operands[0]));
+                }
+                returningBlocks.push_back(newBlock);
+                continue;
+            }
+            newBlock->instrs.push_back(std::move(instr));
+        }
+    }
+
+    // A single return simply falls into the rest of the block.
+    if (returningBlocks.size() == 1) {
+        auto &instrs = returningBlocks.front()->instrs;
+        instrs.insert(instrs.end(), std::make_move_iterator(rest.begin()),
+                      std::make_move_iterator(rest.end()));
+    } else {
+        IrBasicBlock *restBlock = caller.newBlock();
+        restBlock->instrs = std::move(rest);
+        for (IrBasicBlock *returningBlock : returningBlocks) {
+            returningBlock->instrs.push_back(IrInstr::makeBr(restBlock));
+        }
+        newBlocks.push_back(restBlock);
+    }
+
+    // Lay the new blocks out right after `block`.
+    auto &blocks = caller.getBlocks();
+    const auto position =
+        std::find_if(blocks.begin(), blocks.end(), [block](const auto &b) { return b.get() == block; }) + 1;
+    std::rotate(position, blocks.end() - newBlocks.size(), blocks.end());
+}
+
+/// @return whether any call in `caller` was inlined
+bool inlineCallsIn(IrFunction &caller, const FunctionMap &functions,
+                   const std::unordered_set<const IrFunction *> &inlinable) {
+    bool changed = false;
+    auto &blocks = caller.getBlocks();
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        IrBasicBlock *block = blocks[b].get();
+        for (size_t i = 0; i < block->instrs.size(); ++i) {
+            const IrInstr &instr = block->instrs[i];
+            if (instr.op != IrOp::CALL) {
+                continue;
+            }
+            auto it = functions.find(instr.callee);
+            if (it == functions.end() || !inlinable.count(it->second)) {
+                continue;
+            }
+            // The rest of the block moves on, so the scan goes on with the inlined body.
+            inlineCall(caller, block, i, *it->second);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+}  // namespace
+
+void inlineCalls(IrModule &module, const CompilerOptions &options) {
+    if (options.inlineBudget <= 0) {
+        return;
+    }
+
+    FunctionMap functions;
+    for (auto &function : module.functions) {
+        functions[function->getName()] = function.get();
+        function->rebuildCfg();
+    }
+
+    // Callees first, so that a callee is measured with its own calls already inlined.
+    std::vector<IrFunction *> order;
+    std::unordered_set<IrFunction *> visited;
+    const auto visit = [&](IrFunction *function, const auto &self) -> void {
+        if (!visited.insert(function).second) {
+            return;
+        }
+        for (IrFunction *callee : getCallees(*function, functions)) {
+            self(callee, self);
+        }
+        order.push_back(function);
+    };
+    for (auto &function : module.functions) {
+        visit(function.get(), visit);
+    }
+
+    std::unordered_set<const IrFunction *> inlinable;
+    for (IrFunction *function : order) {
+        if (inlineCallsIn(*function, functions, inlinable)) {
+            function->removeUnreachableBlocks();
+            propagateCopies(*function);
+            removeDeadInstructions(*function);
+        }
+        if (getSizeOf(*function) <= options.inlineBudget && !isRecursive(function, functions)) {
+            inlinable.insert(function);
+        }
+    }
+}
@@ -0,0 +1,896 @@
+#include "ir/IrBuilder.hpp"
+
+#include "AST/CompoundStatement.hpp"
+#include "AST/ConstantFolder.hpp"
+#include "AST/for.hpp"
+#include "AST/function.hpp"
+#include "AST/program.hpp"
+#include "ir/IR.hpp"
+#include "sema/SemanticAnalyzer.hpp"
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+IrBuilder::IrBuilder(const std::string &module_name,
+                     SymbolTableMap &p_symbol_table_of_scoping_nodes,
+                     const CompilerOptions &p_options)
+    : m_symbol_table_of_scoping_nodes(p_symbol_table_of_scoping_nodes),
+      m_module(new IrModule),
+      m_options(p_options) {
+    m_module->name = module_name;
+}
+
+IrType getIrTypeOf(const Type &type) {
+    if (!type.arrRefs.empty()) {
+        return IrType::PTR;  // an array is referred to by its address
+    }
+    switch (type.scalarType) {
+        case ScalarType::VOID:
+            return IrType::VOID;
+        case ScalarType::REAL:
+            return IrType::F32;
+        case ScalarType::STRING:
+            return IrType::PTR;
+        default:
+            return IrType::I32;
+    }
+}
+
+int getRegisterNeedOf(const ExpressionNode *expr, const bool reorders) {
+    // values evaluated in order, each held while the next ones are
+    auto inOrder = [reorders](const std::vector<ExpressionNode *> &exprs) {
+        int need = 1;
+        int held = 0;
+        for (const ExpressionNode *each : exprs) {
+            need = std::max(need, getRegisterNeedOf(each, reorders) + held);
+            ++held;
+        }
+        return need;
+    };
+
+    if (const auto *binOp = dynamic_cast<const BinaryOperatorNode *>(expr)) {
+        const ExpressionNode *left = binOp->getLeftOperand();
+        const ExpressionNode *right = binOp->getRightOperand();
+        const int l = getRegisterNeedOf(left, reorders);
+        const int r = getRegisterNeedOf(right, reorders);
+        // each operand of and/or ends in a branch of its own
+        if (binOp->getOperator() == OperatorType::AND || binOp->getOperator() == OperatorType::OR) {
+            return std::max(l, r);
+        }
+        if (reorders && !mayCallFunction(left) && !mayCallFunction(right)) {
+            return (l == r) ? l + 1 : std::max(l, r);
+        }
+        return std::max(l, r + 1);
+    }
+    if (const auto *unOp = dynamic_cast<const UnaryOperatorNode *>(expr)) {
+        return getRegisterNeedOf(unOp->getOperand(), reorders);
+    }
+    if (const auto *call = dynamic_cast<const FunctionInvocationNode *>(expr)) {
+        return inOrder(call->getArguments());
+    }
+    if (const auto *varRef = dynamic_cast<const VariableReferenceNode *>(expr)) {
+        // The indices come first, then the start of the array, to which each one is added.
+        std::vector<ExpressionNode *> indices;
+        for (ExpressionNode *index : varRef->getIndices()) {
+            if (dynamic_cast<const ConstantValueNode *>(index) == nullptr) {
+                indices.push_back(index);
+            }
+        }
+        return std::max(inOrder(indices), static_cast<int>(indices.size()) + 1);
+    }
+    return 1;
+}
+
+static IrValue getIrValueOf(const ConstVal &constVal) {
+    switch (constVal.scalarType) {
+        case ScalarType::INTEGER:
+            return IrValue::makeInt(constVal.valContainer.integer);
+        case ScalarType::BOOLEAN:
+            return IrValue::makeInt(constVal.valContainer.boolean ? 1 : 0);
+        case ScalarType::REAL:
+            return IrValue::makeFloat(constVal.valContainer.real);
+        case ScalarType::STRING:
+            return IrValue::makeString(constVal.valContainer.string);
+        default: {
+            printf("Const val node: invalid const type during codegen\n");
+            exit(1);
+        }
+    }
+}
+
+/**
+ * @return a new block laid out right before whichever of `a` and `b` comes first, so that the
+ *         blocks of a short-circuited condition fall into each other in the order they are lowered
+ */
+static IrBasicBlock *newBlockBefore(IrFunction &function, const IrBasicBlock *a,
+                                    const IrBasicBlock *b) {
+    IrBasicBlock *block = function.newBlock();
+    auto &blocks = function.getBlocks();
+    const auto position = std::find_if(blocks.begin(), blocks.end(), [a, b](const auto &other) {
+        return other.get() == a || other.get() == b;
+    });
+    std::rotate(position, blocks.end() - 1, blocks.end());
+    return block;
+}
+
+/**
+ * Counts the nodes of the statements and expressions of a loop body, the size of one copy of it
+ * when unrolling. A nested for loop counts as its body times its trip count, since it may be
+ * fully unrolled as well.
+ */
+class NodeCounter final : public AstNodeVisitor {
+   public:
+    int64_t count = 0;
+
+    void visit(VariableNode &p_variable) override {
+        ++count;
+    }
+    void visit(ConstantValueNode &p_constant_value) override {
+        ++count;
+    }
+    void visit(DeclNode &p_decl) override {
+        p_decl.visitChildNodes(*this);
+    }
+    void visit(CompoundStatementNode &p_compound_statement) override {
+        p_compound_statement.visitChildNodes(*this);
+    }
+    void visit(PrintNode &p_print) override {
+        ++count;
+        p_print.visitChildNodes(*this);
+    }
+    void visit(BinaryOperatorNode &p_bin_op) override {
+        ++count;
+        p_bin_op.visitChildNodes(*this);
+    }
+    void visit(UnaryOperatorNode &p_un_op) override {
+        ++count;
+        p_un_op.visitChildNodes(*this);
+    }
+    void visit(FunctionInvocationNode &p_func_invocation) override {
+        ++count;
+        p_func_invocation.visitChildNodes(*this);
+    }
+    void visit(VariableReferenceNode &p_variable_ref) override {
+        ++count;
+        p_variable_ref.visitChildNodes(*this);
+    }
+    void visit(AssignmentNode &p_assignment) override {
+        ++count;
+        p_assignment.visitChildNodes(*this);
+    }
+    void visit(ReadNode &p_read) override {
+        ++count;
+    }
+    void visit(IfNode &p_if) override {
+        ++count;
+        p_if.visitChildNodes(*this);
+    }
+    void visit(WhileNode &p_while) override {
+        ++count;
+        p_while.visitChildNodes(*this);
+    }
+    void visit(ForNode &p_for) override {
+        NodeCounter body;
+        p_for.getBody()->accept(body);
+        count += 1 + body.count * getTripCountOf(p_for);
+    }
+    void visit(ReturnNode &p_return) override {
+        ++count;
+        p_return.visitChildNodes(*this);
+    }
+
+    static int64_t getTripCountOf(ForNode &p_for) {
+        return static_cast<int64_t>(p_for.getCondition()->getConstVal().valContainer.integer) -
+               p_for.getInitConstVal()->getConstVal().valContainer.integer;
+    }
+};
+
+/// the nodes of a loop body that unrolling may copy once per unit of CompilerOptions::unrollFactor
+static const int64_t kUnrollNodesPerCopy = 16;
+
+/* ------------------------------------------------------------------------------------------------- */
+
+void IrBuilder::emit(IrInstr instr) {
+    const bool isTerminator = instr.isTerminator();
+    m_block->instrs.push_back(std::move(instr));
+    if (isTerminator) {
+        // whatever follows is unreachable until the next block is placed
+        m_block = m_function->newBlock();
+    }
+}
+
+void IrBuilder::placeBlock(IrBasicBlock *block) {
+    if (!m_block->hasTerminator()) {
+        emit(IrInstr::makeBr(block));
+    }
+    m_block = block;
+}
+
+IrValue IrBuilder::evaluate(ExpressionNode *expr, const IrType target) {
+    expr->accept(*this);
+    IrValue value = m_result;
+
+    // Coercion(int -> real)
+    if (target == IrType::F32 && value.type == IrType::I32) {
+        const IrValue converted = m_function->newTemp(IrType::F32);
+        emit(IrInstr::makeUnary(IrOp::ITOF, converted, value));
+        value = converted;
+    }
+    return value;
+}
+
+bool IrBuilder::evaluatesRightFirst(const BinaryOperatorNode &p_bin_op) const {
+    const ExpressionNode *left = p_bin_op.getLeftOperand();
+    const ExpressionNode *right = p_bin_op.getRightOperand();
+    if (m_options.optimizationLevel == 0 || !m_options.reorderOperands ||
+        mayCallFunction(left) || mayCallFunction(right)) {
+        return false;
+    }
+    return getRegisterNeedOf(right, true) > getRegisterNeedOf(left, true);
+}
+
+void IrBuilder::noteRegisterNeed(const AstNode &p_statement, const char *statement,
+                                 const ExpressionNode *expr) {
+    if (!m_options.registerReport || !m_measured_statements.insert(&p_statement).second) {
+        return;
+    }
+    const bool reorders = m_options.optimizationLevel > 0 && m_options.reorderOperands;
+    m_statement_needs.push_back({m_function->getName(), p_statement.getLocation().line, statement,
+                                 getRegisterNeedOf(expr, reorders),
+                                 getRegisterNeedOf(expr, false)});
+}
+
+void IrBuilder::branchOn(ExpressionNode *condition, IrBasicBlock *trueBlock,
+                         IrBasicBlock *falseBlock) {
+    if (auto *unaryOp = dynamic_cast<UnaryOperatorNode *>(condition)) {
+        if (unaryOp->getOperator() == OperatorType::NOT) {
+            branchOn(unaryOp->getOperand(), falseBlock, trueBlock);
+            return;
+        }
+    }
+    if (auto *binOp = dynamic_cast<BinaryOperatorNode *>(condition)) {
+        const OperatorType op = binOp->getOperator();
+        if (op == OperatorType::AND || op == OperatorType::OR) {
+            IrBasicBlock *rightBlock = newBlockBefore(*m_function, trueBlock, falseBlock);
+            if (op == OperatorType::AND) {
+                branchOn(binOp->getLeftOperand(), rightBlock, falseBlock);
+            } else {
+                branchOn(binOp->getLeftOperand(), trueBlock, rightBlock);
+            }
+            m_block = rightBlock;
+            branchOn(binOp->getRightOperand(), trueBlock, falseBlock);
+            return;
+        }
+    }
+    emit(IrInstr::makeCbr(evaluate(condition), trueBlock, falseBlock));
+}
+
+IrAddress IrBuilder::getAddressOf(const SymbolEntry *entry) const {
+    if (entry->level == 0) {
+        return IrAddress::makeGlobal(entry->name);
+    }
+    return IrAddress::makeSlot(m_slot_of_local.at(entry));
+}
+
+IrValue IrBuilder::evaluateAddressOf(VariableReferenceNode &p_variable_ref,
+                                     const SymbolEntry *entry) {
+    // An index known while lowering (a literal, or a loop variable of an unrolled copy) is
+    // folded into the offset.
+    int32_t offset = 0;
+    std::vector<std::pair<IrValue, int>> scaledIndices;
+    const std::vector<ExpressionNode *> &indices = p_variable_ref.getIndices();
+    for (size_t dim = 0; dim < indices.size(); ++dim) {
+        const IrValue index = evaluate(indices[dim]);
+        if (index.kind == IrValue::Kind::INT) {
+            offset += index.intVal * entry->type.getStrideOf(dim);
+        } else {
+            scaledIndices.emplace_back(index, entry->type.getStrideOf(dim));
+        }
+    }
+
+    IrValue address = m_function->newTemp(IrType::PTR, entry->name);
+    if (entry->isAlias) {
+        emit(IrInstr::makeLoad(address, getAddressOf(entry)));
+    } else {
+        emit(IrInstr::makeAddr(address, getAddressOf(entry)));
+    }
+    if (offset != 0) {
+        const IrValue moved = m_function->newTemp(IrType::PTR);
+        emit(IrInstr::makeBinary(IrOp::ADD, moved, address, IrValue::makeInt(offset)));
+        address = moved;
+    }
+    for (const auto &index : scaledIndices) {
+        const IrValue scaled = m_function->newTemp(IrType::I32);
+        emit(IrInstr::makeBinary(IrOp::MUL, scaled, index.first, IrValue::makeInt(index.second)));
+        const IrValue moved = m_function->newTemp(IrType::PTR);
+        emit(IrInstr::makeBinary(IrOp::ADD, moved, address, scaled));
+        address = moved;
+    }
+    return address;
+}
+
+void IrBuilder::pushScope(const AstNode *node) {
+    m_symbol_manager.pushScope(std::move(m_symbol_table_of_scoping_nodes.at(node)));
+}
+
+void IrBuilder::popScope(const AstNode *node) {
+    m_symbol_table_of_scoping_nodes.at(node) = m_symbol_manager.popScope();
+}
+
+void IrBuilder::beginFunction(const char *name, const IrType returnType) {
+    m_module->functions.emplace_back(new IrFunction(name, returnType));
+    m_function = m_module->functions.back().get();
+    m_block = m_function->newBlock();
+    m_return_type = returnType;
+}
+
+void IrBuilder::endFunction() {
+    if (!m_block->hasTerminator()) {
+        emit(IrInstr::makeRet(IrValue()));
+    }
+    m_function->removeUnreachableBlocks();
+
+    m_function = nullptr;
+    m_block = nullptr;
+    m_slot_of_local.clear();
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+void IrBuilder::visit(ProgramNode &p_program) {
+    pushScope(&p_program);
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getDeclarations()->begin(), p_program.getDeclarations()->end(),
+             visit_ast_node);
+    for_each(p_program.getFunctions()->begin(), p_program.getFunctions()->end(), visit_ast_node);
+
+    // main function
+    beginFunction("main", IrType::VOID);
+    const_cast<CompoundStatementNode *>(p_program.getBody())->accept(*this);
+    endFunction();
+
+    popScope(&p_program);
+}
+
+void IrBuilder::visit(DeclNode &p_decl) {
+    p_decl.visitChildNodes(*this);
+}
+
+void IrBuilder::visit(VariableNode &p_variable) {
+    // Every reference to a constant has been replaced by its value (see ConstantFolder).
+    if (m_options.foldConstants && p_variable.getConstValueNode() != nullptr) {
+        return;
+    }
+
+    const Type elementType(p_variable.getType().scalarType);
+    if (m_symbol_manager.currlvl == 0) {
+        // global var/const
+        IrGlobal global{p_variable.getNameCString(), getIrTypeOf(elementType)};
+        global.size = p_variable.getType().getSizeInBytes();
+        if (p_variable.getConstValueNode() != nullptr) {
+            global.init = getIrValueOf(p_variable.getConstValueNode()->getConstVal());
+        }
+        m_module->globals.push_back(std::move(global));
+        return;
+    }
+
+    // local var/const, parameter, loop var
+    const SymbolEntry *entry = m_symbol_manager.findSymbol(p_variable.getNameCString());
+    if (entry == nullptr) {
+        perror("var not found");
+        exit(1);
+    }
+    // (An array parameter is the address of the caller's array.)
+    const int slot = entry->isAlias ? m_function->newSlot(entry->name, IrType::PTR, 4)
+                                    : m_function->newSlot(entry->name, getIrTypeOf(elementType),
+                                                          entry->type.getSizeInBytes());
+    m_slot_of_local[entry] = slot;
+
+    if (p_variable.getConstValueNode()) {
+        const IrValue value = evaluate(p_variable.getConstValueNode());
+        emit(IrInstr::makeStore(IrAddress::makeSlot(slot), value));
+    }
+}
+
+void IrBuilder::visit(ConstantValueNode &p_constant_value) {
+    m_result = getIrValueOf(p_constant_value.getConstVal());
+}
+
+void IrBuilder::visit(FunctionNode &p_function) {
+    pushScope(&p_function);
+
+    // only declared (e.g. defined in C), nothing to lower
+    if (p_function.getBody() == nullptr) {
+        popScope(&p_function);
+        return;
+    }
+
+    beginFunction(p_function.getNameCString(), getIrTypeOf(p_function.getReturnType()));
+    m_symbol_manager.upperIsFunction = true;
+
+    for (auto &param : p_function.getParameters()) {
+        param->accept(*this);
+    }
+
+    // Store the arguments into the slots of the parameters.
+    const int numOfParam = p_function.getNumOfParameters();
+    const std::vector<SymbolEntry> &currTable = m_symbol_manager.tables.back()->entries;
+    for (int i = 0; i < numOfParam; ++i) {
+        const IrValue arg = m_function->newTemp(getIrTypeOf(currTable[i].type), currTable[i].name);
+        m_function->getParams().push_back(arg);
+        emit(IrInstr::makeStore(getAddressOf(&currTable[i]), arg));
+    }
+
+    p_function.getBody()->accept(*this);
+
+    m_symbol_manager.upperIsFunction = false;
+    popScope(&p_function);
+    endFunction();
+}
+
+void IrBuilder::visit(CompoundStatementNode &p_compound_statement) {
+    const bool upperIsFunction = m_symbol_manager.upperIsFunction;
+    if (upperIsFunction) {
+        m_symbol_manager.upperIsFunction = false;
+    } else {
+        pushScope(&p_compound_statement);
+    }
+
+    for (auto &decl : p_compound_statement.getDeclarations()) {
+        decl->accept(*this);
+    }
+    // the value of a function invocation statement is simply left unused
+    for (auto &stmt : p_compound_statement.getStatements()) {
+        if (const auto *call = dynamic_cast<const FunctionInvocationNode *>(stmt)) {
+            noteRegisterNeed(*call, "call", call);
+        }
+        stmt->accept(*this);
+    }
+
+    if (upperIsFunction) {
+        m_symbol_manager.upperIsFunction = true;
+    } else {
+        popScope(&p_compound_statement);
+    }
+}
+
+void IrBuilder::visit(PrintNode &p_print) {
+    auto *expr = const_cast<ExpressionNode *>(p_print.getExpression());
+    noteRegisterNeed(p_print, "print", expr);
+    const IrValue value = evaluate(expr);
+
+    switch (expr->getTypeOfResult().scalarType) {
+        case ScalarType::INTEGER:
+            emit(IrInstr::makeCall(IrValue(), "printInt", {value}));
+            break;
+        case ScalarType::STRING:
+            emit(IrInstr::makeCall(IrValue(), "printString", {value}));
+            break;
+        case ScalarType::REAL:
+            emit(IrInstr::makeCall(IrValue(), "printReal", {value}));
+            break;
+        default: {
+            printf("print: not implemented type\n");
+            exit(1);
+        }
+    }
+}
+
+void IrBuilder::visit(BinaryOperatorNode &p_bin_op) {
+    // and/or: the value is where the branches end up
+    if (p_bin_op.getOperator() == OperatorType::AND || p_bin_op.getOperator() == OperatorType::OR) {
+        IrBasicBlock *trueBlock = m_function->newBlock();
+        IrBasicBlock *falseBlock = m_function->newBlock();
+        IrBasicBlock *nextBlock = m_function->newBlock();
+        const IrValue result = m_function->newTemp(IrType::I32);
+        branchOn(&p_bin_op, trueBlock, falseBlock);
+
+        m_block = trueBlock;
+        emit(IrInstr::makeUnary(IrOp::COPY, result, IrValue::makeInt(1)));
+        emit(IrInstr::makeBr(nextBlock));
+        m_block = falseBlock;
+        emit(IrInstr::makeUnary(IrOp::COPY, result, IrValue::makeInt(0)));
+        placeBlock(nextBlock);
+        m_result = result;
+        return;
+    }
+
+    const bool isFloatOperation =
+        p_bin_op.getLeftOperand()->getTypeOfResult().isSameType(ScalarType::REAL) ||
+        p_bin_op.getRightOperand()->getTypeOfResult().isSameType(ScalarType::REAL);
+    const IrType operandType = isFloatOperation ? IrType::F32 : IrType::VOID;
+    IrValue lhs, rhs;
+    if (evaluatesRightFirst(p_bin_op)) {
+        rhs = evaluate(p_bin_op.getRightOperand(), operandType);
+        lhs = evaluate(p_bin_op.getLeftOperand(), operandType);
+    } else {
+        lhs = evaluate(p_bin_op.getLeftOperand(), operandType);
+        rhs = evaluate(p_bin_op.getRightOperand(), operandType);
+    }
+
+    IrOp op;
+    switch (p_bin_op.getOperator()) {
+        case OperatorType::PLUS:
+            op = IrOp::ADD;
+            break;
+        case OperatorType::SUBTRACTION:
+            op = IrOp::SUB;
+            break;
+        case OperatorType::MULTIPLICATION:
+            op = IrOp::MUL;
+            break;
+        case OperatorType::DIVISION:
+            op = IrOp::DIV;
+            break;
+        case OperatorType::MOD:
+            op = IrOp::REM;
+            break;
+        case OperatorType::LESS_THAN:
+            op = IrOp::LT;
+            break;
+        case OperatorType::LESS_THAN_OR_EQUAL:
+            op = IrOp::LE;
+            break;
+        case OperatorType::NOT_EQUAL:
+            op = IrOp::NE;
+            break;
+        case OperatorType::GREATER_THAN_OR_EQUAL:
+            op = IrOp::GE;
+            break;
+        case OperatorType::GREATER_THAN:
+            op = IrOp::GT;
+            break;
+        case OperatorType::EQUAL:
+            op = IrOp::EQ;
+            break;
+        case OperatorType::AND:
+            op = IrOp::AND;
+            break;
+        case OperatorType::OR:
+            op = IrOp::OR;
+            break;
+        default:
+            printf("Unknown bin op\n");
+            exit(1);
+    }
+    if (isFloatOperation && (op == IrOp::REM || op == IrOp::AND || op == IrOp::OR)) {
+        printf("Invalid bin op for real type\n");
+        exit(1);
+    }
+
+    // e.g. the index arithmetic of an unrolled body, once the loop variable is a constant
+    IrInstr instr = IrInstr::makeBinary(op, IrValue(), lhs, rhs);
+    m_result = isFloatOperation ? IrValue() : foldConstant(instr);
+    if (!m_result.isNone()) {
+        return;
+    }
+    m_result = m_function->newTemp(getIrTypeOf(p_bin_op.getTypeOfResult()));
+    instr.dst = m_result;
+    emit(std::move(instr));
+}
+
+void IrBuilder::visit(UnaryOperatorNode &p_un_op) {
+    const IrValue operand = evaluate(p_un_op.getOperand());
+
+    IrOp op;
+    switch (p_un_op.getOperator()) {
+        case OperatorType::NEGATION:
+            op = IrOp::NEG;
+            break;
+        case OperatorType::NOT:
+            if (operand.type == IrType::F32) {
+                printf("un op: invalid type for float\n");
+                exit(1);
+            }
+            op = IrOp::NOT;
+            break;
+        default:
+            printf("Unknown un op\n");
+            exit(1);
+    }
+
+    IrInstr instr = IrInstr::makeUnary(op, IrValue(), operand);
+    m_result = foldConstant(instr);
+    if (!m_result.isNone()) {
+        return;
+    }
+    m_result = m_function->newTemp(getIrTypeOf(p_un_op.getTypeOfResult()));
+    instr.dst = m_result;
+    emit(std::move(instr));
+}
+
+void IrBuilder::visit(FunctionInvocationNode &p_func_invocation) {
+    const SymbolEntry *entry = m_symbol_manager.findSymbol(p_func_invocation.getNameCString());
+    const std::vector<Type> &typesOfParam = entry->attribute.typesOfFormalParam;
+
+    std::vector<IrValue> args;
+    for (size_t i = 0; i < typesOfParam.size(); ++i) {
+        args.push_back(
+            evaluate(p_func_invocation.getArguments()[i], getIrTypeOf(typesOfParam[i])));
+    }
+
+    const IrType returnType = getIrTypeOf(entry->type);
+    m_result = (returnType == IrType::VOID) ? IrValue() : m_function->newTemp(returnType);
+    emit(IrInstr::makeCall(m_result, p_func_invocation.getNameCString(), std::move(args)));
+}
+
+void IrBuilder::visit(VariableReferenceNode &p_variable_ref) {
+    const SymbolEntry *entry = m_symbol_manager.findSymbol(p_variable_ref.getNameCString());
+    if (entry == nullptr) {
+        perror("p_variable_ref, no symbol found\n");
+        exit(1);
+    }
+    const auto loopVarValue = m_value_of_loop_var.find(entry);
+    if (loopVarValue != m_value_of_loop_var.end()) {
+        m_result = loopVarValue->second;
+        return;
+    }
+    if (entry->type.arrRefs.empty()) {
+        m_result = m_function->newTemp(getIrTypeOf(entry->type));
+        emit(IrInstr::makeLoad(m_result, getAddressOf(entry)));
+        return;
+    }
+
+    // An array is referred to by its address; an element, by its value.
+    const IrValue address = evaluateAddressOf(p_variable_ref, entry);
+    if (p_variable_ref.getIndices().size() < entry->type.arrRefs.size()) {
+        m_result = address;
+        return;
+    }
+    m_result = m_function->newTemp(getIrTypeOf(p_variable_ref.getTypeOfResult()));
+    IrInstr load = IrInstr::makeLoad(m_result, IrAddress());
+    load.setPointer(address);
+    emit(std::move(load));
+}
+
+void IrBuilder::visit(AssignmentNode &p_assignment) {
+    const SymbolEntry *lvalEntry =
+        m_symbol_manager.findSymbol(p_assignment.getVarRef()->getNameCString());
+    if (lvalEntry == nullptr) {
+        perror("lvalEntry not found\n");
+        exit(1);
+    }
+    noteRegisterNeed(p_assignment, "assignment", p_assignment.getExpression());
+    if (lvalEntry->type.arrRefs.empty()) {
+        const IrValue value =
+            evaluate(p_assignment.getExpression(), getIrTypeOf(lvalEntry->type));
+        emit(IrInstr::makeStore(getAddressOf(lvalEntry), value));
+        return;
+    }
+
+    const IrValue address = evaluateAddressOf(*p_assignment.getVarRef(), lvalEntry);
+    const IrValue value = evaluate(p_assignment.getExpression(),
+                                   getIrTypeOf(p_assignment.getVarRef()->getTypeOfResult()));
+    IrInstr store = IrInstr::makeStore(IrAddress(), value);
+    store.setPointer(address);
+    emit(std::move(store));
+}
+
+void IrBuilder::visit(ReadNode &p_read) {
+    const SymbolEntry *varRefEntry =
+        m_symbol_manager.findSymbol(p_read.getVarRef()->getNameCString());
+    if (varRefEntry == nullptr) {
+        perror("var ref not found IN read node\n");
+        exit(1);
+    }
+    // the address of an element first, as its indices may call functions too
+    IrValue address;
+    if (!varRefEntry->type.arrRefs.empty()) {
+        address = evaluateAddressOf(*const_cast<VariableReferenceNode *>(p_read.getVarRef()),
+                                    varRefEntry);
+    }
+
+    /// NOTE: There is no read string in this hw.
+    const IrType type = getIrTypeOf(p_read.getVarRef()->getTypeOfResult());
+    const IrValue value = m_function->newTemp(type);
+    emit(IrInstr::makeCall(value, (type == IrType::F32) ? "readReal" : "readInt", {}));
+    if (address.isNone()) {
+        emit(IrInstr::makeStore(getAddressOf(varRefEntry), value));
+    } else {
+        IrInstr store = IrInstr::makeStore(IrAddress(), value);
+        store.setPointer(address);
+        emit(std::move(store));
+    }
+}
+
+void IrBuilder::visit(IfNode &p_if) {
+    IrBasicBlock *bodyBlock = m_function->newBlock();
+    IrBasicBlock *elseBlock = p_if.getElseBody() ? m_function->newBlock() : nullptr;
+    IrBasicBlock *nextBlock = m_function->newBlock();
+
+    noteRegisterNeed(p_if, "if", p_if.getCondition());
+    branchOn(p_if.getCondition(), bodyBlock, elseBlock ? elseBlock : nextBlock);
+
+    placeBlock(bodyBlock);
+    p_if.getBody()->accept(*this);
+
+    if (elseBlock) {
+        emit(IrInstr::makeBr(nextBlock));
+        m_block = elseBlock;
+        p_if.getElseBody()->accept(*this);
+    }
+
+    placeBlock(nextBlock);
+}
+
+void IrBuilder::visit(WhileNode &p_while) {
+    IrBasicBlock *conditionBlock = m_function->newBlock();
+    IrBasicBlock *bodyBlock = m_function->newBlock();
+    IrBasicBlock *nextBlock = m_function->newBlock();
+
+    placeBlock(conditionBlock);
+    noteRegisterNeed(p_while, "while", p_while.getCondition());
+    branchOn(p_while.getCondition(), bodyBlock, nextBlock);
+
+    placeBlock(bodyBlock);
+    p_while.getBody()->accept(*this);
+    emit(IrInstr::makeBr(conditionBlock));
+
+    placeBlock(nextBlock);
+}
+
+void IrBuilder::visit(ForNode &p_for) {
+    pushScope(&p_for);
+
+    const_cast<VariableNode *>(p_for.getLoopVar())->accept(*this);
+    const SymbolEntry *loopVarEntry =
+        m_symbol_manager.findSymbol(p_for.getLoopVar()->getNameCString());
+    const IrAddress loopVar = getAddressOf(loopVarEntry);
+
+    // - Init
+    p_for.getInitStmt()->accept(*this);
+
+    if (m_options.optimizationLevel > 0 && m_options.unrollFactor > 1) {
+        const int factor = m_options.unrollFactor;
+        const int64_t tripCount = NodeCounter::getTripCountOf(p_for);
+        NodeCounter body;
+        p_for.getBody()->accept(body);
+        UnrolledLoop loop{m_function->getName(), p_for.getLocation().line, tripCount, 0, 0};
+        if (body.count * tripCount <= kUnrollNodesPerCopy * factor) {
+            fullyUnroll(p_for, loopVarEntry);
+            loop.leftOver = tripCount;
+        } else if (body.count <= kUnrollNodesPerCopy && tripCount >= factor) {
+            partiallyUnroll(p_for, loopVarEntry, factor);
+            loop.copies = factor;
+            loop.leftOver = tripCount % factor;
+        }
+        const bool unrolled = loop.copies != 0 || loop.leftOver != 0;
+        m_unrolled_loops.push_back(std::move(loop));
+        if (unrolled) {
+            popScope(&p_for);
+            return;
+        }
+    }
+
+    // - Condition: loop while loopVar < bound
+    IrBasicBlock *conditionBlock = m_function->newBlock();
+    IrBasicBlock *bodyBlock = m_function->newBlock();
+    IrBasicBlock *nextBlock = m_function->newBlock();
+
+    placeBlock(conditionBlock);
+    const IrValue current = m_function->newTemp(IrType::I32);
+    emit(IrInstr::makeLoad(current, loopVar));
+    const IrValue condition = m_function->newTemp(IrType::I32);
+    emit(IrInstr::makeBinary(IrOp::LT, condition, current,
+                             IrValue::makeInt(p_for.getCondition()->getConstVal().valContainer.integer)));
+    emit(IrInstr::makeCbr(condition, bodyBlock, nextBlock));
+
+    placeBlock(bodyBlock);
+    p_for.getBody()->accept(*this);
+
+    // - Routine
+    const IrValue before = m_function->newTemp(IrType::I32);
+    emit(IrInstr::makeLoad(before, loopVar));
+    const IrValue after = m_function->newTemp(IrType::I32);
+    emit(IrInstr::makeBinary(IrOp::ADD, after, before, IrValue::makeInt(1)));
+    emit(IrInstr::makeStore(loopVar, after));
+    emit(IrInstr::makeBr(conditionBlock));
+
+    placeBlock(nextBlock);
+
+    popScope(&p_for);
+}
+
+void IrBuilder::lowerBodyCopy(ForNode &p_for, const SymbolEntry *loopVarEntry,
+                              const IrValue &value) {
+    m_value_of_loop_var[loopVarEntry] = value;
+    p_for.getBody()->accept(*this);
+    m_value_of_loop_var.erase(loopVarEntry);
+}
+
+void IrBuilder::fullyUnroll(ForNode &p_for, const SymbolEntry *loopVarEntry) {
+    const int32_t lower = p_for.getInitConstVal()->getConstVal().valContainer.integer;
+    const int32_t upper = p_for.getCondition()->getConstVal().valContainer.integer;
+    for (int32_t value = lower; value < upper; ++value) {
+        lowerBodyCopy(p_for, loopVarEntry, IrValue::makeInt(value));
+    }
+}
+
+void IrBuilder::partiallyUnroll(ForNode &p_for, const SymbolEntry *loopVarEntry,
+                                const int factor) {
+    const IrAddress loopVar = getAddressOf(loopVarEntry);
+    const int32_t upper = p_for.getCondition()->getConstVal().valContainer.integer;
+    const int32_t leftOver = NodeCounter::getTripCountOf(p_for) % factor;
+
+    // - Condition: loop while the loop variable has `factor` iterations to go
+    IrBasicBlock *conditionBlock = m_function->newBlock();
+    IrBasicBlock *bodyBlock = m_function->newBlock();
+    IrBasicBlock *nextBlock = m_function->newBlock();
+
+    placeBlock(conditionBlock);
+    const IrValue current = m_function->newTemp(IrType::I32);
+    emit(IrInstr::makeLoad(current, loopVar));
+    const IrValue condition = m_function->newTemp(IrType::I32);
+    emit(IrInstr::makeBinary(IrOp::LT, condition, current, IrValue::makeInt(upper - leftOver)));
+    emit(IrInstr::makeCbr(condition, bodyBlock, nextBlock));
+
+    // - Body: copy i reads the loop variable + i
+    placeBlock(bodyBlock);
+    const IrValue base = m_function->newTemp(IrType::I32, loopVarEntry->name);
+    emit(IrInstr::makeLoad(base, loopVar));
+    for (int copy = 0; copy < factor; ++copy) {
+        IrValue value = base;
+        if (copy != 0) {
+            value = m_function->newTemp(IrType::I32, loopVarEntry->name);
+            emit(IrInstr::makeBinary(IrOp::ADD, value, base, IrValue::makeInt(copy)));
+        }
+        lowerBodyCopy(p_for, loopVarEntry, value);
+    }
+
+    // - Routine
+    const IrValue after = m_function->newTemp(IrType::I32);
+    emit(IrInstr::makeBinary(IrOp::ADD, after, base, IrValue::makeInt(factor)));
+    emit(IrInstr::makeStore(loopVar, after));
+    emit(IrInstr::makeBr(conditionBlock));
+
+    // - The iterations left over, known since the bounds are constants
+    placeBlock(nextBlock);
+    for (int32_t value = upper - leftOver; value < upper; ++value) {
+        lowerBodyCopy(p_for, loopVarEntry, IrValue::makeInt(value));
+    }
+}
+
+void IrBuilder::dumpUnrollReport(FILE *p_out_file) const {
+    fprintf(p_out_file, "for loops (--unroll=%d):\n", m_options.unrollFactor);
+    for (const UnrolledLoop &loop : m_unrolled_loops) {
+        fprintf(p_out_file, "    %-20s line %4u: %lld iterations, ", loop.function.c_str(),
+                loop.line, static_cast<long long>(loop.tripCount));
+        if (loop.copies != 0) {
+            fprintf(p_out_file, "unrolled by %d, %lld left over\n", loop.copies,
+                    static_cast<long long>(loop.leftOver));
+        } else if (loop.leftOver != 0) {
+            fprintf(p_out_file, "fully unrolled\n");
+        } else {
+            fprintf(p_out_file, "not unrolled\n");
+        }
+    }
+}
+
+void IrBuilder::dumpRegisterReport(FILE *p_out_file) const {
+    fprintf(p_out_file, "registers needed per statement (%s):\n",
+            (m_options.optimizationLevel > 0 && m_options.reorderOperands) ? "Sethi-Ullman order"
+                                                                           : "left to right");
+    for (const StatementNeed &need : m_statement_needs) {
+        fprintf(p_out_file, "    %-20s line %4u: %-10s %d", need.function.c_str(), need.line,
+                need.statement, need.registers);
+        if (need.registers != need.registersLeftToRight) {
+            fprintf(p_out_file, " (%d left to right)", need.registersLeftToRight);
+        }
+        fprintf(p_out_file, "\n");
+    }
+}
+
+void IrBuilder::visit(ReturnNode &p_return) {
+    noteRegisterNeed(p_return, "return", p_return.getReturnVal());
+    const IrValue value =
+        evaluate(const_cast<ExpressionNode *>(p_return.getReturnVal()), m_return_type);
+    emit(IrInstr::makeRet(value));
+}
@@ -0,0 +1,98 @@
+#include "ir/IrPasses.hpp"
+
+#include "ir/IR.hpp"
+#include "util/CompilerOptions.hpp"
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+std::vector<int> countUsesOfTemps(const IrFunction &function) {
+    std::vector<int> uses(function.getNumTemps());
+    for (const auto &block : function.getBlocks()) {
+        for (const IrInstr &instr : block->instrs) {
+            for (const IrValue &operand : instr.operands) {
+                if (operand.isTemp()) {
+                    ++uses[operand.temp];
+                }
+            }
+        }
+    }
+    return uses;
+}
+
+std::vector<int> countDefsOfTemps(const IrFunction &function) {
+    std::vector<int> defs(function.getNumTemps());
+    for (const auto &block : function.getBlocks()) {
+        for (const IrInstr &instr : block->instrs) {
+            if (instr.dst.isTemp()) {
+                ++defs[instr.dst.temp];
+            }
+        }
+    }
+    return defs;
+}
+
+void removeDeadInstructions(IrFunction &function) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        const std::vector<int> uses = countUsesOfTemps(function);
+        for (auto &block : function.getBlocks()) {
+            auto &instrs = block->instrs;
+            const auto dead = [&uses](const IrInstr &instr) {
+                const bool selfCopy =
+                    instr.op == IrOp::COPY && instr.operands[0].isSameAs(instr.dst);
+                return instr.isPure() && (selfCopy || uses[instr.dst.temp] == 0);
+            };
+            const auto newEnd = std::remove_if(instrs.begin(), instrs.end(), dead);
+            if (newEnd != instrs.end()) {
+                instrs.erase(newEnd, instrs.end());
+                changed = true;
+            }
+        }
+    }
+}
+
+void runIrPasses(IrModule &module, const CompilerOptions &options) {
+    if (options.optimizationLevel == 0) {
+        return;
+    }
+    const std::unordered_set<std::string> pureBeforeInlining = findPureFunctions(module);
+    for (auto &function : module.functions) {
+        if (options.tailCalls) {
+            eliminateTailRecursion(*function);
+        }
+        promoteLocalSlots(*function, options.buildSsa);
+        propagateCopies(*function);
+        if (options.numberValues) {
+            numberValues(*function, pureBeforeInlining);
+            propagateCopies(*function);
+        }
+        removeDeadInstructions(*function);
+    }
+    inlineCalls(module, options);
+
+    const std::unordered_set<std::string> pure = findPureFunctions(module);
+    if (options.hoistLoopInvariants) {
+        for (auto &function : module.functions) {
+            hoistLoopInvariants(*function, pure);
+        }
+    }
+    // again, over the bodies inlined and the values hoisted into preheaders
+    if (options.numberValues) {
+        for (auto &function : module.functions) {
+            numberValues(*function, pure);
+            propagateCopies(*function);
+            removeDeadInstructions(*function);
+        }
+    }
+    if (options.strengthReduction) {
+        for (auto &function : module.functions) {
+            reduceInductionVariables(*function);
+            propagateCopies(*function);
+            removeDeadInstructions(*function);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#include "ir/Loops.hpp"
+
+#include "ir/Dominators.hpp"
+#include "ir/IR.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+BlockSet getLoopOf(IrBasicBlock *header, const DominatorTree &dom) {
+    BlockSet body{header};
+    std::vector<IrBasicBlock *> worklist;
+    for (IrBasicBlock *pred : header->preds) {
+        if (dom.dominates(header, pred) && body.insert(pred).second) {
+            worklist.push_back(pred);
+        }
+    }
+    while (!worklist.empty()) {
+        IrBasicBlock *block = worklist.back();
+        worklist.pop_back();
+        for (IrBasicBlock *pred : block->preds) {
+            if (body.insert(pred).second) {
+                worklist.push_back(pred);
+            }
+        }
+    }
+    return body;
+}
+
+std::vector<IrBasicBlock *> getLoopHeaders(const IrFunction &function) {
+    const DominatorTree dom(function);
+    std::vector<std::pair<size_t, IrBasicBlock *>> loops;
+    for (IrBasicBlock *block : dom.getReversePostorder()) {
+        const bool isHeader = std::any_of(block->preds.begin(), block->preds.end(),
+                                          [&](const IrBasicBlock *pred) {
+                                              return dom.dominates(block, pred);
+                                          });
+        if (isHeader) {
+            loops.emplace_back(getLoopOf(block, dom).size(), block);
+        }
+    }
+    std::stable_sort(loops.begin(), loops.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+    std::vector<IrBasicBlock *> headers;
+    for (const auto &loop : loops) {
+        headers.push_back(loop.second);
+    }
+    return headers;
+}
+
+IrBasicBlock *getPreheaderOf(IrFunction &function, IrBasicBlock *header, const BlockSet &body) {
+    std::vector<IrBasicBlock *> outsidePreds;
+    for (IrBasicBlock *pred : header->preds) {
+        if (!body.count(pred)) {
+            outsidePreds.push_back(pred);
+        }
+    }
+    auto &blocks = function.getBlocks();
+    const bool isEntry = blocks.front().get() == header;
+    if (!isEntry && outsidePreds.size() == 1 && outsidePreds.front()->succs.size() == 1) {
+        return outsidePreds.front();
+    }
+
+    IrBasicBlock *preheader = function.newBlock();
+    preheader->instrs.push_back(IrInstr::makeBr(header));
+    for (IrBasicBlock *pred : outsidePreds) {
+        IrInstr &term = pred->instrs.back();
+        if (term.target == header) {
+            term.target = preheader;
+        }
+        if (term.target2 == header) {
+            term.target2 = preheader;
+        }
+    }
+    const auto position = std::find_if(blocks.begin(), blocks.end(),
+                                       [header](const auto &b) { return b.get() == header; });
+    std::rotate(position, blocks.end() - 1, blocks.end());
+    function.rebuildCfg();
+    return preheader;
+}
@@ -0,0 +1,287 @@
+#include "ir/Dominators.hpp"
+#include "ir/IR.hpp"
+#include "ir/IrPasses.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+bool isCommutative(const IrOp op) {
+    switch (op) {
+        case IrOp::ADD:
+        case IrOp::MUL:
+        case IrOp::AND:
+        case IrOp::OR:
+        case IrOp::NE:
+        case IrOp::EQ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+class ValueNumberer {
+   public:
+    ValueNumberer(IrFunction &p_function, const std::unordered_set<std::string> &p_pure)
+        : m_pure(p_pure), m_dom(p_function),
+          m_defs(countDefsOfTemps(p_function)), m_version(p_function.getNumTemps()),
+          m_defined(p_function.getNumTemps()) {
+        for (const IrValue &param : p_function.getParams()) {
+            m_defined[param.temp] = true;
+        }
+        for (const auto &block : p_function.getBlocks()) {
+            for (const IrInstr &instr : block->instrs) {
+                if (instr.op == IrOp::ADDR && instr.address.kind == IrAddress::Kind::GLOBAL) {
+                    m_pointed_globals.push_back(getLocationOf(instr));
+                }
+            }
+        }
+    }
+
+    void run() {
+        visit(m_dom.getReversePostorder().front());
+    }
+
+   private:
+    /// @brief A value computed earlier, and whether it still is where it is looked up.
+    struct Available {
+        IrValue value;
+        /// of value, if a temporary, when it was recorded
+        int version;
+    };
+
+    const std::unordered_set<std::string> &m_pure;
+    const DominatorTree m_dom;
+    const std::vector<int> m_defs;
+
+    /// bumped by every assignment to a temporary, so that an expression over its old value no
+    /// longer matches
+    std::vector<int> m_version;
+    /// whether the only assignment to a temporary dominates the instruction being numbered (or
+    /// it is a parameter never assigned); expressions over such temporaries only are available
+    /// in the whole subtree of the dominator tree
+    std::vector<bool> m_defined;
+
+    /// expression => the value it has
+    std::unordered_map<std::string, Available> m_table;
+    /// the expressions recorded, by block being visited, for leaving its subtree
+    std::vector<std::string> m_scoped_keys;
+
+    // - Memory, within a block
+
+    /// bumped by an impure call, which may write anything
+    int m_memory_epoch = 0;
+    /// bumped by any store, which may write what a pointer points to
+    int m_pointer_epoch = 0;
+    /// bumped by a store to a slot/global, or through a pointer to it
+    std::unordered_map<std::string, int> m_epoch_of_location;
+    /// the globals whose address is taken (an array, or one accessed from a preheader, see
+    /// hoistLoopInvariants); a slot only has its address taken if it is an array, which is
+    /// never accessed but through a pointer
+    std::vector<std::string> m_pointed_globals;
+
+    void visit(IrBasicBlock *block);
+
+    /// @return whether `value` is the same wherever the current block dominates
+    bool isStable(const IrValue &value) const {
+        return !value.isTemp() || (m_defs[value.temp] <= 1 && m_defined[value.temp]);
+    }
+    std::string getKeyOf(const IrValue &value) const;
+    std::string getLocationOf(const IrInstr &instr) const;
+    /// @return the key of what a load from the location of `instr` (a load/store) reads
+    std::string getKeyOfLoad(const IrInstr &instr);
+    /// @return the key of the value `instr` computes, or "" if it is not numbered
+    std::string getKeyOfInstr(const IrInstr &instr);
+    /// @return the value recorded for `key`, or none if there is none or it has been assigned
+    IrValue lookUp(const std::string &key) const;
+    void record(const std::string &key, const IrValue &value, bool stable,
+                std::vector<std::string> &localKeys);
+    void noteDef(const IrValue &dst);
+    void noteWrite(const IrInstr &instr);
+};
+
+std::string ValueNumberer::getKeyOf(const IrValue &value) const {
+    char buf[64];
+    switch (value.kind) {
+        case IrValue::Kind::TEMP:
+            snprintf(buf, sizeof(buf), "%%%d.%d", value.temp, m_version[value.temp]);
+            return buf;
+        case IrValue::Kind::INT:
+            snprintf(buf, sizeof(buf), "%d", value.intVal);
+            return buf;
+        case IrValue::Kind::FLOAT:
+            snprintf(buf, sizeof(buf), "%a", value.floatVal);
+            return buf;
+        case IrValue::Kind::STRING:
+            return "\"" + value.strVal + "\"";
+        default:
+            return "_";
+    }
+}
+
+std::string ValueNumberer::getLocationOf(const IrInstr &instr) const {
+    switch (instr.address.kind) {
+        case IrAddress::Kind::SLOT:
+            return "$" + std::to_string(instr.address.slot);
+        case IrAddress::Kind::GLOBAL:
+            return "@" + instr.address.global;
+        default:
+            return "*" + getKeyOf(instr.operands.back());
+    }
+}
+
+std::string ValueNumberer::getKeyOfLoad(const IrInstr &instr) {
+    const std::string location = getLocationOf(instr);
+    const int epoch = (instr.address.kind == IrAddress::Kind::POINTER)
+                          ? m_pointer_epoch
+                          : m_epoch_of_location[location];
+    return "load " + location + " " + std::to_string(epoch) + " " +
+           std::to_string(m_memory_epoch);
+}
+
+std::string ValueNumberer::getKeyOfInstr(const IrInstr &instr) {
+    if (instr.op == IrOp::LOAD) {
+        return getKeyOfLoad(instr);
+    }
+    if (instr.op == IrOp::ADDR) {
+        return "addr " + getLocationOf(instr);
+    }
+    if (!instr.isPure() || instr.op == IrOp::COPY) {
+        return "";
+    }
+
+    IrOp op = instr.op;
+    std::vector<std::string> operands;
+    for (const IrValue &operand : instr.operands) {
+        operands.push_back(getKeyOf(operand));
+    }
+    // a > b is b < a
+    if (op == IrOp::GT || op == IrOp::GE) {
+        op = (op == IrOp::GT) ? IrOp::LT : IrOp::LE;
+        std::swap(operands[0], operands[1]);
+    } else if (isCommutative(op) && operands[1] < operands[0]) {
+        std::swap(operands[0], operands[1]);
+    }
+    std::string key = getIrOpName(op);
+    key += instr.dst.type == IrType::F32 ? ".f" : ".i";
+    for (const std::string &operand : operands) {
+        key += " " + operand;
+    }
+    return key;
+}
+
+IrValue ValueNumberer::lookUp(const std::string &key) const {
+    auto it = m_table.find(key);
+    if (it == m_table.end()) {
+        return IrValue();
+    }
+    const Available &available = it->second;
+    if (available.value.isTemp() && m_version[available.value.temp] != available.version) {
+        return IrValue();
+    }
+    return available.value;
+}
+
+void ValueNumberer::record(const std::string &key, const IrValue &value, const bool stable,
+                           std::vector<std::string> &localKeys) {
+    const int version = value.isTemp() ? m_version[value.temp] : 0;
+    if (!m_table.emplace(key, Available{value, version}).second) {
+        // only a key that no longer holds is recorded again, and it was recorded in this block
+        m_table[key] = Available{value, version};
+        return;
+    }
+    (stable ? m_scoped_keys : localKeys).push_back(key);
+}
+
+void ValueNumberer::noteDef(const IrValue &dst) {
+    if (dst.isTemp()) {
+        ++m_version[dst.temp];
+        m_defined[dst.temp] = true;
+    }
+}
+
+void ValueNumberer::noteWrite(const IrInstr &instr) {
+    if (instr.op == IrOp::CALL) {
+        if (!m_pure.count(instr.callee)) {
+            ++m_memory_epoch;
+        }
+        return;
+    }
+    ++m_pointer_epoch;
+    if (instr.address.kind != IrAddress::Kind::POINTER) {
+        ++m_epoch_of_location[getLocationOf(instr)];
+        return;
+    }
+    for (const std::string &location : m_pointed_globals) {
+        ++m_epoch_of_location[location];
+    }
+}
+
+void ValueNumberer::visit(IrBasicBlock *block) {
+    const size_t scopeStart = m_scoped_keys.size();
+    std::vector<std::string> localKeys;
+    std::vector<int> definedHere;
+
+    for (IrInstr &instr : block->instrs) {
+        if (instr.op == IrOp::STORE || instr.op == IrOp::CALL) {
+            noteWrite(instr);
+            if (instr.op == IrOp::STORE) {
+                // a load right after reads what was stored
+                record(getKeyOfLoad(instr), instr.operands[0], false, localKeys);
+            }
+        }
+        const std::string key = getKeyOfInstr(instr);
+        const IrValue available = key.empty() ? IrValue() : lookUp(key);
+        if (!available.isNone()) {
+            instr = IrInstr::makeUnary(IrOp::COPY, instr.dst, available);
+        }
+
+        const bool operandsStable =
+            instr.op != IrOp::LOAD &&
+            std::all_of(instr.operands.begin(), instr.operands.end(),
+                        [this](const IrValue &operand) { return isStable(operand); });
+        if (instr.dst.isTemp() && m_defs[instr.dst.temp] == 1 && !m_defined[instr.dst.temp]) {
+            definedHere.push_back(instr.dst.temp);
+        }
+        noteDef(instr.dst);
+
+        if (!key.empty() && available.isNone()) {
+            record(key, instr.dst, operandsStable && isStable(instr.dst), localKeys);
+        }
+    }
+
+    // What memory holds, and a temporary assigned more than once, is only known within the block.
+    for (const std::string &key : localKeys) {
+        m_table.erase(key);
+    }
+    m_epoch_of_location.clear();
+    ++m_memory_epoch;
+
+    for (IrBasicBlock *child : m_dom.getChildrenOf(block)) {
+        visit(child);
+    }
+
+    for (size_t i = scopeStart; i < m_scoped_keys.size(); ++i) {
+        m_table.erase(m_scoped_keys[i]);
+    }
+    m_scoped_keys.resize(scopeStart);
+    for (const int temp : definedHere) {
+        m_defined[temp] = false;
+    }
+}
+
+}  // namespace
+
+void numberValues(IrFunction &function, const std::unordered_set<std::string> &pure) {
+    if (function.getBlocks().empty()) {
+        return;
+    }
+    function.rebuildCfg();
+    ValueNumberer(function, pure).run();
+}
@@ -0,0 +1,343 @@
+#include "ir/Dominators.hpp"
+#include "ir/IR.hpp"
+#include "ir/IrPasses.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// @return whether each slot can live in temporaries: a scalar whose address is never taken
+std::vector<bool> findPromotableSlots(const IrFunction &function) {
+    // Only 4-byte slots hold a scalar, and an address is only ever taken of an array (even of
+    // one element).
+    std::vector<bool> addressTaken(function.getNumSlots());
+    for (const auto &block : function.getBlocks()) {
+        for (const IrInstr &instr : block->instrs) {
+            if (instr.op == IrOp::ADDR && instr.address.kind == IrAddress::Kind::SLOT) {
+                addressTaken[instr.address.slot] = true;
+            }
+        }
+    }
+    std::vector<bool> promoted(function.getNumSlots());
+    for (int slot = 0; slot < function.getNumSlots(); ++slot) {
+        promoted[slot] = function.getSlot(slot).size == 4 && !addressTaken[slot];
+    }
+    return promoted;
+}
+
+/// @brief One temporary per slot, assigned by every store (--no-ssa).
+void promoteToTemps(IrFunction &function, const std::vector<bool> &promoted) {
+    std::vector<IrValue> tempOfSlot(function.getNumSlots());
+    for (int slot = 0; slot < function.getNumSlots(); ++slot) {
+        if (promoted[slot]) {
+            const IrSlot &info = function.getSlot(slot);
+            tempOfSlot[slot] = function.newTemp(info.type, info.name);
+        }
+    }
+
+    for (auto &block : function.getBlocks()) {
+        for (IrInstr &instr : block->instrs) {
+            if (instr.address.kind != IrAddress::Kind::SLOT) {
+                continue;
+            }
+            const IrValue &temp = tempOfSlot[instr.address.slot];
+            if (temp.isNone()) {
+                continue;
+            }
+            if (instr.op == IrOp::LOAD) {
+                instr = IrInstr::makeUnary(IrOp::COPY, instr.dst, temp);
+            } else if (instr.op == IrOp::STORE) {
+                instr = IrInstr::makeUnary(IrOp::COPY, temp, instr.operands[0]);
+            }
+        }
+    }
+}
+
+/**
+ * Builds the SSA form of the promoted slots (Cytron et al., "Efficiently Computing Static Single
+ * Assignment Form and the Control Dependence Graph"), then leaves it right away, as the IR has no
+ * phi instruction:
+ *   - a phi is placed in the iterated dominance frontier of the stores to a slot, where the
+ *     slot is live (pruned SSA),
+ *   - the slot is renamed over the dominator tree: a store assigns a new temporary, and a load
+ *     copies the one reaching it,
+ *   - a phi is a temporary assigned by a copy at the end of each predecessor; an edge is split
+ *     for it if the copy would clobber a value still live on another way out of the
+ *     predecessor.
+ */
+class SsaBuilder {
+   public:
+    SsaBuilder(IrFunction &p_function, const std::vector<bool> &p_promoted)
+        : m_function(p_function), m_promoted(p_promoted), m_dom(p_function),
+          m_values(p_function.getNumSlots()), m_undefined(p_function.getNumSlots()) {}
+
+    void run() {
+        placePhis();
+        rename(m_dom.getReversePostorder().front());
+        insertPhiCopies();
+    }
+
+   private:
+    struct Phi {
+        int slot;
+        IrValue temp;
+    };
+    /// @brief `phi = copy value` on the edge from `pred` into the block of `phi`.
+    struct PhiCopy {
+        IrBasicBlock *pred;
+        IrBasicBlock *block;
+        IrValue phi;
+        IrValue value;
+    };
+
+    IrFunction &m_function;
+    const std::vector<bool> &m_promoted;
+    const DominatorTree m_dom;
+    std::unordered_map<const IrBasicBlock *, std::vector<Phi>> m_phis_of_block;
+    /// the values of each slot along the path of the dominator tree being renamed, the
+    /// current one last
+    std::vector<std::vector<IrValue>> m_values;
+    /// of each slot, read where nothing was stored yet
+    std::vector<IrValue> m_undefined;
+    std::vector<PhiCopy> m_phi_copies;
+
+    std::vector<std::vector<bool>> computeLiveIn() const;
+    void placePhis();
+    IrValue getCurrentValueOf(int slot);
+    void rename(IrBasicBlock *block);
+    bool needsSplit(const IrBasicBlock *pred, const IrBasicBlock *block) const;
+    IrBasicBlock *splitEdge(IrBasicBlock *pred, IrBasicBlock *block);
+    void insertPhiCopies();
+};
+
+std::vector<std::vector<bool>> SsaBuilder::computeLiveIn() const {
+    const std::vector<IrBasicBlock *> &rpo = m_dom.getReversePostorder();
+    std::unordered_map<const IrBasicBlock *, size_t> indexOf;
+    for (size_t i = 0; i < rpo.size(); ++i) {
+        indexOf[rpo[i]] = i;
+    }
+    const int numSlots = m_function.getNumSlots();
+    std::vector<std::vector<bool>> upwardUses(rpo.size(), std::vector<bool>(numSlots));
+    std::vector<std::vector<bool>> stores(rpo.size(), std::vector<bool>(numSlots));
+    for (size_t i = 0; i < rpo.size(); ++i) {
+        for (const IrInstr &instr : rpo[i]->instrs) {
+            if (instr.address.kind != IrAddress::Kind::SLOT || !m_promoted[instr.address.slot]) {
+                continue;
+            }
+            const int slot = instr.address.slot;
+            if (instr.op == IrOp::LOAD && !stores[i][slot]) {
+                upwardUses[i][slot] = true;
+            } else if (instr.op == IrOp::STORE) {
+                stores[i][slot] = true;
+            }
+        }
+    }
+
+    std::vector<std::vector<bool>> liveIn = upwardUses;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = rpo.size(); i-- > 0;) {
+            for (const IrBasicBlock *succ : rpo[i]->succs) {
+                const std::vector<bool> &succLiveIn = liveIn[indexOf.at(succ)];
+                for (int slot = 0; slot < numSlots; ++slot) {
+                    if (succLiveIn[slot] && !stores[i][slot] && !liveIn[i][slot]) {
+                        liveIn[i][slot] = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+    return liveIn;
+}
+
+void SsaBuilder::placePhis() {
+    const std::vector<std::vector<bool>> liveIn = computeLiveIn();
+    const std::vector<IrBasicBlock *> &rpo = m_dom.getReversePostorder();
+    std::unordered_map<const IrBasicBlock *, size_t> indexOf;
+    for (size_t i = 0; i < rpo.size(); ++i) {
+        indexOf[rpo[i]] = i;
+    }
+
+    for (int slot = 0; slot < m_function.getNumSlots(); ++slot) {
+        if (!m_promoted[slot]) {
+            continue;
+        }
+        std::vector<IrBasicBlock *> worklist;
+        std::unordered_set<const IrBasicBlock *> assigning;
+        for (IrBasicBlock *block : rpo) {
+            const bool stores =
+                std::any_of(block->instrs.begin(), block->instrs.end(), [slot](const IrInstr &i) {
+                    return i.op == IrOp::STORE && i.address.kind == IrAddress::Kind::SLOT &&
+                           i.address.slot == slot;
+                });
+            if (stores) {
+                worklist.push_back(block);
+                assigning.insert(block);
+            }
+        }
+
+        const IrSlot &info = m_function.getSlot(slot);
+        std::unordered_set<const IrBasicBlock *> hasPhi;
+        while (!worklist.empty()) {
+            const IrBasicBlock *block = worklist.back();
+            worklist.pop_back();
+            for (IrBasicBlock *join : m_dom.getFrontierOf(block)) {
+                if (hasPhi.count(join) || !liveIn[indexOf.at(join)][slot]) {
+                    continue;
+                }
+                hasPhi.insert(join);
+                m_phis_of_block[join].push_back({slot, m_function.newTemp(info.type, info.name)});
+                // a phi assigns the slot too
+                if (assigning.insert(join).second) {
+                    worklist.push_back(join);
+                }
+            }
+        }
+    }
+}
+
+IrValue SsaBuilder::getCurrentValueOf(const int slot) {
+    if (!m_values[slot].empty()) {
+        return m_values[slot].back();
+    }
+    if (m_undefined[slot].isNone()) {
+        const IrSlot &info = m_function.getSlot(slot);
+        m_undefined[slot] = m_function.newTemp(info.type, info.name);
+    }
+    return m_undefined[slot];
+}
+
+void SsaBuilder::rename(IrBasicBlock *block) {
+    std::vector<int> pushed;
+    for (const Phi &phi : m_phis_of_block[block]) {
+        m_values[phi.slot].push_back(phi.temp);
+        pushed.push_back(phi.slot);
+    }
+
+    for (IrInstr &instr : block->instrs) {
+        if (instr.address.kind != IrAddress::Kind::SLOT || !m_promoted[instr.address.slot]) {
+            continue;
+        }
+        const int slot = instr.address.slot;
+        if (instr.op == IrOp::LOAD) {
+            instr = IrInstr::makeUnary(IrOp::COPY, instr.dst, getCurrentValueOf(slot));
+        } else if (instr.op == IrOp::STORE) {
+            const IrSlot &info = m_function.getSlot(slot);
+            const IrValue temp = m_function.newTemp(info.type, info.name);
+            instr = IrInstr::makeUnary(IrOp::COPY, temp, instr.operands[0]);
+            m_values[slot].push_back(temp);
+            pushed.push_back(slot);
+        }
+    }
+
+    std::unordered_set<const IrBasicBlock *> seen;
+    for (IrBasicBlock *succ : block->succs) {
+        if (!seen.insert(succ).second) {
+            continue;
+        }
+        for (const Phi &phi : m_phis_of_block[succ]) {
+            const IrValue value = getCurrentValueOf(phi.slot);
+            // (nothing to copy where the slot is not assigned yet, or is the phi still)
+            if (!value.isSameAs(m_undefined[phi.slot]) && !value.isSameAs(phi.temp)) {
+                m_phi_copies.push_back({block, succ, phi.temp, value});
+            }
+        }
+    }
+
+    for (IrBasicBlock *child : m_dom.getChildrenOf(block)) {
+        rename(child);
+    }
+    for (const int slot : pushed) {
+        m_values[slot].pop_back();
+    }
+}
+
+bool SsaBuilder::needsSplit(const IrBasicBlock *pred, const IrBasicBlock *block) const {
+    // The phi is only live where `block` dominates (a use of it is dominated by the phi), so
+    // the copy only clobbers something on the way into a successor `block` dominates, e.g. out
+    // of a loop from a latch that may also branch back to the header.
+    return std::any_of(pred->succs.begin(), pred->succs.end(), [&](const IrBasicBlock *succ) {
+        return succ != block && m_dom.dominates(block, succ);
+    });
+}
+
+IrBasicBlock *SsaBuilder::splitEdge(IrBasicBlock *pred, IrBasicBlock *block) {
+    IrBasicBlock *middle = m_function.newBlock();
+    middle->instrs.push_back(IrInstr::makeBr(block));
+    IrInstr &term = pred->instrs.back();
+    if (term.target == block) {
+        term.target = middle;
+    }
+    if (term.target2 == block) {
+        term.target2 = middle;
+    }
+    // laid out right after `pred`
+    auto &blocks = m_function.getBlocks();
+    const auto position = std::find_if(blocks.begin(), blocks.end(),
+                                       [pred](const auto &b) { return b.get() == pred; });
+    std::rotate(position + 1, blocks.end() - 1, blocks.end());
+    return middle;
+}
+
+void SsaBuilder::insertPhiCopies() {
+    // the copies of each edge, in the order the edges were renamed
+    std::vector<std::pair<IrBasicBlock *, IrBasicBlock *>> edges;
+    std::unordered_map<IrBasicBlock *, std::unordered_map<IrBasicBlock *, std::vector<PhiCopy>>>
+        copiesOf;
+    for (const PhiCopy &copy : m_phi_copies) {
+        std::vector<PhiCopy> &copies = copiesOf[copy.pred][copy.block];
+        if (copies.empty()) {
+            edges.emplace_back(copy.pred, copy.block);
+        }
+        copies.push_back(copy);
+    }
+
+    for (const auto &edge : edges) {
+        IrBasicBlock *pred = edge.first;
+        IrBasicBlock *block = edge.second;
+        const std::vector<PhiCopy> &copies = copiesOf[pred][block];
+        IrBasicBlock *at = needsSplit(pred, block) ? splitEdge(pred, block) : pred;
+
+        // The copies happen at once: if one reads what another assigns (values swapped in a
+        // loop), all of them go through new temporaries first.
+        const bool overlapping =
+            std::any_of(copies.begin(), copies.end(), [&copies](const PhiCopy &copy) {
+                return std::any_of(copies.begin(), copies.end(), [&copy](const PhiCopy &other) {
+                    return copy.value.isSameAs(other.phi);
+                });
+            });
+        std::vector<IrInstr> instrs;
+        std::vector<IrInstr> finalCopies;
+        for (const PhiCopy &copy : copies) {
+            if (!overlapping) {
+                instrs.push_back(IrInstr::makeUnary(IrOp::COPY, copy.phi, copy.value));
+                continue;
+            }
+            const IrValue temp = m_function.newTemp(copy.phi.type);
+            instrs.push_back(IrInstr::makeUnary(IrOp::COPY, temp, copy.value));
+            finalCopies.push_back(IrInstr::makeUnary(IrOp::COPY, copy.phi, temp));
+        }
+        instrs.insert(instrs.end(), finalCopies.begin(), finalCopies.end());
+        at->instrs.insert(at->instrs.end() - 1, instrs.begin(), instrs.end());
+    }
+    m_function.rebuildCfg();
+}
+
+}  // namespace
+
+void promoteLocalSlots(IrFunction &function, const bool buildSsa) {
+    const std::vector<bool> promoted = findPromotableSlots(function);
+    if (!buildSsa || function.getBlocks().empty()) {
+        promoteToTemps(function, promoted);
+    } else {
+        function.removeUnreachableBlocks();
+        SsaBuilder(function, promoted).run();
+    }
+    function.eraseSlots(promoted);
+}
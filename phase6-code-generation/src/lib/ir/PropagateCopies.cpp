@@ -0,0 +1,106 @@
+#include "ir/IR.hpp"
+#include "ir/IrPasses.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+static bool readsTemp(const IrInstr &instr, const int temp) {
+    return std::any_of(instr.operands.begin(), instr.operands.end(),
+                       [temp](const IrValue &v) { return v.isTemp() && v.temp == temp; });
+}
+
+static bool accessesTemp(const IrInstr &instr, const int temp) {
+    return readsTemp(instr, temp) || (instr.dst.isTemp() && instr.dst.temp == temp);
+}
+
+/// @brief `%t = op ..; ..; %x = copy %t` => `%x = op ..; ..`
+static void coalesceCopies(IrFunction &function) {
+    const std::vector<int> uses = countUsesOfTemps(function);
+    const std::vector<int> defs = countDefsOfTemps(function);
+    std::vector<IrValue> &params = function.getParams();
+
+    for (auto &block : function.getBlocks()) {
+        auto &instrs = block->instrs;
+        for (size_t i = 0; i < instrs.size(); ++i) {
+            const IrInstr &copy = instrs[i];
+            if (copy.op != IrOp::COPY || !copy.operands[0].isTemp()) {
+                continue;
+            }
+            const int src = copy.operands[0].temp;
+            const int dst = copy.dst.temp;
+            if (src == dst || uses[src] != 1) {
+                continue;
+            }
+
+            // A parameter is defined on entry, before the first instruction.
+            auto param = std::find_if(params.begin(), params.end(),
+                                      [src](const IrValue &v) { return v.temp == src; });
+            if (param != params.end()) {
+                const bool isEntry = block.get() == function.getBlocks().front().get();
+                const bool untouched = std::none_of(
+                    instrs.begin(), instrs.begin() + i,
+                    [dst](const IrInstr &instr) { return accessesTemp(instr, dst); });
+                if (defs[src] == 0 && isEntry && untouched) {
+                    *param = copy.dst;
+                    instrs.erase(instrs.begin() + i--);
+                }
+                continue;
+            }
+
+            if (defs[src] != 1) {
+                continue;
+            }
+            for (size_t j = i; j-- > 0;) {
+                IrInstr &def = instrs[j];
+                if (def.dst.isTemp() && def.dst.temp == src) {
+                    def.dst = copy.dst;
+                    instrs.erase(instrs.begin() + i--);
+                    break;
+                }
+                if (accessesTemp(def, dst)) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void propagateCopies(IrFunction &function) {
+    coalesceCopies(function);
+
+    for (auto &block : function.getBlocks()) {
+        // temporary => the value it currently holds a copy of
+        std::unordered_map<int, IrValue> copyOf;
+        for (IrInstr &instr : block->instrs) {
+            for (IrValue &operand : instr.operands) {
+                if (operand.isTemp()) {
+                    auto it = copyOf.find(operand.temp);
+                    if (it != copyOf.end()) {
+                        operand = it->second;
+                    }
+                }
+            }
+            if (!instr.dst.isTemp()) {
+                continue;
+            }
+            const IrValue folded = foldConstant(instr);
+            if (!folded.isNone()) {
+                instr = IrInstr::makeUnary(IrOp::COPY, instr.dst, folded);
+            }
+
+            const int dst = instr.dst.temp;
+            copyOf.erase(dst);
+            for (auto it = copyOf.begin(); it != copyOf.end();) {
+                if (it->second.isTemp() && it->second.temp == dst) {
+                    it = copyOf.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (instr.op == IrOp::COPY && !instr.operands[0].isSameAs(instr.dst)) {
+                copyOf[dst] = instr.operands[0];
+            }
+        }
+    }
+}
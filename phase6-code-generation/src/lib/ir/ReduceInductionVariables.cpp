@@ -0,0 +1,252 @@
+#include "ir/Dominators.hpp"
+#include "ir/IR.hpp"
+#include "ir/IrPasses.hpp"
+#include "ir/Loops.hpp"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// @return a * b, wrapping around at 32 bits as the generated `mul` does
+int32_t multiplyWrapping(const int32_t a, const int32_t b) {
+    return static_cast<int32_t>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
+}
+
+/// a temporary that is `scale * iv + (invariants)` wherever it is defined in the loop
+struct DerivedValue {
+    int iv;
+    int32_t scale;
+    IrInstr def;
+    const IrBasicBlock *block;
+    size_t index;
+};
+
+class InductionVariableReducer {
+   public:
+    explicit InductionVariableReducer(IrFunction &p_function) : m_function(p_function) {}
+
+    void run(IrBasicBlock *header);
+
+   private:
+    IrFunction &m_function;
+
+    /// the temporaries whose every assignment in the loop is `%i = add/sub %i, <constant>`
+    std::unordered_set<int> m_basic;
+    std::map<int, DerivedValue> m_derived;
+
+    void findDerivedValues(const std::vector<IrBasicBlock *> &bodyInOrder,
+                           const std::vector<int> &defsInLoop);
+    /// @return a copy of the computation of `value` out of its induction variable and invariants
+    IrValue cloneInto(std::vector<IrInstr> &instrs, const IrValue &value);
+};
+
+void InductionVariableReducer::findDerivedValues(const std::vector<IrBasicBlock *> &bodyInOrder,
+                                                 const std::vector<int> &defsInLoop) {
+    const std::vector<int> defs = countDefsOfTemps(m_function);
+    auto isInvariant = [&defsInLoop](const IrValue &value) {
+        return !value.isTemp() || defsInLoop[value.temp] == 0;
+    };
+    // A derived operand must be computed earlier in the same block, with no step of its
+    // induction variable in between: it is `scale * iv + ..` for the value iv had back then.
+    auto isComputedBefore = [](const DerivedValue &operand, const IrBasicBlock *block,
+                               const size_t index) {
+        if (operand.block != block || operand.index >= index) {
+            return false;
+        }
+        for (size_t i = operand.index + 1; i < index; ++i) {
+            const IrValue &dst = block->instrs[i].dst;
+            if (dst.isTemp() && dst.temp == operand.iv) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (IrBasicBlock *block : bodyInOrder) {
+            for (size_t i = 0; i < block->instrs.size(); ++i) {
+                const IrInstr &instr = block->instrs[i];
+                if ((instr.op != IrOp::ADD && instr.op != IrOp::MUL) || !instr.dst.isTemp() ||
+                    defs[instr.dst.temp] != 1 || m_basic.count(instr.dst.temp) ||
+                    m_derived.count(instr.dst.temp)) {
+                    continue;
+                }
+                for (int k = 0; k < 2; ++k) {
+                    const IrValue &x = instr.operands[k];
+                    const IrValue &y = instr.operands[1 - k];
+                    if (!x.isTemp()) {
+                        continue;
+                    }
+                    DerivedValue value{x.temp, 1, instr, block, i};
+                    if (!m_basic.count(x.temp)) {
+                        const auto operand = m_derived.find(x.temp);
+                        if (operand == m_derived.end() ||
+                            !isComputedBefore(operand->second, block, i)) {
+                            continue;
+                        }
+                        value.iv = operand->second.iv;
+                        value.scale = operand->second.scale;
+                    }
+                    if (instr.op == IrOp::MUL) {
+                        if (y.kind != IrValue::Kind::INT) {
+                            continue;
+                        }
+                        value.scale = multiplyWrapping(value.scale, y.intVal);
+                    } else if (!isInvariant(y)) {
+                        continue;
+                    }
+                    m_derived.emplace(instr.dst.temp, std::move(value));
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+IrValue InductionVariableReducer::cloneInto(std::vector<IrInstr> &instrs, const IrValue &value) {
+    if (!value.isTemp() || !m_derived.count(value.temp)) {
+        return value;
+    }
+    IrInstr clone = m_derived.at(value.temp).def;
+    for (IrValue &operand : clone.operands) {
+        operand = cloneInto(instrs, operand);
+    }
+    // e.g. `mul 0, 4` for the address a[i] when i starts at 0
+    const IrValue folded = foldConstant(clone);
+    if (!folded.isNone()) {
+        return folded;
+    }
+    clone.dst = m_function.newTemp(clone.dst.type);
+    instrs.push_back(clone);
+    return clone.dst;
+}
+
+void InductionVariableReducer::run(IrBasicBlock *header) {
+    m_function.rebuildCfg();
+    BlockSet body;
+    std::vector<IrBasicBlock *> bodyInOrder;
+    std::vector<int> defsInLoop(m_function.getNumTemps(), 0);
+    {
+        const DominatorTree dom(m_function);
+        body = getLoopOf(header, dom);
+        for (const auto &block : m_function.getBlocks()) {
+            if (body.count(block.get())) {
+                bodyInOrder.push_back(block.get());
+            }
+        }
+
+        // - Basic induction variables
+        std::unordered_set<int> others;
+        for (IrBasicBlock *block : bodyInOrder) {
+            for (const IrInstr &instr : block->instrs) {
+                if (!instr.dst.isTemp()) {
+                    continue;
+                }
+                ++defsInLoop[instr.dst.temp];
+                const bool isStep = (instr.op == IrOp::ADD || instr.op == IrOp::SUB) &&
+                                    instr.dst.type == IrType::I32 &&
+                                    instr.operands[0].isSameAs(instr.dst) &&
+                                    instr.operands[1].kind == IrValue::Kind::INT;
+                if (!isStep) {
+                    others.insert(instr.dst.temp);
+                }
+            }
+        }
+        for (int temp = 0; temp < m_function.getNumTemps(); ++temp) {
+            if (defsInLoop[temp] > 0 && !others.count(temp)) {
+                m_basic.insert(temp);
+            }
+        }
+        if (m_basic.empty()) {
+            return;
+        }
+
+        findDerivedValues(bodyInOrder, defsInLoop);
+    }
+
+    // - The derived values used by anything but another derived value: each gets a temporary
+    //   of its own, stepped along with its induction variable
+
+    std::set<int> roots;
+    for (const auto &block : m_function.getBlocks()) {
+        for (const IrInstr &instr : block->instrs) {
+            // (a derived value has no other definition)
+            if (instr.dst.isTemp() && m_derived.count(instr.dst.temp)) {
+                continue;
+            }
+            for (const IrValue &operand : instr.operands) {
+                // a multiple of 1 costs no more to compute than to step
+                if (operand.isTemp() && m_derived.count(operand.temp) &&
+                    m_derived.at(operand.temp).scale != 1) {
+                    roots.insert(operand.temp);
+                }
+            }
+        }
+    }
+    if (roots.empty()) {
+        return;
+    }
+
+    IrBasicBlock *preheader = getPreheaderOf(m_function, header, body);
+    std::vector<IrInstr> init;
+    std::unordered_map<int, IrValue> reducedOf;
+    std::unordered_map<int, std::vector<int>> rootsOfIv;
+    for (const int root : roots) {
+        IrValue reduced = cloneInto(init, m_derived.at(root).def.dst);
+        if (!reduced.isTemp()) {
+            // stepped in the loop, so it starts as a copy of its folded value
+            const IrValue temp = m_function.newTemp(m_derived.at(root).def.dst.type);
+            init.push_back(IrInstr::makeUnary(IrOp::COPY, temp, reduced));
+            reduced = temp;
+        }
+        reducedOf[root] = reduced;
+        rootsOfIv[m_derived.at(root).iv].push_back(root);
+    }
+    auto &preheaderInstrs = preheader->instrs;
+    preheaderInstrs.insert(preheaderInstrs.end() - 1, init.begin(), init.end());
+
+    for (IrBasicBlock *block : bodyInOrder) {
+        std::vector<IrInstr> instrs;
+        for (IrInstr &instr : block->instrs) {
+            const IrValue dst = instr.dst;
+            if (dst.isTemp() && reducedOf.count(dst.temp)) {
+                instrs.push_back(IrInstr::makeUnary(IrOp::COPY, dst, reducedOf.at(dst.temp)));
+            } else {
+                instrs.push_back(std::move(instr));
+            }
+            if (!dst.isTemp() || !rootsOfIv.count(dst.temp)) {
+                continue;
+            }
+            const IrInstr &step = instrs.back();
+            const int32_t by = multiplyWrapping(step.operands[1].intVal,
+                                                (step.op == IrOp::SUB) ? -1 : 1);
+            for (const int root : rootsOfIv.at(dst.temp)) {
+                const IrValue &reduced = reducedOf.at(root);
+                const int32_t stride = multiplyWrapping(by, m_derived.at(root).scale);
+                instrs.push_back(
+                    IrInstr::makeBinary(IrOp::ADD, reduced, reduced, IrValue::makeInt(stride)));
+            }
+        }
+        block->instrs = std::move(instrs);
+    }
+}
+
+}  // namespace
+
+void reduceInductionVariables(IrFunction &function) {
+    function.rebuildCfg();
+    // Inner loops first: what they set up in their preheader may be reduced by the outer loop.
+    for (IrBasicBlock *header : getLoopHeaders(function)) {
+        InductionVariableReducer(function).run(header);
+    }
+    function.rebuildCfg();
+}
@@ -2,6 +2,7 @@
 #include "sema/SemanticAnalyzer.hpp"
 #include "visitor/AstNodeInclude.hpp"
 #include <memory>
+#include <utility>
 
 /* ---- debug ---- */
 
@@ -11,6 +12,31 @@ void debug_print(const char *s) {
     }
 }
 
+/* ---- frames ---- */
+
+void SemanticAnalyzer::recordFrame(const char *name, SymbolTable &table) {
+    const SymbolManager::LocalSlots &slots = m_symbolManager.listOfLocalSlots.back();
+    // ra and s0 are saved at s0 - 4 and s0 - 8, then come the scalars, then the arrays, each
+    // with its element 0 at its lowest address
+    const int topOfArrays = slots.lowestAddrOfNext + 4;
+    for (const auto &array : slots.arrays) {
+        array.table->entries[array.index].addrOfLocal = topOfArrays - array.depth;
+    }
+    table.sizeOfLocals = slots.deepestArrays - topOfArrays;
+    table.sizeOfLocalsWithoutReuse = 8 + slots.sizeOfAllSlots;
+    m_frames.push_back({name, table.sizeOfLocals, table.sizeOfLocalsWithoutReuse});
+}
+
+void SemanticAnalyzer::dumpFrameReport(FILE *p_out_file) const {
+    auto roundUp = [](const int size) { return (size + 15) / 16 * 16; };
+    fprintf(p_out_file, "frames (bytes below s0 without -> with slot reuse):\n");
+    for (const FrameOfFunction &frame : m_frames) {
+        fprintf(p_out_file, "    %-20s %4d -> %4d (frame %d -> %d)\n", frame.name.c_str(),
+                frame.sizeOfLocalsWithoutReuse, frame.sizeOfLocals,
+                roundUp(frame.sizeOfLocalsWithoutReuse), roundUp(frame.sizeOfLocals));
+    }
+}
+
 void SemanticAnalyzer::visit(ProgramNode &p_program) {
     debug_print("program");
 
@@ -188,7 +214,7 @@ void SemanticAnalyzer::visit(FunctionNode &p_function) {
      * Whether a program/function is redeclared does not affect the return type of this scope
      */
     m_symbolManager.returnTypes.push(p_function.getReturnType());
-    m_symbolManager.listOfAddrOfNextLocal.emplace_back(-12);  // s0 - 12 is the addr of first var
+    m_symbolManager.listOfLocalSlots.emplace_back();
 
     /* Step 3: Traverse child nodes */
     p_function.visitChildNodes(*this);
@@ -210,10 +236,12 @@ void SemanticAnalyzer::visit(FunctionNode &p_function) {
      * store table to m_symbol_table_of_scoping_nodes 
      * for codegen
      */
-    m_symbol_table_of_scoping_nodes[&p_function] = m_symbolManager.popScope();
+    SymbolManager::Table table = m_symbolManager.popScope();
+    recordFrame(p_function.getNameCString(), *table);
+    m_symbol_table_of_scoping_nodes[&p_function] = std::move(table);
     m_symbolManager.upperIsFunction = false;
     m_symbolManager.returnTypes.pop();
-    m_symbolManager.listOfAddrOfNextLocal.pop_back();
+    m_symbolManager.listOfLocalSlots.pop_back();
 }
 
 void SemanticAnalyzer::visit(CompoundStatementNode &p_compound_statement) {
@@ -223,11 +251,14 @@ void SemanticAnalyzer::visit(CompoundStatementNode &p_compound_statement) {
 
     /* Step 2: New symbol table */
 
-    if (m_symbolManager.currlvl == 0) {
+    const bool isMain = m_symbolManager.currlvl == 0;
+    if (isMain) {
         // this compound stmt is main() (serve as main() in C language)
-        m_symbolManager.listOfAddrOfNextLocal.emplace_back(
-            -12);  // s0 - 12 is the addr of first var
+        m_symbolManager.listOfLocalSlots.emplace_back();
     }
+    // the slots (and arrays) of this scope are free again once it is left
+    const int addrOfNextLocal = m_symbolManager.listOfLocalSlots.back().addrOfNext;
+    const int depthOfArrays = m_symbolManager.listOfLocalSlots.back().depthOfArrays;
 
     const bool upperIsFunction = m_symbolManager.upperIsFunction;
     if (upperIsFunction) {
@@ -249,11 +280,16 @@ void SemanticAnalyzer::visit(CompoundStatementNode &p_compound_statement) {
         /**
      * hw5 mod:
      */
-        m_symbol_table_of_scoping_nodes[&p_compound_statement] = m_symbolManager.popScope();
-        if (m_symbolManager.currlvl == 0) {
+        SymbolManager::Table table = m_symbolManager.popScope();
+        if (isMain) {
             // this compound stmt is main() (serve as main() in C language)
-            m_symbolManager.listOfAddrOfNextLocal.pop_back();
+            recordFrame("main", *table);
+            m_symbolManager.listOfLocalSlots.pop_back();
+        } else {
+            m_symbolManager.listOfLocalSlots.back().addrOfNext = addrOfNextLocal;
+            m_symbolManager.listOfLocalSlots.back().depthOfArrays = depthOfArrays;
         }
+        m_symbol_table_of_scoping_nodes[&p_compound_statement] = std::move(table);
     }
 }
 
@@ -548,6 +584,11 @@ void SemanticAnalyzer::visit(VariableReferenceNode &p_variable_ref) {
         int numOfDimToRemove = p_variable_ref.getIndices().size();
         t.arrRefs.erase(t.arrRefs.begin(), t.arrRefs.begin() + numOfDimToRemove);
         p_variable_ref.setTypeOfResult(t);
+
+        // for ConstantFolder to put the value in place of the reference
+        if (entryOfVarDecl->kind == KindOfSymbol::CONSTANT) {
+            p_variable_ref.setConstant(entryOfVarDecl->attribute.constVal);
+        }
     }
 
     /* Step 5: Pop the symbol table(in step 2) */
@@ -710,6 +751,9 @@ void SemanticAnalyzer::visit(ForNode &p_for) {
      */
     m_symbolManager.pushScope(std::make_unique<SymbolTable>());
     m_symbolManager.inLoopInit = true;
+    // the slots of the loop variable and the body are free again after the loop
+    const int addrOfNextLocal = m_symbolManager.listOfLocalSlots.back().addrOfNext;
+    const int depthOfArrays = m_symbolManager.listOfLocalSlots.back().depthOfArrays;
 
     /* Step 3: Traverse child nodes */
     p_for.visitChildNodes(*this);
@@ -732,6 +776,8 @@ void SemanticAnalyzer::visit(ForNode &p_for) {
      * hw5 mod:
      */
     m_symbol_table_of_scoping_nodes[&p_for] = m_symbolManager.popScope();
+    m_symbolManager.listOfLocalSlots.back().addrOfNext = addrOfNextLocal;
+    m_symbolManager.listOfLocalSlots.back().depthOfArrays = depthOfArrays;
 }
 
 void SemanticAnalyzer::visit(ReturnNode &p_return) {
@@ -1,4 +1,5 @@
 #include "sema/SymbolTable.hpp"
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <sstream>
@@ -158,14 +159,28 @@ void SymbolManager::pushEntry(const char *name, KindOfSymbol kind, Type type) {
     if (currlvl == 0) {   // global
         addrOfLocal = 0;  // 0: n/a
     } else {              // local
-        if (listOfAddrOfNextLocal.empty()) {
-            perror("listOfAddrOfNextLocal.empty() in pushEntry()\n");
+        if (listOfLocalSlots.empty()) {
+            perror("listOfLocalSlots.empty() in pushEntry()\n");
             exit(1);
         }
-        addrOfLocal = listOfAddrOfNextLocal.back();
-        listOfAddrOfNextLocal.back() -= 4;  // for now, all is int
+        LocalSlots &slots = listOfLocalSlots.back();
+        if (!type.arrRefs.empty() && kind != KindOfSymbol::PARAMETER) {
+            addrOfLocal = 0;  // set once all slots are handed out
+            slots.depthOfArrays += type.getSizeInBytes();
+            slots.deepestArrays = std::max(slots.deepestArrays, slots.depthOfArrays);
+            slots.sizeOfAllSlots += type.getSizeInBytes();
+            slots.arrays.push_back(
+                {tables.back().get(), tables.back()->entries.size(), slots.depthOfArrays});
+        } else {
+            addrOfLocal = slots.addrOfNext;
+            slots.addrOfNext -= 4;  // a scalar, or the address of an array parameter
+            slots.lowestAddrOfNext = std::min(slots.lowestAddrOfNext, slots.addrOfNext);
+            slots.sizeOfAllSlots += 4;
+        }
     }
     tables.back()->entries.emplace_back(name, kind, currlvl, type, addrOfLocal);
+    tables.back()->entries.back().isAlias =
+        kind == KindOfSymbol::PARAMETER && !type.arrRefs.empty();
 }
 // for constant
 void SymbolManager::pushEntry(const char *name, KindOfSymbol kind, Type type, ConstVal p_constVal) {
@@ -3,6 +3,8 @@
     /* C declarations and includes */
 %{
 #include "AST/AstDumper.hpp"    //      /// visitor pattern
+#include "AST/ConstantFolder.hpp"
+#include "AST/DeadCodeEliminator.hpp"
 #include "AST/BinaryOperator.hpp"
 #include "AST/CompoundStatement.hpp"
 #include "AST/ConstantValue.hpp"
@@ -27,11 +29,17 @@
 #include "sema/SemanticAnalyzer.hpp"
 
 #include "codegen/CodeGenerator.hpp"
+#include "codegen/PeepholeOptimizer.hpp"
+#include "codegen/RegisterCodeGenerator.hpp"
+#include "ir/IrBuilder.hpp"
+#include "ir/IrPasses.hpp"
+#include "util/CompilerOptions.hpp"
 
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <vector>
 
 #define YYLTYPE yyltype
@@ -925,10 +933,65 @@ void yyerror(const char *msg) {
 
 int main(int argc, const char *argv[]) {
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <filename> --save-path [save path]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <filename> [--dump-ast] [--emit-ir] [-O0|-O1] [--no-fold] [--no-dce] [--peephole] [--frame-report] [--omit-frame-pointer] [--inline-budget=N] [--no-tail-calls] [--no-strength-reduction] [--no-licm] [--no-cse] [--no-ssa] [--no-loop-registers] [--no-register-args] [--no-reorder] [--unroll=N] [--unroll-report] [--register-report] --save-path [save path]\n", argv[0]);
         exit(-1);
     }
 
+    CompilerOptions options;
+    bool dump_ast = false;
+    const char *save_path = "";
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--dump-ast") == 0) {
+            dump_ast = true;
+        } else if (strcmp(argv[i], "--emit-ir") == 0) {
+            options.emitIr = true;
+        } else if ((strcmp(argv[i], "--save-path") == 0 || strcmp(argv[i], "--save_path") == 0) &&
+                   i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--omit-frame-pointer") == 0) {
+            options.omitFramePointer = true;
+        } else if (strncmp(argv[i], "--inline-budget=", strlen("--inline-budget=")) == 0) {
+            options.inlineBudget = atoi(argv[i] + strlen("--inline-budget="));
+        } else if (strcmp(argv[i], "--no-tail-calls") == 0) {
+            options.tailCalls = false;
+        } else if (strcmp(argv[i], "--no-strength-reduction") == 0) {
+            options.strengthReduction = false;
+        } else if (strcmp(argv[i], "--no-licm") == 0) {
+            options.hoistLoopInvariants = false;
+        } else if (strcmp(argv[i], "--no-cse") == 0) {
+            options.numberValues = false;
+        } else if (strcmp(argv[i], "--no-ssa") == 0) {
+            options.buildSsa = false;
+        } else if (strcmp(argv[i], "--no-loop-registers") == 0) {
+            options.loopCounterRegisters = false;
+        } else if (strcmp(argv[i], "--no-register-args") == 0) {
+            options.registerArguments = false;
+        } else if (strcmp(argv[i], "--no-reorder") == 0) {
+            options.reorderOperands = false;
+        } else if (strcmp(argv[i], "--register-report") == 0) {
+            options.registerReport = true;
+        } else if (strncmp(argv[i], "--unroll=", strlen("--unroll=")) == 0) {
+            options.unrollFactor = atoi(argv[i] + strlen("--unroll="));
+        } else if (strcmp(argv[i], "--unroll-report") == 0) {
+            options.unrollReport = true;
+        } else if (strcmp(argv[i], "--frame-report") == 0) {
+            options.frameReport = true;
+        } else if (strcmp(argv[i], "--no-fold") == 0) {
+            options.foldConstants = false;
+        } else if (strcmp(argv[i], "--no-dce") == 0) {
+            options.eliminateDeadCode = false;
+        } else if (strcmp(argv[i], "--peephole") == 0) {
+            options.peephole = true;
+        } else if (strcmp(argv[i], "-O0") == 0) {
+            options.optimizationLevel = 0;
+        } else if (strcmp(argv[i], "-O1") == 0) {
+            options.optimizationLevel = 1;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            exit(-1);
+        }
+    }
+
     yyin = fopen(argv[1], "r");
     if (yyin == NULL) {
         perror("fopen() failed");
@@ -937,7 +1000,7 @@ int main(int argc, const char *argv[]) {
 
     yyparse();
 
-    if (argc >= 3 && strcmp(argv[2], "--dump-ast") == 0) {
+    if (dump_ast) {
         ///
         AstDumper ast_dumper;
         root->accept(ast_dumper);
@@ -955,10 +1018,51 @@ int main(int argc, const char *argv[]) {
             "|  There is no syntactic error and semantic error!  |\n"
             "|---------------------------------------------------|\n");
 
-        CodeGenerator code_generator(
-            argv[1], (argc == 4) ? argv[3] : "",
-            std::move(sema_analyzer.acquireSymbolTableOfScopingNodes()));
-        root->accept(code_generator);
+        if (options.frameReport) {
+            sema_analyzer.dumpFrameReport(stdout);
+        }
+        auto symbol_tables = std::move(sema_analyzer.acquireSymbolTableOfScopingNodes());
+
+        if (options.foldConstants) {
+            ConstantFolder constant_folder;
+            root->accept(constant_folder);
+        }
+        if (options.eliminateDeadCode) {
+            DeadCodeEliminator dead_code_eliminator(symbol_tables);
+            root->accept(dead_code_eliminator);
+        }
+
+        std::unique_ptr<IrModule> ir_module;
+        if (options.optimizationLevel > 0 || options.emitIr) {
+            IrBuilder ir_builder(argv[1], symbol_tables, options);
+            root->accept(ir_builder);
+            if (options.unrollReport) {
+                ir_builder.dumpUnrollReport(stdout);
+            }
+            if (options.registerReport) {
+                ir_builder.dumpRegisterReport(stdout);
+            }
+            ir_module = ir_builder.takeModule();
+            runIrPasses(*ir_module, options);
+            if (options.emitIr) {
+                ir_module->dump(stdout);
+            }
+        }
+
+        if (options.optimizationLevel == 0) {
+            CodeGenerator code_generator(argv[1], save_path, std::move(symbol_tables), options);
+            root->accept(code_generator);
+        } else {
+            RegisterCodeGenerator code_generator(argv[1], save_path, *ir_module, options);
+            code_generator.generate();
+        }
+
+        // the generators above have closed the assembly file
+        if (options.peephole) {
+            PeepholeOptimizer peephole_optimizer;
+            peephole_optimizer.run(getAssemblyFilePath(argv[1], save_path));
+            peephole_optimizer.dumpCounters(stdout);
+        }
     }
 
     delete root;
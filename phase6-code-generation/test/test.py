@@ -60,6 +60,30 @@ class Grader:
         "18": TestCase(CaseType.BONUS, 1.5, "18_bonus_string"),
         "19": TestCase(CaseType.BONUS, 1.5, "19_bonus_real_1"),
         "20": TestCase(CaseType.BONUS, 1.5, "20_bonus_real_2"),
+        "21": TestCase(CaseType.OPEN, 0.0, "21_register_pressure"),
+        "22": TestCase(CaseType.OPEN, 0.0, "22_constant_folding"),
+        "23": TestCase(CaseType.OPEN, 0.0, "23_large_frame"),
+        "24": TestCase(CaseType.OPEN, 0.0, "24_slot_reuse"),
+        "25": TestCase(CaseType.OPEN, 0.0, "25_leaf_function"),
+        "26": TestCase(CaseType.OPEN, 0.0, "26_inline"),
+        "27": TestCase(CaseType.OPEN, 0.0, "27_tail_call"),
+        "28": TestCase(CaseType.OPEN, 0.0, "28_strength_reduction"),
+        "29": TestCase(CaseType.OPEN, 0.0, "29_compare_branch"),
+        "30": TestCase(CaseType.OPEN, 0.0, "30_short_circuit"),
+        "31": TestCase(CaseType.OPEN, 0.0, "31_loop_invariant"),
+        "32": TestCase(CaseType.OPEN, 0.0, "32_loop_counter"),
+        "33": TestCase(CaseType.OPEN, 0.0, "33_unroll"),
+        "34": TestCase(CaseType.OPEN, 0.0, "34_array"),
+        "35": TestCase(CaseType.OPEN, 0.0, "35_array_param"),
+        "36": TestCase(CaseType.OPEN, 0.0, "36_constant_pool"),
+        "37": TestCase(CaseType.OPEN, 0.0, "37_constants"),
+        "38": TestCase(CaseType.OPEN, 0.0, "38_dead_code"),
+        "39": TestCase(CaseType.OPEN, 0.0, "39_register_args"),
+        "40": TestCase(CaseType.OPEN, 0.0, "40_sethi_ullman"),
+        "41": TestCase(CaseType.OPEN, 0.0, "41_tree_patterns"),
+        "42": TestCase(CaseType.OPEN, 0.0, "42_value_numbering"),
+        "43": TestCase(CaseType.OPEN, 0.0, "43_ssa_locals"),
+        "44": TestCase(CaseType.OPEN, 0.0, "44_induction_order"),
         "h1": TestCase(CaseType.HIDDEN, 5.0, "h01_variable_constant"),
         "h2": TestCase(CaseType.HIDDEN, 5.0, "h02_expr"),
         "h3": TestCase(CaseType.HIDDEN, 5.0, "h03_function"),
@@ -84,9 +108,10 @@ class Grader:
         # "my1": TestCase(CaseType.OPEN, 0.0, "my_test_case_1"),
     }
 
-    def __init__(self, executable: Path, io_file_path: Path) -> None:
+    def __init__(self, executable: Path, io_file_path: Path, compiler_flags: List[str]) -> None:
         self.executable: Path = executable
         self.io_file_path = io_file_path
+        self.compiler_flags: List[str] = compiler_flags
         self.cases_to_run: list[TestCase] = list(self.CASES.values())
         self.diff_result: str = ""
         self.case_dir: Path = DIR / "test_cases"
@@ -162,7 +187,7 @@ class Grader:
             return TestStatus.SKIP
 
         # Compile to risc-v
-        compile_command: List[str] = [str(self.executable), str(case_path), "--save-path", str(self.asm_dir)]
+        compile_command: List[str] = [str(self.executable), str(case_path), "--save-path", str(self.asm_dir), *self.compiler_flags]
         compile_stdout: bytes
         compile_stderr: bytes
         _, compile_stdout, compile_stderr = self.execute_process(compile_command)
@@ -263,9 +288,10 @@ def main() -> int:
     parser.add_argument("--executable", help="executable to grade", type=Path, default=DIR.parent / "src" / "compiler")
     parser.add_argument("--io_file", help="IO file for io function", type=Path, default=DIR.parent / "test" / "io.c")
     parser.add_argument("--case_id", help="test case's ID", type=str)
+    parser.add_argument("--compiler_flags", help="extra flags passed to the compiler, e.g. \"-O1\"", type=str, default="")
     args = parser.parse_args()
 
-    grader = Grader(args.executable, args.io_file)
+    grader = Grader(args.executable, args.io_file, args.compiler_flags.split())
     if args.case_id is not None:
         grader.set_case_id_to_run(args.case_id)
     return grader.run()
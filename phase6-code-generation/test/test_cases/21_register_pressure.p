@@ -0,0 +1,82 @@
+//&S-
+//&T-
+//&D-
+
+registerPressure;
+
+var g : integer;
+var gr : real;
+
+fib(n: integer): integer
+begin
+    if (n < 2) then
+    begin
+        return n;
+    end
+    end if
+    return fib(n - 1) + fib(n - 2);
+end
+end
+
+// more arguments than argument registers, for both integers and reals
+mix(a, b, c, d, e, f, g2, h, i, j: integer; x1, x2, x3, x4, x5, x6, x7, x8, x9, x10: real): real
+begin
+    var s : real;
+    s := x1 + x2 + x3 + x4 + x5 + x6 + x7 + x8 + x9 + x10;
+    s := s + a * 1000 + b * 100 + c * 10 + d + e + f + g2 + h + i + j;
+    return s;
+end
+end
+
+// more live values across a call than callee-saved registers
+many(): integer
+begin
+    var a, b, c, d, e, f, h, i, j, k, l, m, n, o, p, q: integer;
+    a := 1; b := 2; c := 3; d := 4; e := 5; f := 6; h := 7; i := 8;
+    j := 9; k := 10; l := 11; m := 12; n := 13; o := 14; p := 15; q := 16;
+    print fib(5);
+    print a + b + c + d + e + f + h + i + j + k + l + m + n + o + p + q;
+    print ((a + (b * (c + (d * (e + (f * (h + (i * (j + (k * (l + (m * (n + (o * (p + q)))))))))))))))) mod 1000007;
+    return a * b * c * d - q;
+end
+end
+
+begin
+    var x, y : integer;
+    var r : real;
+    var k : 7;
+    g := 3;
+    gr := 1.5;
+    x := many();
+    print x;
+    print fib(15);
+    r := mix(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5);
+    print r;
+    y := 0;
+    for x := 1 to 10 do
+    begin
+        y := y + x * g + k;
+        if (y mod 2 = 0) then
+        begin
+            g := g + 1;
+        end
+        else
+        begin
+            gr := gr * 2.0;
+        end
+        end if
+    end
+    end do
+    print y;
+    print g;
+    print gr;
+    read x;
+    print x * 2;
+    while x > 100 do
+    begin
+        x := x - 7;
+        print x;
+    end
+    end do
+end
+end
@@ -0,0 +1,73 @@
+//&S-
+//&T-
+//&D-
+
+constantFolding;
+
+var g : integer;
+
+// prints its argument, so that a call cannot be folded away
+trace(n: integer): integer
+begin
+    print n;
+    return n;
+end
+end
+
+begin
+
+var a : integer;
+var r : real;
+var b : boolean;
+
+g := 5;
+
+// integer arithmetic wraps around at 32 bits
+a := 3 * 4 + g * 1 - 0;
+print a;
+a := 2147483647 + 1;
+print a;
+a := 65536 * 65536 + 7 mod 3 - -(-(9 / 2));
+print a;
+a := (g + 0) * (1 * g) / 1;
+print a;
+
+// x * 0 keeps the call
+a := trace(7) * 0 + 0 * g;
+print a;
+
+// integers are converted to real before mixing with reals
+r := 1 / 3 + 1.0 / 3;
+print r;
+r := -(2.5 * 4) + 16777217;
+print r;
+
+// booleans
+b := not not (g > 3);
+if (b and (16777217 = 16777216.0)) then
+begin
+    print 1;
+end
+else
+begin
+    print 0;
+end
+end if
+if (not (1 < 2) or (3 >= 3 and 2 <> 2)) then
+begin
+    print 10;
+end
+else
+begin
+    print 20;
+end
+end if
+
+while (g > 0 and 1 < 0) do
+begin
+    print g;
+end
+end do
+
+end
+end
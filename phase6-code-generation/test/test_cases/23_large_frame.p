@@ -0,0 +1,57 @@
+//&S-
+//&T-
+//&D-
+
+largeFrame;
+
+// more locals than a fixed 128-byte frame can hold
+spread(n: integer): integer
+begin
+    var v0, v1, v2, v3, v4, v5, v6, v7, v8, v9 : integer;
+    var w0, w1, w2, w3, w4, w5, w6, w7, w8, w9 : integer;
+    var x0, x1, x2, x3, x4, x5, x6, x7, x8, x9 : integer;
+    var y0, y1, y2, y3, y4, y5, y6, y7, y8, y9 : integer;
+    v0 := n; v1 := v0 + 1; v2 := v1 + 1; v3 := v2 + 1; v4 := v3 + 1;
+    v5 := v4 + 1; v6 := v5 + 1; v7 := v6 + 1; v8 := v7 + 1; v9 := v8 + 1;
+    w0 := v9 * 2; w1 := w0 + 1; w2 := w1 + 1; w3 := w2 + 1; w4 := w3 + 1;
+    w5 := w4 + 1; w6 := w5 + 1; w7 := w6 + 1; w8 := w7 + 1; w9 := w8 + 1;
+    x0 := w9 * 2; x1 := x0 + 1; x2 := x1 + 1; x3 := x2 + 1; x4 := x3 + 1;
+    x5 := x4 + 1; x6 := x5 + 1; x7 := x6 + 1; x8 := x7 + 1; x9 := x8 + 1;
+    y0 := x9 * 2; y1 := y0 + 1; y2 := y1 + 1; y3 := y2 + 1; y4 := y3 + 1;
+    y5 := y4 + 1; y6 := y5 + 1; y7 := y6 + 1; y8 := y7 + 1; y9 := y8 + 1;
+    if (n > 0) then
+    begin
+        // the callee's frame must not overlap the locals of this one
+        v0 := spread(n - 1);
+    end
+    end if
+    return v0 + v9 + w0 + w9 + x0 + x9 + y0 + y9;
+end
+end
+
+// a small frame, returning from several places
+sign(n: integer): integer
+begin
+    if (n < 0) then
+    begin
+        return -1;
+    end
+    end if
+    if (n = 0) then
+    begin
+        return 0;
+    end
+    end if
+    return 1;
+end
+end
+
+begin
+
+var a : integer;
+a := spread(3);
+print a;
+print sign(-5) + sign(0) * 10 + sign(7) * 100;
+
+end
+end
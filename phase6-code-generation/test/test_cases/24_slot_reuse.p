@@ -0,0 +1,93 @@
+//&S-
+//&T-
+//&D-
+
+slotReuse;
+
+// the locals of sibling scopes and of consecutive loops share slots
+siblings(n: integer): integer
+begin
+    var total : integer;
+    total := 0;
+    begin
+        var a, b : integer;
+        a := n;
+        b := a * 2;
+        total := total + a + b;
+    end
+    begin
+        var c, d : integer;
+        c := n + 100;
+        d := c * 3;
+        total := total + c + d;
+    end
+    for i := 0 to 3 do
+    begin
+        var e : integer;
+        e := i * 10;
+        total := total + e;
+    end
+    end do
+    for j := 1 to 4 do
+    begin
+        var f : integer;
+        f := j;
+        // the inner loop must not reuse the slots of the outer one
+        for k := 0 to 2 do
+        begin
+            total := total + f * k + j;
+        end
+        end do
+    end
+    end do
+    return total;
+end
+end
+
+// so do the arrays of sibling scopes, below the scalars
+siblingArrays(n: integer): integer
+begin
+    var total : integer;
+    total := 0;
+    begin
+        var a : array 100 of integer;
+        for i := 0 to 100 do
+        begin
+            a[i] := i * n;
+        end
+        end do
+        total := total + a[99];
+    end
+    begin
+        var b : array 100 of integer;
+        for i := 0 to 100 do
+        begin
+            b[i] := i + n;
+        end
+        end do
+        total := total + b[50];
+    end
+    return total;
+end
+end
+
+begin
+
+var r : integer;
+r := siblings(5);
+print r;
+begin
+    var x : integer;
+    x := r + 1;
+    print x;
+end
+begin
+    var y : integer;
+    y := r + 2;
+    print y;
+    print siblings(y);
+end
+print siblingArrays(5);
+
+end
+end
@@ -0,0 +1,45 @@
+//&S-
+//&T-
+//&D-
+
+leafFunction;
+
+// a leaf: nothing is called, so ra never needs to be saved
+square(x: integer): integer
+begin
+    return x * x;
+end
+end
+
+// a leaf whose last arguments are passed on the stack and whose values outnumber the
+// caller-saved registers
+weigh(a, b, c, d, e, f, g, h, i, j: integer): integer
+begin
+    var p, q, r, s, t, u, v, w : integer;
+    p := a * 1 + b * 2;
+    q := c * 3 + d * 4;
+    r := e * 5 + f * 6;
+    s := g * 7 + h * 8;
+    t := i * 9 + j * 10;
+    u := p + q * 2;
+    v := (r - s) + t;
+    w := ((((u * v - p) + q) - r) + s) - t;
+    return (w + a) - j;
+end
+end
+
+// not a leaf: calls both of the above
+combine(n: integer): integer
+begin
+    return square(n) + weigh(n, n + 1, n + 2, n + 3, n + 4, n + 5, n + 6, n + 7, n + 8, n + 9);
+end
+end
+
+begin
+
+print square(12);
+print weigh(1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+print combine(3);
+
+end
+end
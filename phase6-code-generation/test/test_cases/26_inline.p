@@ -0,0 +1,96 @@
+//&S-
+//&T-
+//&D-
+
+inlineCalls;
+
+var counter : integer;
+
+// an accessor, called in a loop
+getCounter(): integer
+begin
+    return counter;
+end
+end
+
+// several returns
+sign(x: integer): integer
+begin
+    if x < 0 then
+    begin
+        return -1;
+    end
+    else
+    begin
+        if x = 0 then
+        begin
+            return 0;
+        end
+        end if
+    end
+    end if
+    return 1;
+end
+end
+
+// a parameter assigned in the callee must not change the argument of the caller
+twice(x: integer): integer
+begin
+    x := x * 2;
+    return x;
+end
+end
+
+// a loop, and calls to the functions above
+bump(n: integer)
+begin
+    var i : integer;
+    i := 0;
+    while i < n do
+    begin
+        counter := counter + sign(i - 1);
+        i := i + 1;
+    end
+    end do
+end
+end
+
+half(r: real): real
+begin
+    return r / 2;
+end
+end
+
+// recursive, never inlined
+fact(n: integer): integer
+begin
+    if n <= 1 then
+    begin
+        return 1;
+    end
+    end if
+    return n * fact(n - 1);
+end
+end
+
+begin
+
+var total, x : integer;
+total := 0;
+counter := 0;
+for i := 1 to 5 do
+begin
+    bump(i);
+    total := total + getCounter();
+end
+end do
+print total;
+print sign(-7) + sign(0) * 10 + sign(7) * 100;
+x := 21;
+print twice(x);
+print x;
+print half(3.0);
+print fact(6);
+
+end
+end
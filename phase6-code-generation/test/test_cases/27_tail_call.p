@@ -0,0 +1,83 @@
+//&S-
+//&T-
+//&D-
+
+tailCall;
+
+// accumulator-style recursion: runs in constant stack space
+sum(n, acc: integer): integer
+begin
+    if n = 0 then
+    begin
+        return acc;
+    end
+    end if
+    return sum(n - 1, acc + n);
+end
+end
+
+// the arguments are swapped parameters
+gcd(a, b: integer): integer
+begin
+    if b = 0 then
+    begin
+        return a;
+    end
+    end if
+    return gcd(b, a mod b);
+end
+end
+
+halve(r: real; times: integer): real
+begin
+    if times = 0 then
+    begin
+        return r;
+    end
+    end if
+    return halve(r / 2, times - 1);
+end
+end
+
+// an integer argument for a real parameter
+toReal(r: real; k: integer): real
+begin
+    if k = 0 then
+    begin
+        return r;
+    end
+    end if
+    return toReal(k, 0);
+end
+end
+
+// a void function calling itself last
+countdown(n: integer)
+begin
+    if n > 0 then
+    begin
+        print n;
+        countdown(n - 1);
+    end
+    end if
+end
+end
+
+// a tail call to another function
+sumTo(n: integer): integer
+begin
+    return sum(n, 0);
+end
+end
+
+begin
+
+print sum(20000, 0);
+print sumTo(100);
+print gcd(1071, 462);
+print halve(12.0, 3);
+print toReal(0.5, 7);
+countdown(3);
+
+end
+end
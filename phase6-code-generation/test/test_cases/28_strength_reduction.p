@@ -0,0 +1,54 @@
+//&S-
+//&T-
+//&D-
+
+strengthReduction;
+
+// multiplication, division and mod by constants, on both signs of the other operand
+mix(x: integer): integer
+begin
+    return (x * 10) + (x / 7) + (x mod 16);
+end
+end
+
+begin
+
+var a, b, big: integer;
+var i, j, sum: integer;
+
+a := 100;
+b := -100;
+big := 2147483647;
+
+print a * 7;
+print b * -3;
+print 9 * a;
+print a * 0;
+print a / 4;
+print b / 4;
+print b / -8;
+print a / 7;
+print b / 7;
+print a / -3;
+print a mod 16;
+print b mod 16;
+print b mod 7;
+print a mod -3;
+print big / 10;
+print big mod 1000;
+print big * 2;
+print mix(a);
+print mix(b);
+
+// x / 3 and x mod 3 across zero
+sum := 0;
+for i := 0 to 42 do
+begin
+    j := i - 20;
+    sum := sum + ((j / 3) * 100) + (j mod 3);
+end
+end do
+print sum;
+
+end
+end
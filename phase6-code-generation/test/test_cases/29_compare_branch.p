@@ -0,0 +1,105 @@
+//&S-
+//&T-
+//&D-
+
+compareBranch;
+
+// how many of 0, 1, 2, 3, 4 satisfy each comparison against 2
+countInts(): integer
+begin
+    var i, lt, le, ne, ge, gt, eq: integer;
+    lt := 0;
+    le := 0;
+    ne := 0;
+    ge := 0;
+    gt := 0;
+    eq := 0;
+    for i := 0 to 5 do
+    begin
+        if i < 2 then begin lt := lt + 1; end end if
+        if i <= 2 then begin le := le + 1; end end if
+        if i <> 2 then begin ne := ne + 1; end end if
+        if i >= 2 then begin ge := ge + 1; end end if
+        if i > 2 then begin gt := gt + 1; end end if
+        if i = 2 then begin eq := eq + 1; end else begin eq := eq + 10; end end if
+    end
+    end do
+    return (lt * 100000) + (le * 10000) + (ne * 1000) + (ge * 100) + (gt * 10) + eq;
+end
+end
+
+// the same with reals, against 1.5 (an integer operand is converted)
+countReals(): integer
+begin
+    var i, lt, le, ne, ge, gt, eq: integer;
+    var x: real;
+    lt := 0;
+    le := 0;
+    ne := 0;
+    ge := 0;
+    gt := 0;
+    eq := 0;
+    for i := 0 to 4 do
+    begin
+        x := i * 0.5;
+        if x < 1.5 then begin lt := lt + 1; end end if
+        if x <= 1.5 then begin le := le + 1; end end if
+        if x <> 1.5 then begin ne := ne + 1; end end if
+        if 1.5 <= x then begin ge := ge + 1; end end if
+        if x > 1 then begin gt := gt + 1; end end if
+        if x = 1.5 then begin eq := eq + 1; end end if
+    end
+    end do
+    return (lt * 100000) + (le * 10000) + (ne * 1000) + (ge * 100) + (gt * 10) + eq;
+end
+end
+
+begin
+
+var n, steps: integer;
+var r: real;
+var done: boolean;
+
+print countInts();
+print countReals();
+
+// while conditions
+n := 0;
+while n < 10 do
+begin
+    n := n + 3;
+end
+end do
+print n;
+
+n := 100;
+steps := 0;
+while n >= 1 do
+begin
+    n := n / 2;
+    steps := steps + 1;
+end
+end do
+print steps;
+
+r := 0.0;
+while r <> 2.0 do
+begin
+    r := r + 0.5;
+end
+end do
+print r;
+
+// a condition that is not a comparison
+done := false;
+n := 0;
+while not done do
+begin
+    n := n + 1;
+    done := n = 4;
+end
+end do
+print n;
+
+end
+end
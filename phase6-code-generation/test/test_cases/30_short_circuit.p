@@ -0,0 +1,101 @@
+//&S-
+//&T-
+//&D-
+
+shortCircuit;
+
+var calls: integer;
+
+// prints its argument and counts the calls, so the skipped operands show
+check(x: integer; result: boolean): boolean
+begin
+    calls := calls + 1;
+    print x;
+    return result;
+end
+end
+
+// prints 1 for true, 0 for false
+show(b: boolean)
+begin
+    if b then
+    begin
+        print 1;
+    end
+    else
+    begin
+        print 0;
+    end
+    end if
+end
+end
+
+begin
+
+var yes, no, b: boolean;
+var i: integer;
+
+yes := true;
+no := false;
+calls := 0;
+
+// condition context: the right operand runs only if the left one does not decide
+if no and check(1, true) then
+begin
+    print 100;
+end
+end if
+if yes or check(2, true) then
+begin
+    print 200;
+end
+end if
+if yes and check(3, false) then
+begin
+    print 300;
+end
+else
+begin
+    print 301;
+end
+end if
+if not (no or check(4, false)) then
+begin
+    print 400;
+end
+end if
+if (no and check(5, true)) or (yes and check(6, true)) then
+begin
+    print 600;
+end
+end if
+if not check(7, false) and not (yes and no) then
+begin
+    print 700;
+end
+end if
+
+// a guarded loop: check(i) is never called with i = 3
+i := 0;
+while (i < 3) and check(i * 10, true) do
+begin
+    i := i + 1;
+end
+end do
+print i;
+
+// value context
+b := no and check(8, true);
+show(b);
+b := yes or check(9, false);
+show(b);
+b := yes and check(10, true);
+show(b);
+b := (no or check(11, false)) or (i = 3);
+show(b);
+show(not (yes and no));
+
+print calls;
+
+end
+end
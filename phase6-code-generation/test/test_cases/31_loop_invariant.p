@@ -0,0 +1,89 @@
+//&S-
+//&T-
+//&D-
+
+loopInvariant;
+
+var scale, total, bumps: integer;
+
+// pure: reads a global, writes nothing
+limit(n: integer): integer
+begin
+    return (n * scale) + 1;
+end
+end
+
+// impure: the loop reading `scale` must see this write
+bump(): integer
+begin
+    bumps := bumps + 1;
+    scale := scale + 1;
+    return bumps;
+end
+end
+
+begin
+
+var i, j, k, n, sum, last: integer;
+
+scale := 3;
+total := 0;
+bumps := 0;
+
+// `scale * 7` and the load of scale move out; total is read and written in the loop
+for i := 0 to 10 do
+begin
+    total := total + (scale * 7) + i;
+end
+end do
+print total;
+
+// nested: (n * n) moves out of both loops, (n * n) + i out of the inner one
+n := 4;
+sum := 0;
+for i := 0 to 3 do
+begin
+    for j := 0 to 5 do
+    begin
+        sum := sum + ((n * n) + i) + j;
+    end
+    end do
+end
+end do
+print sum;
+
+// the bound is computed once: limit() is pure and the loop stores no global
+k := 0;
+while k < limit(5) do
+begin
+    k := k + 2;
+end
+end do
+print k;
+
+// a call that writes scale keeps its load in the loop
+sum := 0;
+for i := 0 to 3 do
+begin
+    sum := sum + scale;
+    last := bump();
+end
+end do
+print sum;
+print last;
+
+// assigned only on some iterations: not moved
+last := -1;
+for i := 0 to 5 do
+begin
+    if i = 3 then
+    begin
+        last := n * 10;
+    end
+    end if
+end
+end do
+print last;
+
+end
+end
@@ -0,0 +1,125 @@
+//&S-
+//&T-
+//&D-
+
+loopCounter;
+
+var calls: integer;
+
+// its own loops clobber s1/s2, which must be restored for the caller's loops
+sumTo(n: integer): integer
+begin
+    var i, s: integer;
+    s := 0;
+    for i := 0 to 100 do
+    begin
+        if i >= n then
+        begin
+            return s;
+        end
+        end if
+        s := s + i;
+    end
+    end do
+    return s;
+end
+end
+
+// recursion inside a loop
+fib(n: integer): integer
+begin
+    var i, a, b, t: integer;
+    if n < 2 then
+    begin
+        return n;
+    end
+    end if
+    a := 0;
+    b := 0;
+    for i := 1 to 3 do
+    begin
+        a := a + fib(n - i);
+    end
+    end do
+    return a;
+end
+end
+
+// a non-self tail call from inside a loop must still restore the counter registers
+viaTail(n: integer): integer
+begin
+    var i: integer;
+    for i := 0 to 3 do
+    begin
+        calls := calls + 1;
+        if i = 2 then
+        begin
+            return sumTo(n + i);
+        end
+        end if
+    end
+    end do
+    return 0;
+end
+end
+
+begin
+
+var i, j, k, count, total: integer;
+
+calls := 0;
+
+// the body never reads i: counted down
+count := 0;
+for i := 3 to 10 do
+begin
+    count := count + 1;
+end
+end do
+print count;
+
+// nested, the inner one reads its variable, the outer one does not
+total := 0;
+for i := 0 to 4 do
+begin
+    for j := 2 to 5 do
+    begin
+        total := total + j;
+    end
+    end do
+end
+end do
+print total;
+
+// counters survive calls
+total := 0;
+for i := 0 to 5 do
+begin
+    for j := 0 to 3 do
+    begin
+        total := total + sumTo(i) + j;
+    end
+    end do
+end
+end do
+print total;
+
+// the loop variable as an argument and in comparisons
+for k := 5 to 8 do
+begin
+    print fib(k);
+end
+end do
+
+total := 0;
+for i := 0 to 4 do
+begin
+    total := total + viaTail(i);
+    total := total * 10;
+end
+end do
+print total;
+print calls;
+
+end
+end
@@ -0,0 +1,74 @@
+//&S-
+//&T-
+//&D-
+
+unroll;
+
+// a return from the middle of an unrolled loop
+firstMultiple(k: integer): integer
+begin
+    var i: integer;
+    for i := 1 to 50 do
+    begin
+        if i mod k = 0 then
+        begin
+            return i;
+        end
+        end if
+    end
+    end do
+    return 0;
+end
+end
+
+begin
+
+var i, j, sum: integer;
+var r: real;
+
+// short: fully unrolled, i is a constant in each copy
+sum := 0;
+for i := 3 to 7 do
+begin
+    sum := sum * 10 + i;
+end
+end do
+print sum;
+
+// long: unrolled by N, with the iterations left over after the loop
+sum := 0;
+for i := 0 to 103 do
+begin
+    sum := sum + i * i;
+end
+end do
+print sum;
+
+// a constant declared in the body, and the loop variable as a real
+r := 0.0;
+for i := 1 to 11 do
+begin
+    var half: 2;
+    r := r + i / half;
+end
+end do
+print r;
+
+// nested
+sum := 0;
+for i := 0 to 3 do
+begin
+    for j := 0 to 9 do
+    begin
+        sum := sum + (i * j) + j;
+    end
+    end do
+end
+end do
+print sum;
+
+print firstMultiple(7);
+print firstMultiple(60);
+
+end
+end
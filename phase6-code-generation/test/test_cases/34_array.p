@@ -0,0 +1,121 @@
+//&S-
+//&T-
+//&D-
+
+arrays;
+
+var hist: array 5 of integer;
+var grid: array 3 of array 4 of real;
+
+// a row of a 2D array is an array of its own
+rowSum(row: array 4 of integer): integer
+begin
+    var i, s: integer;
+    s := 0;
+    for i := 0 to 4 do
+    begin
+        s := s + row[i];
+    end
+    end do
+    return s;
+end
+end
+
+// more than 2 KiB of locals: offsets from s0 and sp no longer fit in 12 bits
+bigFrame(n: integer): integer
+begin
+    var buf: array 600 of integer;
+    var i, s: integer;
+    for i := 0 to 600 do
+    begin
+        buf[i] := i;
+    end
+    end do
+    s := 0;
+    for i := 0 to 600 do
+    begin
+        s := s + buf[i];
+    end
+    end do
+    return s + buf[n];
+end
+end
+
+begin
+
+var a: array 10 of integer;
+var m: array 3 of array 4 of integer;
+var i, j, s: integer;
+
+// indices affine in the loop variable
+for i := 0 to 10 do
+begin
+    a[i] := i * i;
+end
+end do
+s := 0;
+for i := 0 to 10 do
+begin
+    s := s + a[i];
+end
+end do
+print s;
+
+// in a while loop
+s := 0;
+i := 0;
+while i < 5 do
+begin
+    s := s + a[i * 2 + 1];
+    i := i + 1;
+end
+end do
+print s;
+
+// row-major
+for i := 0 to 3 do
+begin
+    for j := 0 to 4 do
+    begin
+        m[i][j] := i * 10 + j;
+    end
+    end do
+end
+end do
+print m[2][3];
+print rowSum(m[1]);
+
+// global arrays, indexed by elements
+for i := 0 to 5 do
+begin
+    hist[i] := 0;
+end
+end do
+for i := 0 to 10 do
+begin
+    hist[a[i] mod 5] := hist[a[i] mod 5] + 1;
+end
+end do
+print hist[0];
+print hist[1];
+print hist[4];
+
+for i := 0 to 3 do
+begin
+    for j := 0 to 4 do
+    begin
+        grid[i][j] := i + j / 2.0;
+    end
+    end do
+end
+end do
+print grid[2][3];
+
+i := 2;
+read a[i + 1];
+print a[3];
+
+print bigFrame(7);
+
+end
+end
@@ -0,0 +1,95 @@
+//&S-
+//&T-
+//&D-
+
+arrayParam;
+
+var g: array 4 of integer;
+
+// writes through the parameter are seen by the caller
+fill(a: array 1000 of integer; n: integer)
+begin
+    var i: integer;
+    for i := 0 to 1000 do
+    begin
+        a[i] := i * n;
+    end
+    end do
+end
+end
+
+sumTo(a: array 1000 of integer; n: integer; acc: integer): integer
+begin
+    if n = 0 then
+    begin
+        return acc;
+    end
+    end if
+    return sumTo(a, n - 1, acc + a[n - 1]);
+end
+end
+
+// a parameter passed on is the same array again
+twice(a: array 1000 of integer): integer
+begin
+    fill(a, 2);
+    return sumTo(a, 10, 0);
+end
+end
+
+setRow(row: array 3 of real; v: real)
+begin
+    row[0] := v;
+    row[2] := v + 1.0;
+end
+end
+
+sumG(a: array 4 of integer; n: integer; acc: integer): integer
+begin
+    if n = 0 then
+    begin
+        return acc;
+    end
+    end if
+    return sumG(a, n - 1, acc + a[n - 1]);
+end
+end
+
+// the array must outlive the call: not a tail call
+local(): integer
+begin
+    var b: array 4 of integer;
+    b[0] := 1;
+    b[1] := 2;
+    b[2] := 3;
+    b[3] := 4;
+    return sumG(b, 4, 0);
+end
+end
+
+begin
+
+var buf: array 1000 of integer;
+var m: array 2 of array 3 of real;
+var i: integer;
+
+fill(buf, 3);
+print buf[999];
+print sumTo(buf, 1000, 0);
+print twice(buf);
+print buf[7];
+
+setRow(m[1], 2.5);
+print m[1][0];
+print m[1][2];
+
+for i := 0 to 4 do
+begin
+    g[i] := i + 10;
+end
+end do
+print sumG(g, 4, 0);
+print local();
+
+end
+end
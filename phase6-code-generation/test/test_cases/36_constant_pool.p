@@ -0,0 +1,38 @@
+//&S-
+//&T-
+//&D-
+
+constantPool;
+
+var greeting: "hello";
+var half: 0.5;
+
+show(s: string; r: real)
+begin
+    print s;
+    print r + 0.5;
+end
+end
+
+begin
+
+var i: integer;
+var sum: real;
+
+// the same literals, used over and over, are emitted once
+print "hello";
+print greeting;
+show("hello", 0.5);
+show("world", half);
+sum := 0.0;
+for i := 1 to 5 do
+begin
+    sum := sum + 0.5;
+    print "world";
+end
+end do
+print sum;
+print half * 2.0;
+
+end
+end
@@ -0,0 +1,52 @@
+//&S-
+//&T-
+//&D-
+
+constants;
+
+var size: 4;
+var scale: -3;
+var ratio: 2.5;
+var title: "constants";
+var debug: false;
+
+area(w: integer): integer
+begin
+    var two: 2;
+    return w * size * two;
+end
+end
+
+begin
+
+var a: array 4 of integer;
+var i: integer;
+var limit: 10;
+var eps: 0.25;
+
+// uses of constants fold like literals
+print size * scale + 1;
+print limit - size;
+print ratio * 2;
+print eps + ratio;
+print title;
+if debug then
+begin
+    print "never";
+end
+else
+begin
+    print "release";
+end
+end if
+
+for i := 0 to 4 do
+begin
+    a[i] := i * size;
+end
+end do
+print a[size - 1];
+print area(size + 1);
+
+end
+end
@@ -0,0 +1,87 @@
+//&S-
+//&T-
+//&D-
+
+deadCode;
+
+var verbose: false;
+
+sign(x: integer): integer
+begin
+    if x < 0 then
+    begin
+        return -1;
+    end
+    else
+    begin
+        return 1;
+    end
+    end if
+    // never reached
+    print 999;
+    return 0;
+end
+end
+
+noisy(): integer
+begin
+    print 7;
+    return 3;
+end
+end
+
+// `unused` is assigned but never read; the call is kept, as it prints
+work(n: integer): integer
+begin
+    var unused, result: integer;
+    unused := n * 100;
+    unused := noisy();
+    result := n + 1;
+    return result;
+    result := 0;
+end
+end
+
+begin
+
+var i, shadow: integer;
+
+print sign(-5);
+print sign(5);
+print work(41);
+
+if verbose then
+begin
+    print 111;
+end
+else
+begin
+    var shadow: integer;
+    shadow := 2;
+    print shadow;
+end
+end if
+
+if not verbose then
+begin
+    print 222;
+end
+end if
+
+while verbose do
+begin
+    print 333;
+end
+end do
+
+shadow := 10;
+i := 0;
+while i < 3 do
+begin
+    i := i + 1;
+end
+end do
+print i + shadow;
+
+end
+end
@@ -0,0 +1,113 @@
+//&S-
+//&T-
+//&D-
+
+registerArgs;
+
+var g: integer;
+
+// a leaf: every parameter stays in its argument register
+mix(a: integer; x: real; b: integer; y: real; s: string; ok: boolean): real
+begin
+    if ok then
+    begin
+        return a * x + b * y;
+    end
+    end if
+    return 0.0;
+end
+end
+
+// a leaf assigning to its parameters
+step(n: integer; r: real): integer
+begin
+    n := n * 2;
+    r := r + n;
+    if r > 10.0 then
+    begin
+        return n;
+    end
+    end if
+    return n + 1;
+end
+end
+
+// ten integers: the last two on the stack
+ten(a: integer; b: integer; c: integer; d: integer; e: integer; f: integer; h: integer; i: integer; j: integer; k: integer): integer
+begin
+    return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f + 7 * h + 8 * i + 9 * j + 10 * k;
+end
+end
+
+// more stack arguments than register ones
+eighteen(a1: integer; a2: integer; a3: integer; a4: integer; a5: integer; a6: integer; a7: integer; a8: integer; a9: integer; a10: integer; a11: integer; a12: integer; a13: integer; a14: integer; a15: integer; a16: integer; a17: integer; a18: integer): integer
+begin
+    return a1 + a2 + a3 + a4 + a5 + a6 + a7 + a8 + a9 + a10 + a11 + a12 + a13 + a14 + a15 + a16 + a17 * a18;
+end
+end
+
+bump(): integer
+begin
+    g := g + 10;
+    return g;
+end
+end
+
+three(a: integer; b: integer; c: integer): integer
+begin
+    return a * 100 + b * 10 + c;
+end
+end
+
+// not a leaf: its parameters are saved, as they must survive the calls
+outer(n: integer; r: real): real
+begin
+    print step(n, r);
+    return mix(n, r, n + 1, 0.5, "unused", true);
+end
+end
+
+// not a leaf, but k is only referenced before the first call and stays in its register
+early(k: integer; n: integer): integer
+begin
+    var t: integer;
+    t := k * 3;
+    if t > 5 then begin k := k + 1; end end if
+    t := t + k;
+    print three(t, n, 1);
+    return t + n;
+end
+end
+
+begin
+
+var x: integer;
+var i: integer;
+var s: integer;
+
+x := 3;
+print mix(x, 1.5, 4, 2, "s", true);
+print mix(1, 2.0, 3, 4.0, "s", false);
+print step(x, 1.0);
+print step(4, 3.0);
+print ten(1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+print eighteen(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18);
+
+// g is read before bump() changes it, x after, as it cannot change
+g := 1;
+print three(g, bump(), g);
+print three(x, bump(), x);
+
+s := 0;
+for i := 0 to 5 do
+begin
+    s := s + three(i, x, bump() - g);
+end
+end do
+print s;
+
+print outer(2, 4.0);
+print early(2, 4);
+
+end
+end
@@ -0,0 +1,67 @@
+//&S-
+//&T-
+//&D-
+
+sethiUllman;
+
+var g: integer;
+
+bump(): integer
+begin
+    g := g + 1;
+    return g;
+end
+end
+
+// the right operand needs more registers: it is evaluated first
+deep(a: integer; b: integer; c: integer; d: integer; e: integer; f: integer; h: integer): integer
+begin
+    return a * b + (c * d + (e * f + h));
+end
+end
+
+// non-commutative operators keep their operands in place
+lopsided(a: integer; b: integer; c: integer; d: integer): integer
+begin
+    return a - ((b * c) - (d / (a + b)));
+end
+end
+
+mixed(x: real; y: real; n: integer): real
+begin
+    return x / ((y * n) + (x * y));
+end
+end
+
+begin
+
+var i: integer;
+var s: integer;
+var arr: array 8 of integer;
+
+print deep(1, 2, 3, 4, 5, 6, 7);
+print lopsided(20, 3, 4, 14);
+print mixed(6.0, 2.0, 3);
+
+for i := 0 to 8 do
+begin
+    arr[i] := i * i;
+end
+end do
+s := 6;
+s := arr[1] + (arr[2] * (arr[3] + arr[s - 5] * arr[7]));
+print s;
+print 100 mod (arr[5] - (arr[2] + (arr[1] * 3)));
+if (arr[1] + arr[2]) < (arr[3] * (arr[4] - (arr[5] - arr[6]))) then
+begin
+    print 1;
+end
+end if
+
+// a call in either operand keeps the left one first
+g := 10;
+print g * 100 + (bump() * (g + 1));
+print (bump() * 10) - (g * (g - (g + 1)));
+
+end
+end
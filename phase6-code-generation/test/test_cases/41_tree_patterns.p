@@ -0,0 +1,176 @@
+//&S-
+//&T-
+//&D-
+
+treePatterns;
+
+var g: integer;
+var flag: boolean;
+
+// each comparison with a constant on either side
+compare(x: integer): integer
+begin
+    var n: integer;
+    n := 0;
+    if x < 10 then
+    begin
+        n := n + 1;
+    end
+    end if
+    if x <= 10 then
+    begin
+        n := n + 2;
+    end
+    end if
+    if x > 10 then
+    begin
+        n := n + 4;
+    end
+    end if
+    if x >= 10 then
+    begin
+        n := n + 8;
+    end
+    end if
+    if x = 10 then
+    begin
+        n := n + 16;
+    end
+    end if
+    if x <> 10 then
+    begin
+        n := n + 32;
+    end
+    end if
+    if 10 < x then
+    begin
+        n := n + 64;
+    end
+    end if
+    if 10 >= x then
+    begin
+        n := n + 128;
+    end
+    end if
+    if x = 0 then
+    begin
+        n := n + 256;
+    end
+    end if
+    if 0 <> x then
+    begin
+        n := n + 512;
+    end
+    end if
+    return n;
+end
+end
+
+// immediates at the edges of 12 bits, and past them
+edges(x: integer): integer
+begin
+    var n: integer;
+    n := 0;
+    if x < 2047 then
+    begin
+        n := n + 1;
+    end
+    end if
+    if x <= 2047 then
+    begin
+        n := n + 2;
+    end
+    end if
+    if x > -2048 then
+    begin
+        n := n + 4;
+    end
+    end if
+    if x >= -2048 then
+    begin
+        n := n + 8;
+    end
+    end if
+    if x < 2048 then
+    begin
+        n := n + 16;
+    end
+    end if
+    if x = 4096 then
+    begin
+        n := n + 32;
+    end
+    end if
+    return n;
+end
+end
+
+show(c: boolean)
+begin
+    if c then
+    begin
+        print 1;
+    end
+    else
+    begin
+        print 0;
+    end
+    end if
+end
+end
+
+begin
+
+var x: integer;
+var b: boolean;
+
+x := 7;
+print x + 5;
+print x - 3;
+print 5 + x;
+print 0 - x;
+print x + 2047;
+print x - 2048;
+print x + 2048;
+print x - 2049;
+
+print compare(3);
+print compare(10);
+print compare(17);
+print compare(0);
+print edges(2046);
+print edges(2047);
+print edges(2048);
+print edges(-2048);
+print edges(-2049);
+print edges(4096);
+
+b := x > 5;
+show(b and true);
+show(true and b);
+show(b or false);
+show(false or b);
+show(b and false);
+show(x < 10 and b);
+
+// comparisons as values rather than branches
+show(x < 8);
+show(x <= 6);
+show(x > 6);
+show(x >= 8);
+show(7 < x);
+show(7 >= x);
+show(x = 7);
+show(x <> 0);
+show(x < 2048);
+
+g := 40;
+flag := g = 40;
+print g + 2;
+show(flag);
+g := g - 50;
+print g;
+show(g < 0);
+
+end
+end
@@ -0,0 +1,94 @@
+//&S-
+//&T-
+//&D-
+
+valueNumbering;
+
+var g: integer;
+var arr: array 4 of integer;
+
+touch(): integer
+begin
+    g := g + 1;
+    arr[1] := arr[1] * 2;
+    return 0;
+end
+end
+
+twice(x: integer): integer
+begin
+    return x + x;
+end
+end
+
+// the same subterms, within an expression and across blocks it dominates
+crunch(a: integer; b: integer): integer
+begin
+    var s: integer;
+    var i: integer;
+    s := (a + b) * (a + b) + (a mod 7) * (b mod 7);
+    if (b + a) > 10 then
+    begin
+        s := s + (a mod 7) + (a + b);
+    end
+    end if
+    i := 0;
+    while i < 3 do
+    begin
+        s := s + (a * b) - (b * a);
+        s := s + (a * b);
+        i := i + 1;
+    end
+    end do
+    return s;
+end
+end
+
+// a variable assigned in between is a new value
+reassigned(a: integer; b: integer): integer
+begin
+    var c: integer;
+    var d: integer;
+    c := a * b;
+    a := a + 1;
+    d := a * b;
+    return c * 1000 + d;
+end
+end
+
+mixed(x: real; y: real): real
+begin
+    return (x * y) + (y * x) / (x * y);
+end
+end
+
+begin
+
+var n: integer;
+var m: integer;
+
+print crunch(3, 9);
+print crunch(1, 2);
+print reassigned(4, 5);
+print mixed(2.0, 3.0);
+
+// a global and an array element, read again after a call and a store
+g := 5;
+arr[1] := 3;
+n := (g + arr[1]) * 10;
+m := touch();
+n := n + (g + arr[1]);
+print n;
+arr[2] := arr[1];
+arr[1] := 40;
+print arr[1] + arr[2] + (g + arr[1]);
+print twice(g) + twice(g);
+
+// read overwrites what was read
+read n;
+m := n * 2;
+read n;
+print m + n * 2;
+
+end
+end
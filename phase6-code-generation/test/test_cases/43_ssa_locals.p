@@ -0,0 +1,138 @@
+//&S-
+//&T-
+//&D-
+
+ssaLocals;
+
+// values swapped around a loop: the copies into the loop header happen at once
+rotate(n: integer): integer
+begin
+    var a: integer;
+    var b: integer;
+    var c: integer;
+    var t: integer;
+    var i: integer;
+    a := 1;
+    b := 2;
+    c := 3;
+    i := 0;
+    while i < n do
+    begin
+        t := a;
+        a := b;
+        b := c;
+        c := t;
+        i := i + 1;
+    end
+    end do
+    return a * 100 + b * 10 + c;
+end
+end
+
+// one variable holding unrelated values, and assigned in only one arm
+reuse(n: integer): integer
+begin
+    var t: integer;
+    var s: integer;
+    t := n * n;
+    s := t;
+    t := n + 7;
+    if t > 10 then
+    begin
+        t := t * 2;
+    end
+    end if
+    if n mod 2 = 0 then
+    begin
+        s := s + 1000;
+    end
+    else
+    begin
+        s := s - 1000;
+    end
+    end if
+    return s + t;
+end
+end
+
+// accumulators of nested loops, with a real and a boolean
+nested(n: integer): real
+begin
+    var i: integer;
+    var j: integer;
+    var total: integer;
+    var scale: real;
+    var odd: boolean;
+    total := 0;
+    scale := 1.0;
+    odd := false;
+    i := 0;
+    while i < n do
+    begin
+        j := i;
+        while j < n do
+        begin
+            total := total + j;
+            j := j + 1;
+        end
+        end do
+        scale := scale * 1.5;
+        odd := not odd;
+        i := i + 1;
+    end
+    end do
+    if odd then
+    begin
+        return total + scale;
+    end
+    end if
+    return total - scale;
+end
+end
+
+// tail recursion turned into a loop over its parameters
+gcd(a: integer; b: integer): integer
+begin
+    var r: integer;
+    if b = 0 then
+    begin
+        return a;
+    end
+    end if
+    r := a mod b;
+    return gcd(b, r);
+end
+end
+
+begin
+
+var k: integer;
+var sum: integer;
+
+print rotate(0);
+print rotate(1);
+print rotate(2);
+print rotate(7);
+print reuse(3);
+print reuse(4);
+print reuse(2);
+print nested(3);
+print nested(4);
+print gcd(1071, 462);
+
+sum := 0;
+k := 10;
+while k > 0 do
+begin
+    if k mod 3 = 0 then
+    begin
+        sum := sum + k;
+    end
+    end if
+    k := k - 1;
+end
+end do
+print sum;
+
+end
+end
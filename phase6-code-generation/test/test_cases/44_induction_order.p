@@ -0,0 +1,57 @@
+//&S-
+//&T-
+//&D-
+
+inductionOrder;
+
+begin
+
+var b: array 8 of integer;
+var i, k, x: integer;
+
+// a value derived from the loop variable before it is stepped keeps the old value
+i := 0;
+while i < 4 do
+begin
+    x := i * 4;
+    i := i + 1;
+    print x + 100;
+end
+end do
+
+// stepped in a branch between the two
+i := 0;
+while i < 6 do
+begin
+    x := i * 3;
+    if i mod 2 = 0 then begin i := i + 1; end end if
+    i := i + 1;
+    print x + 7;
+end
+end do
+
+// stepped after the use
+i := 0;
+while i < 3 do
+begin
+    x := i * 5;
+    print x + 1;
+    i := i + 1;
+end
+end do
+
+// an index computed before the step
+i := 0;
+while i < 4 do
+begin
+    k := i * 2;
+    i := i + 1;
+    b[k] := i;
+end
+end do
+print b[0];
+print b[2];
+print b[6];
+
+end
+end